@@ -0,0 +1,219 @@
+/*
+thready - A lightweight and fast scheduling simulator
+Written in 2019 by Robert Schmidt <rschmidt@uni-bremen.de>
+To the extent possible under law, the author(s) have dedicated all copyright and
+related and neighboring rights to this software to the public domain worldwide.
+This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with
+this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+/**
+ * @file bench.h
+ * @author Robert Schmidt
+ * @brief Defines interface to the benchmark harness of @c thready-bench.
+ *
+ * @remark A workload is a task system simulated up to a breaktime with fixed
+ * scheduler options. It is simulated repeatedly from the same seed, so every
+ * repetition processes the same events, and only @c eventloop_run is timed
+ * by the monotonic clock. Warmup repetitions fill the job pool and caches and
+ * are not recorded.
+ *
+ * Results of two builds or commits are compared per workload by the
+ * Mann-Whitney U test on the time per event of the repetitions, which needs
+ * no assumption about the distribution of the timings and is insensitive to
+ * single outliers, e.g. from preemption.
+ *
+ * Alternatively the retired user space instructions of a workload are
+ * counted by the hardware performance counter (Linux @c perf_event_open, like
+ * @c perf @c stat @c -e @c instructions), per event of @c eventloop_run, per
+ * job of @c jobgen_rise and per insert and pop of the scheduler queue. Other
+ * than timings, these counts repeat exactly for a given build, so a change of
+ * the hot path shows up beyond a small tolerance without repetitions.
+ */
+
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "jobgen.h"
+#include "jobq.h"
+#include "ts.h"
+
+#define BENCH_NAMELEN 32
+
+/**
+ * @brief Named simulation measured by the harness.
+ */
+typedef struct {
+        char const* name;
+        char const* tasksystem; /**< JSON file relative to the repository */
+        JOB_INT breaktime;
+        JOB_INT speed;
+        jobq_kind readyq;
+        jobgen_queue arrivalq;
+        jobgen_rng rng;
+} bench_workload;
+
+/**
+ * @brief Retired instructions of the components of a workload.
+ *
+ * The count of @c eventloop_run includes the jobs it generates and queues.
+ */
+typedef struct {
+        double eventloop; /**< Per event of @c eventloop_run */
+        double jobgen;    /**< Per job of @c jobgen_rise */
+        double jobq;      /**< Per insert and pop of the scheduler queue */
+} bench_instructions;
+
+/**
+ * @brief Timings of the repetitions of a workload, or its instructions.
+ */
+typedef struct {
+        char name[BENCH_NAMELEN];
+        int64_t events;   /**< Events of each repetition */
+        int64_t jobsdone; /**< Jobs finished in each repetition */
+        int n;            /**< Number of repetitions */
+        double* nspe;     /**< Nanoseconds per event of each repetition */
+        bool counted;     /**< Whether @c instructions are set */
+        bench_instructions instructions;
+} bench_result;
+
+/**
+ * @brief Summary statistics of a @c bench_result.
+ */
+typedef struct {
+        double median;         /**< Nanoseconds per event */
+        double p95;            /**< Nanoseconds per event */
+        double events_per_sec; /**< Median */
+        double jobs_per_sec;   /**< Median */
+} bench_summary;
+
+/**
+ * @brief Comparison of a workload between baseline and current results.
+ */
+typedef struct {
+        double change; /**< Relative change of the median time per event */
+        double p;      /**< Two sided p-value of the Mann-Whitney U test */
+} bench_comparison;
+
+/**
+ * @brief Built-in workloads, terminated by an entry without name.
+ */
+extern bench_workload const bench_workloads[];
+
+/**
+ * @brief Built-in workload named @p name or NULL.
+ */
+bench_workload const* bench_find(char const* name);
+
+/**
+ * @brief Simulate @p w on @p tsy @p warmup times, then @p reps times timed.
+ *
+ * @param tsy Task system read from @c w->tasksystem
+ * @param w Workload
+ * @param seed Random seed of every repetition
+ * @param breaktime Breaktime overriding the one of @p w if positive
+ * @param warmup Number of repetitions not recorded
+ * @param reps Number of recorded repetitions, at least one
+ * @param r Result, released by @c bench_result_free
+ */
+void bench_run(ts const* const tsy,
+               bench_workload const* const w,
+               uint32_t const seed,
+               JOB_INT const breaktime,
+               int const warmup,
+               int const reps,
+               bench_result* const r);
+
+/**
+ * @brief Whether this thread can count its retired instructions.
+ */
+bool bench_counter_available(void);
+
+/**
+ * @brief Count the instructions of @p w on @p tsy after one warmup run.
+ *
+ * Generates and queues as many jobs as the simulation finishes, queueing them
+ * by deadline in a scheduler queue of @c w->readyq holding one job per task.
+ * Without counter the workload runs all the same.
+ *
+ * @param tsy Task system read from @c w->tasksystem
+ * @param w Workload
+ * @param seed Random seed
+ * @param breaktime Breaktime overriding the one of @p w if positive
+ * @param r Result without timings
+ * @return Whether the instructions were counted
+ */
+bool bench_count(ts const* const tsy,
+                 bench_workload const* const w,
+                 uint32_t const seed,
+                 JOB_INT const breaktime,
+                 bench_result* const r);
+
+/**
+ * @brief Release the timings of @p r.
+ */
+void bench_result_free(bench_result* const r);
+
+/**
+ * @brief Quantile @p q in [0, 1] of @p n values, interpolating linearly
+ * between the closest ranks.
+ */
+double bench_quantile(double const* const values, int const n, double const q);
+
+/**
+ * @brief Median and 95th percentile of the time per event of @p r and the
+ * median rates.
+ */
+bench_summary bench_summarize(bench_result const* const r);
+
+/**
+ * @brief Two sided p-value of the Mann-Whitney U test whether values @p a
+ * and @p b are drawn from the same distribution.
+ *
+ * Uses the normal approximation with tie and continuity correction, which is
+ * close to the exact distribution from about eight values per sample.
+ */
+double bench_mannwhitney(double const* const a,
+                         int const na,
+                         double const* const b,
+                         int const nb);
+
+/**
+ * @brief Compare current result @p r to baseline result @p base.
+ */
+bench_comparison bench_compare(bench_result const* const base,
+                               bench_result const* const r);
+
+/**
+ * @brief Write @p n results and their summaries as JSON to @p stream, the
+ * timings of results with repetitions and the instructions of counted ones.
+ */
+void bench_write_json(FILE* stream,
+                      bench_result const* const r,
+                      int const n,
+                      uint32_t const seed,
+                      int const warmup);
+
+/**
+ * @brief Read results written by @c bench_write_json from @p stream.
+ *
+ * @param stream JSON results
+ * @param r Set to an array of results, released by @c bench_result_free for
+ * each result and @c free
+ * @return Number of results
+ */
+int bench_read_json(FILE* stream, bench_result** r);
+
+/**
+ * @brief Seconds of the monotonic clock, for timing by @c thready-bench and
+ * the microbenchmarks.
+ */
+double bench_seconds(void);
+
+/**
+ * @brief Zeroed array of @p n elements of @p size bytes, exits if out of
+ * memory.
+ */
+void* bench_calloc(size_t const n, size_t const size);
@@ -18,66 +18,173 @@ this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
  */
 
 #pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
-#include "json.h"
 
 #ifndef DUMP_BUFLEN
 #define DUMP_BUFLEN 128
 #endif
 
+#ifndef DUMP_READLEN
+#define DUMP_READLEN 65536
+#endif
+
+#ifndef DUMP_KEYLEN
+#define DUMP_KEYLEN 32
+#endif
+
 /**
- * @brief Append two arrays in new buffer.
- *
- * Both array @p a and @p b are copied to a new allocated buffer.
- *
- * @return Handle to new buffer.
+ * @brief First bytes of a binary checkpoint, including the terminating zero.
+ */
+#define DUMP_MAGIC "THREADY"
+
+/**
+ * @brief Version of the binary checkpoint layout.
  */
-void** merge(void** a, void** b, int na, int nb);
+#define DUMP_VERSION 1
 
 /**
- * @brief Returns number of unique elements copied from @p src to @p dst.
+ * @brief Written in host byte order to detect checkpoints of other hosts.
+ */
+#define DUMP_BYTEORDER 0x01020304u
+
+/**
+ * @brief Header of a binary checkpoint.
  *
- * @p dst and @p src are both arrays of same length @p n.
+ * The header is followed by one @c dump_task per task in order of position
+ * and one @c dump_job per job: first the @c nready jobs of the scheduler queue
+ * in order of priority, then the next job if @c next is set, and last the
+ * @c npending jobs of the job generator in order of arrival. All records are
+ * fixed width and naturally aligned, so that they can be read in place.
+ */
+typedef struct {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteorder;
+        uint64_t tshash; /**< @c ts_hash of the task system */
+        int64_t now;
+        int64_t events;
+        int64_t jobsdone;
+        uint64_t pcg[2]; /**< State of the shared random number generator */
+        uint64_t ntasks;
+        uint64_t nready;
+        uint64_t npending;
+        uint32_t seed;
+        uint8_t rng; /**< Random stream mode of the job generator */
+        uint8_t next;
+        uint8_t overrun;
+        uint8_t reserved;
+} dump_header;
+
+/**
+ * @brief Job generator state of a task in a binary checkpoint.
+ */
+typedef struct {
+        int64_t simtime;
+        uint64_t jobcount;
+} dump_task;
+
+/**
+ * @brief Job in a binary checkpoint.
+ */
+typedef struct {
+        int64_t starttime;
+        int64_t overruntime;
+        int64_t deadline;
+        int64_t computation;
+        int32_t taskpos;
+        uint32_t reserved;
+} dump_job;
+
+#ifndef DUMP_MAXDEPTH
+#define DUMP_MAXDEPTH 64
+#endif
+
+/**
+ * @brief Token expected next by a @c dump_reader.
+ */
+typedef enum {
+        DUMP_EXPECT_VALUE = 0, /**< Document, after colon, or comma in array */
+        DUMP_EXPECT_FIRST,     /**< Value or end of array */
+        DUMP_EXPECT_KEY,       /**< Key after comma in object */
+        DUMP_EXPECT_FIRSTKEY,  /**< Key or end of object */
+        DUMP_EXPECT_COLON,
+        DUMP_EXPECT_NEXT, /**< Comma or end of array or object after value */
+        DUMP_EXPECT_END   /**< Nothing after the document */
+} dump_expect;
+
+/**
+ * @brief Streaming reader of the numbers of a JSON document.
  *
- * @warning If memory allocation fails, function returns zero!
+ * The input is mapped to memory, or read to a single buffer if the stream
+ * can not be mapped. Numbers are converted from a scratch buffer without
+ * further allocation. The structure of the document is checked on the way,
+ * up to a nesting depth of @c DUMP_MAXDEPTH.
+ */
+typedef struct {
+        char const* begin;
+        char const* pos;
+        char const* end;
+        void* map;
+        size_t maplen;
+        char* buf;
+        int depth;
+        uint64_t objects; /**< Bit per depth, set if inside an object */
+        dump_expect expect;
+        bool memory;
+        char const* error; /**< First error of a reader of memory */
+        char key[DUMP_KEYLEN];
+        char scratch[DUMP_BUFLEN];
+} dump_reader;
+
+/**
+ * @brief Start reading JSON from the current position of @p stream.
  *
- * @return Number of unique elements
+ * Exits on malformed input.
  */
-int uniq(void* const* const src, void** dst, int n);
+void dump_reader_init(dump_reader* r, FILE* stream);
 
 /**
- * @brief Initialize dump of JSON to stream.
- * @see json.h from libjson
+ * @brief Start reading JSON from the @p len bytes at @p data.
+ *
+ * @p data is neither copied nor modified. Instead of exiting on malformed
+ * input the reader keeps the first error and ends the input.
+ *
+ * @see dump_reader_error
  */
-json_printer* dump_json_tostream_init(FILE* stream);
+void dump_reader_init_mem(dump_reader* r, char const* data, size_t len);
 
 /**
- * @brief Free buffers used during dump.
- * @see json.h from libjson
+ * @brief Release the input of the reader.
  */
-void dump_json_tostream_free(json_printer* p);
+void dump_reader_free(dump_reader* r);
 
 /**
- * @brief Actual dump.
- * @see json.h from libjson
+ * @brief Read the next number as integer.
+ *
+ * Fails if the next number is floating point.
+ *
+ * @return False at the end of input.
  */
-void dump_json_tostream(json_printer* p, int64_t const data);
+bool dump_reader_int(dump_reader* r, intmax_t* val);
 
-/* Ease reading of integers from JSON */
 /**
- * @brief Initialize read of JSON simulator state dump to buffer.
- * @see json.h from libjson
+ * @brief Read the next number as float.
+ *
+ * @return False at the end of input.
  */
-json_parser* dump_read_json_init(void* cb_data);
+bool dump_reader_float(dump_reader* r, float* val);
 
 /**
- * @brief Actual reading and parsing of JSON simulator state dump.
- * @see json.h from libjson
+ * @brief Key of the top level object the last number was read from.
+ *
+ * Empty if no key was read yet.
  */
-void dump_read_json_parse(json_parser* p, FILE* stream);
+char const* dump_reader_key(dump_reader const* r);
 
 /**
- * @brief Free buffers used during read.
- * @see json.h from libjson
+ * @brief First error of a reader of memory, NULL if there is none.
  */
-void dump_read_json_free(json_parser* p);
+char const* dump_reader_error(dump_reader const* r);
@@ -19,6 +19,7 @@ this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
 #include <stdint.h>
 #include "job.h"
 #include "jobgen.h"
+#include "jobq.h"
 
 #ifndef EVL_INT
 #define EVL_INT int64_t
@@ -46,15 +47,21 @@ typedef enum {
  * If @p allow_first_overrun is true, the eventloop does not break on the first
  * overrun and continues execution until a break condition is true.
  *
+ * The scheduler queue holding the released jobs ordered by deadline is of
+ * kind @p readyq. A @c JOBQ_PERTASK queue does not slow down with the number of
+ * pending jobs, which pays off in overloaded simulations.
+ *
  * @see eventloop_read_json
  * @param init If true, set simulation time to zero and fetch first job from
  * generator.
  * @param allow_first_overrun If true, ignore first overrun and do not break.
+ * @param readyq Kind of the scheduler queue.
  * @return Handle to @c eventloop.
  */
 eventloop* eventloop_init(jobgen* const jg,
                           bool init,
-                          bool allow_first_overrun);
+                          bool allow_first_overrun,
+                          jobq_kind readyq);
 
 /**
  * @brief Free memory of eventloop state.
@@ -66,6 +73,28 @@ void eventloop_free(eventloop* evl);
  */
 EVL_INT eventloop_get_now(eventloop* evl);
 
+/**
+ * @brief Get number of simulated events.
+ */
+EVL_INT eventloop_get_events(eventloop const* const evl);
+
+/**
+ * @brief Get number of finished jobs.
+ */
+JOB_INT eventloop_get_jobsdone(eventloop const* const evl);
+
+/**
+ * @brief Get greatest number of released jobs in the scheduler queue at once,
+ * the backlog of an overloaded processor.
+ */
+size_t eventloop_get_maxready(eventloop const* const evl);
+
+/**
+ * @brief Suppress the notice on stdout about the first overrun tolerated by
+ * @c allow_first_overrun.
+ */
+void eventloop_set_quiet(eventloop* evl, bool quiet);
+
 /**
  * @brief Run eventloop until breaktime.
  *
@@ -213,17 +242,55 @@ void eventloop_print_result(eventloop const* const evl,
 
 /**
  * @brief Dump state of eventloop to JSON file.
+ *
+ * Besides time and jobs, the dump holds counters and the job generator state
+ * required to resume the simulation exactly.
  */
 void eventloop_dump(eventloop const* const evl, FILE* stream);
 
 /**
- * @brief Replaces some generator and scheduler state read in from JSON.
+ * @brief Replaces generator and scheduler state read in from JSON.
  *
- * @p evl needs to be a eventloop initialized with @c init false.
+ * @p evl needs to be a eventloop initialized with @c init false, using a job
+ * generator of the random stream mode of the dumped simulation. The resumed
+ * simulation continues exactly like the dumped one. Compared to a simulation
+ * run without the dump, it differs only in the events if dumped while a job
+ * executed: stopping there counted the preemption of that job as one event
+ * more. Time, jobs done and random streams match. Dumps without generator
+ * state of earlier versions are restored partially, with the random duration
+ * between two jobs of a task set to zero.
  *
  * @see eventloop_init
  * @param evl Handle to eventloop.
  * @param stream File pointer to state dump in JSON format.
- * @return Updated eventloop with partialy restored state.
+ * @return Updated eventloop with restored state.
  */
 void eventloop_read_json(eventloop* evl, FILE* stream);
+
+/**
+ * @brief Write state of eventloop as binary checkpoint.
+ *
+ * Holds the same state as @c eventloop_dump in fixed width records, see
+ * @c dump_header. The checkpoint is assembled in memory and written at once.
+ */
+void eventloop_dump_bin(eventloop const* const evl, FILE* stream);
+
+/**
+ * @brief Restore state of eventloop from binary checkpoint.
+ *
+ * The checkpoint of @p stream is mapped to memory and its queues are rebuilt
+ * in linear time. Exits if the checkpoint belongs to another task system or
+ * random stream mode, as with @c eventloop_read_json. A checkpoint written
+ * while a job executed likewise resumes with one event more than a simulation
+ * run without it.
+ *
+ * @param evl Handle to eventloop initialized with @c init false.
+ * @param stream File pointer to checkpoint written by @c eventloop_dump_bin.
+ */
+void eventloop_read_bin(eventloop* evl, FILE* stream);
+
+/**
+ * @brief Restore state of eventloop from binary checkpoint or JSON state dump,
+ * whichever @p stream holds.
+ */
+void eventloop_read(eventloop* evl, FILE* stream);
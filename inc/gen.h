@@ -0,0 +1,109 @@
+/*
+thready - A lightweight and fast scheduling simulator
+Written in 2019 by Robert Schmidt <rschmidt@uni-bremen.de>
+To the extent possible under law, the author(s) have dedicated all copyright and
+related and neighboring rights to this software to the public domain worldwide.
+This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with
+this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+/**
+ * @file gen.h
+ * @author Robert Schmidt
+ * @brief Defines interface to the synthetic task system generator of
+ * @c thready-gen.
+ *
+ * @remark The utilizations of the tasks are drawn uniformly among all vectors
+ * of per task utilizations in [0, 1] with the target sum, either by UUniFast
+ * (Bini and Buttazzo, "Measuring the performance of schedulability tests",
+ * Real-Time Systems 30, 2005), discarding vectors with a task above one, or by
+ * RandFixedSum (Emberson, Stafford and Davis, "Techniques for the synthesis of
+ * multiprocessor tasksets", WATERS 2010), which needs no retries for any sum.
+ *
+ * The budget of a task, the upper bound of its first computation segment, is
+ * its utilization times its period. High criticality tasks overrun with a
+ * given probability into the second segment, which lies above the budget.
+ */
+
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "rnd.h"
+#include "task.h"
+
+/**
+ * @brief Method drawing the utilizations of the tasks.
+ */
+typedef enum {
+        GEN_UUNIFAST = 0, /**< UUniFast, discarding tasks above one */
+        GEN_RANDFIXEDSUM  /**< RandFixedSum */
+} gen_method;
+
+/**
+ * @brief Distribution of the periods.
+ */
+typedef enum {
+        GEN_LOGUNIFORM = 0, /**< Log-uniform between minimum and maximum */
+        GEN_HARMONIC        /**< Minimum times a power of two up to maximum */
+} gen_periods;
+
+/**
+ * @brief Parameters of a synthetic task system.
+ */
+typedef struct {
+        int n;              /**< Number of tasks */
+        double utilization; /**< Sum of the utilizations, at most @c n */
+        gen_method method;
+        gen_periods periods;
+        TASK_INT pmin;      /**< Least period */
+        TASK_INT pmax;      /**< Greatest period */
+        double dmin;        /**< Least relative deadline over period */
+        double dmax;        /**< Greatest relative deadline over period */
+        double cratio;      /**< Least computation over budget, in (0, 1] */
+        double hifraction;  /**< Fraction of high criticality tasks */
+        double hifactor;    /**< Greatest overrun computation over budget */
+        float hiprob;       /**< Overrun probability of high criticality */
+        float beta;         /**< Interarrival parameter of all tasks */
+        uint32_t seed;
+} gen_config;
+
+/**
+ * @brief Set the defaults of @c thready-gen: ten tasks of utilization 0.5
+ * drawn by UUniFast, log-uniform periods between 10 and 10000, implicit
+ * deadlines, constant computation times, no high criticality tasks and no
+ * interarrival times.
+ */
+void gen_config_default(gen_config* c);
+
+/**
+ * @brief Check @p c, returns a description of the first invalid parameter or
+ * NULL.
+ */
+char const* gen_check(gen_config const* const c);
+
+/**
+ * @brief Draw @p n utilizations in [0, 1] summing up to @p sum into @p u.
+ *
+ * @return False if UUniFast failed to draw utilizations of at most one
+ * within a bounded number of attempts
+ */
+bool gen_utilizations(rnd_pcg_t* const pcg,
+                      gen_method const method,
+                      int const n,
+                      double const sum,
+                      double* const u);
+
+/**
+ * @brief Write the task system of @p c to @p stream in the format of
+ * @c ts_read_json, ids from zero.
+ *
+ * Budgets are rounded to whole time units of at least one, so the written
+ * utilization deviates from the target when budgets are only a few time
+ * units long.
+ *
+ * @return Sum of the budgets over the periods of the written task system, or
+ * a negative number if the utilizations could not be drawn
+ */
+double gen_write_json(gen_config const* const c, FILE* stream);
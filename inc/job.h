@@ -14,6 +14,10 @@ this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
  * @brief Defines interface to jobs.
  *
  * @remark In the implemented sporadic task model, jobs are released by tasks.
+ *
+ * @remark Jobs are allocated from a pool of large (huge page backed if
+ * available) chunks and recycled on free. Compile with @c -DJOB_MALLOC to
+ * allocate every job with @c calloc instead.
  */
 
 #pragma once
@@ -23,6 +27,10 @@ this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
 #define JOB_INT int64_t
 #endif
 
+#ifndef JOB_POOL_CHUNKSIZE
+#define JOB_POOL_CHUNKSIZE (2 * 1024 * 1024)
+#endif
+
 typedef struct job job;
 
 /**
@@ -57,7 +65,28 @@ job* job_init(JOB_INT const taskid,
  */
 void job_free(job* const j);
 
+/**
+ * @brief Return all memory of the job pool of the calling thread to the
+ * system.
+ *
+ * Jobs are pooled per thread, and have to be freed by the thread which
+ * initialized them.
+ *
+ * @warning Invalidates every job of the thread which has not been freed yet,
+ * call on shutdown of the thread only.
+ */
+void job_pool_free(void);
+
 JOB_INT job_get_taskid(job* const j);
+
+/**
+ * @brief Position of the task of job @p j in its task system or -1 if unknown.
+ *
+ * @remark Allows to look up the task without searching by task id.
+ */
+int job_get_taskpos(job* const j);
+void job_set_taskpos(job* const j, int taskpos);
+
 JOB_INT job_get_starttime(job* const j);
 JOB_INT job_get_overruntime(job* const j);
 JOB_INT job_get_deadline(job* const j);
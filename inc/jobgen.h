@@ -18,10 +18,46 @@ this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
 #include <stdbool.h>
 #include "job.h"
 #include "jobq.h"
+#include "out.h"
+#include "trace.h"
 #include "ts.h"
 
 typedef struct jobgen jobgen;
 
+/**
+ * @brief Data structures ordering the pending jobs by arrival.
+ */
+typedef enum {
+        JOBGEN_ARRAY = 0, /**< Array of next arrivals, one slot per task */
+        JOBGEN_HEAP,      /**< Job queue of kind @c JOBQ_HEAP */
+        JOBGEN_CALENDAR   /**< Job queue of kind @c JOBQ_CALENDAR */
+} jobgen_queue;
+
+/**
+ * @brief Sources of the random numbers of the generated jobs.
+ */
+typedef enum {
+        JOBGEN_RNG_SHARED = 0, /**< One stream drawn in order of job creation */
+        JOBGEN_RNG_BATCH,      /**< One stream per task drawn in blocks */
+        JOBGEN_RNG_COUNTER     /**< Counter based, by seed, task and job */
+} jobgen_rng;
+
+/**
+ * @brief Number of jobs per task for which @c JOBGEN_RNG_BATCH draws the
+ * random numbers at once.
+ */
+#ifndef JOBGEN_BATCH
+#define JOBGEN_BATCH 16
+#endif
+
+/**
+ * @brief Largest number of tasks for which @c JOBGEN_ARRAY scans the array
+ * instead of maintaining a tournament tree over it.
+ */
+#ifndef JOBGEN_SCAN_MAX
+#define JOBGEN_SCAN_MAX 64
+#endif
+
 /**
  * @brief Allocate and optionaly initialize memory for a job generator.
  *
@@ -29,14 +65,29 @@ typedef struct jobgen jobgen;
  * consumption by the scheduler (eventloop). It is possible to skip
  * initialization which is needed to resume from a state dump of a former
  * simulation. To simulate different random job traces the @p seed can be
- * changed.
+ * changed. The choice of @p queue does not change the generated jobs.
+ *
+ * With @c JOBGEN_RNG_SHARED all tasks draw from one random stream, so the jobs
+ * of a task depend on the jobs of all other tasks. With @c JOBGEN_RNG_BATCH
+ * each task draws from its own stream derived from @p seed and its task id,
+ * which makes the jobs of a task reproducible on their own and allows to draw
+ * the random numbers of @c JOBGEN_BATCH jobs by vectorized kernels.
+ * @c JOBGEN_RNG_COUNTER draws the same way, but from a counter based generator
+ * (Philox), so the random numbers of each job are a pure function of
+ * @p seed, task id and the number of the job within its task.
  *
  * @param tasksystem System of tasks for which jobs should be generated
  * @param seed Random seed for the job generation
  * @param refill Boolean triggering initialization
+ * @param queue Data structure holding the pending jobs
+ * @param rng Source of random numbers
  * @returns Handle to job generator
  */
-jobgen* jobgen_init(ts const* const tasksystem, uint32_t seed, bool refill);
+jobgen* jobgen_init(ts const* const tasksystem,
+                    uint32_t seed,
+                    bool refill,
+                    jobgen_queue queue,
+                    jobgen_rng rng);
 
 /**
  * @brief Free memory allocated for a job generator @p jg.
@@ -49,6 +100,86 @@ void jobgen_free(jobgen* jg);
 void jobgen_set_simtime(jobgen* jg, JOB_INT* simtimes, int len);
 ts const* jobgen_get_tasksystem(jobgen const* const jg);
 
+/**
+ * @brief Restore the number of jobs generated per task on state resume.
+ *
+ * The next job of the task at position @c k is its job number
+ * @p counts[k]. With @c JOBGEN_RNG_BATCH and @c JOBGEN_RNG_COUNTER the random
+ * numbers continue as if all former jobs had been generated, which allows to
+ * start generating at any point of a job trace together with
+ * @c jobgen_set_simtime. With @c JOBGEN_RNG_SHARED only the count is set.
+ */
+void jobgen_set_jobcount(jobgen* jg, uint64_t const* counts, int len);
+
+/**
+ * @brief Number of jobs generated for the task at position @p pos.
+ */
+uint64_t jobgen_get_jobcount(jobgen const* const jg, int const pos);
+
+/**
+ * @brief Tracked time of the task at position @p pos.
+ */
+JOB_INT jobgen_get_simtime(jobgen const* const jg, int const pos);
+
+/**
+ * @brief Random stream mode of the job generator.
+ */
+jobgen_rng jobgen_get_rng(jobgen const* const jg);
+
+/**
+ * @brief Get seed and state of the shared random number generator.
+ */
+void jobgen_get_rngstate(jobgen const* const jg,
+                         uint32_t* const seed,
+                         uint64_t pcg[2]);
+
+/**
+ * @brief Restore seed and state of the shared random number generator on
+ * state resume.
+ *
+ * Set before @c jobgen_set_jobcount, which derives the per task streams from
+ * the seed.
+ */
+void jobgen_set_rngstate(jobgen* jg,
+                         uint32_t const seed,
+                         uint64_t const pcg[2]);
+
+/**
+ * @brief Record every job released by @p jg to the trace writer @p tw.
+ *
+ * Recording stops with @c NULL, the trace writer is not freed.
+ */
+void jobgen_record(jobgen* jg, trace_writer* tw);
+
+/**
+ * @brief Number of jobs released by @p jg so far, which is the number of the
+ * next recorded or replayed job.
+ */
+uint64_t jobgen_get_released(jobgen const* const jg);
+
+/**
+ * @brief Release the jobs of the job trace @p tr instead of generating them.
+ *
+ * The pending jobs of @p jg are dropped and @p tr is positioned at the next
+ * job to release, which is the first job for a job generator without jobs
+ * and the job following the restored state after resume. No random numbers
+ * are drawn while replaying, and release ends with an error at the end of the
+ * trace. Job counts are tracked, so state dumps taken while replaying resume
+ * by replaying the same trace.
+ */
+void jobgen_replay(jobgen* jg, trace* tr);
+
+/**
+ * @brief Release the jobs of the CSV job trace @p tc instead of generating
+ * them.
+ *
+ * Like @c jobgen_replay, but the jobs already released are skipped by
+ * reading through the trace, and after the last job of the trace
+ * @c jobgen_rise returns @c NULL, so that the simulation continues without
+ * further arrivals.
+ */
+void jobgen_replay_csv(jobgen* jg, trace_csv* tc);
+
 /**
  * @brief Get next arriving job.
  *
@@ -56,7 +187,7 @@ ts const* jobgen_get_tasksystem(jobgen const* const jg);
  * arrival time.
  *
  * @param jg Job generator handle
- * @returns Next arriving job
+ * @returns Next arriving job, or @c NULL if no job arrives any more
  */
 job* jobgen_rise(jobgen* jg);
 
@@ -66,9 +197,22 @@ job* jobgen_rise(jobgen* jg);
  */
 int jobgen_dump(jobgen const* const jg, void*** dst);
 
+/**
+ * @brief Write seed, random number generator state, and time and job count
+ * of every task as keys of a JSON object to @p o, each key preceded by a
+ * comma.
+ *
+ * The state is restored by @c jobgen_set_rngstate, @c jobgen_set_simtime, and
+ * @c jobgen_set_jobcount, the pending jobs by @c jobgen_replace_jobq.
+ */
+void jobgen_dump_json(jobgen const* const jg, out* o);
+
 /**
  * @brief Replace the internal job priority queue to support resume from
  * simulation state dump.
+ *
+ * The jobs of @p jq are moved to a queue of the kind the job generator was
+ * initialized with, which frees @p jq.
  */
 void jobgen_replace_jobq(jobgen* const jgen, jobq* const jq);
 
@@ -12,18 +12,55 @@ this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
  * @file jobq.h
  * @author Robert Schmidt
  * @brief Defines interface to job queues.
+ *
+ * @remark By default a job queue is a @c JOBQ_ARITY -ary min-heap without
+ * allocation per inserted job. Compile with @c -DJOBQ_PQUEUE to use the
+ * generic binary heap of pqueue.h instead. Jobs of equal priority leave the
+ * queue in insertion order.
  */
 
 #pragma once
+#include <stddef.h>
 #include "job.h"
+#include "ts.h"
+
+#ifndef JOBQ_ARITY
+#define JOBQ_ARITY 4
+#endif
 
 typedef struct jobq jobq;
 
 /**
- * @brief Initialize job queue.
+ * @brief Data structures backing a job queue.
+ */
+typedef enum {
+        JOBQ_HEAP = 0, /**< Heap over all jobs */
+        JOBQ_PERTASK,  /**< Fifo per task and tournament tree over the fifos */
+        JOBQ_CALENDAR  /**< Calendar queue for mostly increasing priorities */
+} jobq_kind;
+
+/**
+ * @brief Initialize job queue of kind @c JOBQ_HEAP.
  */
 jobq* jobq_init();
 
+/**
+ * @brief Initialize job queue of given @p kind.
+ *
+ * A @c JOBQ_PERTASK queue holds jobs of the tasks of @p tsy only. It expects
+ * the jobs of each task to be inserted mostly in order of priority, like
+ * the deadlines of jobs of a sporadic task, and then inserts and removes in
+ * O(log n) for n tasks independent of the number of queued jobs.
+ *
+ * A @c JOBQ_CALENDAR queue inserts and removes in amortized O(1) as long as
+ * inserted priorities do not fall behind the priority of the last removed job
+ * and are spread evenly, like arrival times of the jobs of a task system.
+ *
+ * @param kind Backing data structure
+ * @param tsy Task system of queued jobs, required for @c JOBQ_PERTASK only
+ */
+jobq* jobq_init_as(jobq_kind const kind, ts const* const tsy);
+
 /**
  * @brief Insert a job in the queue.
  *
@@ -36,6 +73,22 @@ jobq* jobq_init();
  */
 void jobq_insert_by(jobq* const jq, job* const j, JOB_INT (*func)(job* const));
 
+/**
+ * @brief Insert @p n jobs in the queue at once.
+ *
+ * Same as inserting the jobs one after the other with @c jobq_insert_by, but
+ * a @c JOBQ_HEAP is built in O(n) instead of O(n log n).
+ *
+ * @param jq Handle to job queue
+ * @param jobs Array of job handles
+ * @param n Number of jobs
+ * @param func Function pointer
+ */
+void jobq_load_by(jobq* const jq,
+                  job** const jobs,
+                  size_t const n,
+                  JOB_INT (*func)(job* const));
+
 /**
  * @brief Fetch and remove element of highest priority.
  * Returns NULL if job queue is empty.
@@ -59,6 +112,16 @@ job* jobq_peek(jobq* const jq);
  */
 void jobq_free(jobq* const jq);
 
+/**
+ * @brief Get number of queued jobs.
+ */
+size_t jobq_length(jobq const* const jq);
+
+/**
+ * @brief Get greatest number of jobs queued at once since initialization.
+ */
+size_t jobq_peak(jobq const* const jq);
+
 /**
  * @brief Dump content of job queue as part of complete simulator state dump.
  *
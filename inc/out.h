@@ -0,0 +1,81 @@
+/*
+thready - A lightweight and fast scheduling simulator
+Written in 2019 by Robert Schmidt <rschmidt@uni-bremen.de>
+To the extent possible under law, the author(s) have dedicated all copyright and
+related and neighboring rights to this software to the public domain worldwide.
+This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with
+this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+/**
+ * @file out.h
+ * @author Robert Schmidt
+ * @brief Defines interface to the buffered output of dumps and results.
+ *
+ * @remark Output is collected in a large buffer which is written to the stream
+ * when full. Integers are formatted two digits at a time from a table, and
+ * jobs are written as JSON array or CSV line without a generic printer.
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "job.h"
+
+/**
+ * @brief Size of the output buffer in bytes.
+ */
+#ifndef OUT_BUFLEN
+#define OUT_BUFLEN 65536
+#endif
+
+typedef struct out out;
+
+/**
+ * @brief Start buffered output to @p stream.
+ */
+out* out_init(FILE* stream);
+
+/**
+ * @brief Write buffered output to the stream and free the buffer.
+ */
+void out_free(out* o);
+
+/**
+ * @brief Write buffered output to the stream.
+ */
+void out_flush(out* o);
+
+/**
+ * @brief Append character @p c.
+ */
+void out_char(out* o, char const c);
+
+/**
+ * @brief Append @p n bytes at @p p.
+ */
+void out_mem(out* o, void const* p, size_t const n);
+
+/**
+ * @brief Append zero terminated string @p s.
+ */
+void out_str(out* o, char const* s);
+
+/**
+ * @brief Append decimal representation of @p v.
+ */
+void out_int(out* o, int64_t const v);
+
+/**
+ * @brief Append job as JSON array of task id, start time, overrun time,
+ * deadline, and computation.
+ */
+void out_job_json(out* o, job* const j);
+
+/**
+ * @brief Append job as CSV line of task id, start time, overrun time,
+ * deadline, and computation.
+ */
+void out_job_csv(out* o, job* const j);
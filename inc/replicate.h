@@ -0,0 +1,89 @@
+/*
+thready - A lightweight and fast scheduling simulator
+Written in 2019 by Robert Schmidt <rschmidt@uni-bremen.de>
+To the extent possible under law, the author(s) have dedicated all copyright and
+related and neighboring rights to this software to the public domain worldwide.
+This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with
+this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+/**
+ * @file replicate.h
+ * @author Robert Schmidt
+ * @brief Defines interface to replications of a simulation over seeds.
+ *
+ * @remark Replications share the task system read-only and run on a fixed
+ * pool of threads, each of which simulates one seed at a time with a job
+ * generator and eventloop of its own.
+ */
+
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "eventloop.h"
+#include "jobgen.h"
+#include "jobq.h"
+#include "ts.h"
+
+/**
+ * @brief Parameters shared by all replications.
+ */
+typedef struct {
+        ts const* tsy;
+        JOB_INT breaktime;
+        JOB_INT speed;
+        bool overrunbreak;
+        bool allow_first_overrun;
+        jobq_kind readyq;
+        jobgen_queue arrivalq;
+        jobgen_rng rng;
+} replicate_config;
+
+/**
+ * @brief Outcome of the replication of one seed.
+ */
+typedef struct {
+        uint32_t seed;
+        eventloop_result result;
+        EVL_INT now;
+        EVL_INT events;
+        JOB_INT jobsdone;
+} replicate_outcome;
+
+/**
+ * @brief Called with the outcome of every seed in order of seeds.
+ */
+typedef void (*replicate_report)(replicate_outcome const* o, void* arg);
+
+/**
+ * @brief Simulate seed @p seed from time zero.
+ */
+replicate_outcome replicate_seed(replicate_config const* const c,
+                                 uint32_t const seed);
+
+/**
+ * @brief Simulate all seeds from @p first to @p last on @p threads threads.
+ *
+ * Outcomes are passed to @p report as soon as the outcomes of all lower seeds
+ * are known, so they arrive in order of seeds whatever the number of
+ * threads. @p report is never called concurrently.
+ *
+ * @param c Parameters of all replications
+ * @param first First seed
+ * @param last Last seed, inclusive
+ * @param threads Number of worker threads, at least one
+ * @param report Callback receiving the outcomes
+ * @param arg Passed to @p report
+ */
+void replicate_run(replicate_config const* const c,
+                   uint32_t const first,
+                   uint32_t const last,
+                   int threads,
+                   replicate_report report,
+                   void* arg);
+
+/**
+ * @brief Number of online processors, the default number of threads.
+ */
+int replicate_threads(void);
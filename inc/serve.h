@@ -0,0 +1,56 @@
+/*
+thready - A lightweight and fast scheduling simulator
+Written in 2019 by Robert Schmidt <rschmidt@uni-bremen.de>
+To the extent possible under law, the author(s) have dedicated all copyright and
+related and neighboring rights to this software to the public domain worldwide.
+This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with
+this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+/**
+ * @file serve.h
+ * @author Robert Schmidt
+ * @brief Defines interface to the resident simulation server of
+ * @c thready @c --serve.
+ *
+ * @remark Requests are single lines, answered by single lines:
+ *
+ *     ts <task system JSON on one line>
+ *     ts <id>
+ *
+ *     run <id> <seed> <breaktime> <speed> [-|b|ba]
+ *     run <id> <seed> <breaktime> <speed> <flags> <result> <now> <events>
+ *     <jobsdone>
+ *
+ * A task system is parsed once and cached by the hash of its JSON text, the
+ * returned id. Runs simulate a cached task system from time zero with the
+ * flags @c b and @c a of thready and are answered with their parameters in
+ * order of completion. Failed requests are answered by the command, the word
+ * @c error and a description.
+ *
+ * Runs are simulated by a fixed pool of threads, whose job pools stay warm
+ * from run to run.
+ */
+
+#pragma once
+#include <stdio.h>
+#include "thready.h"
+
+#ifndef SERVE_QUEUELEN
+#define SERVE_QUEUELEN 4096
+#endif
+
+/**
+ * @brief Answer the requests read from @p in on file descriptor @p out until
+ * the end of input and all runs are answered.
+ */
+void serve_stream(FILE* in, int out, thready_options const* const o);
+
+/**
+ * @brief Answer the requests of every connection to the Unix domain socket
+ * at @p path, until the process ends.
+ *
+ * A stale socket at @p path is replaced.
+ */
+void serve_socket(char const* path, thready_options const* const o);
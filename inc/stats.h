@@ -33,3 +33,74 @@ float uniformf(rnd_pcg_t** pcg, float min, float max);
  * @f]
  */
 float exponential(rnd_pcg_t** pcg, float beta);
+
+/**
+ * @brief Seed @p pcg as one of many independent streams of seed @p seed.
+ *
+ * Different @p stream values give statistically independent sequences for the
+ * same @p seed, e.g. one per task.
+ */
+void stats_seed_stream(rnd_pcg_t* pcg, uint32_t seed, uint64_t stream);
+
+/**
+ * @brief Advance @p pcg by @p delta draws in O(log @p delta) steps.
+ */
+void stats_pcg_advance(rnd_pcg_t* pcg, uint64_t delta);
+
+/**
+ * @brief Philox4x32-10 counter-based random number generator.
+ *
+ * Replaces the counter @p ctr by four random words which are a pure function
+ * of @p ctr and @p key (Salmon et al., "Parallel random numbers: as easy as
+ * 1, 2, 3", SC'11).
+ */
+void stats_philox(uint32_t ctr[4], uint32_t const key[2]);
+
+/**
+ * @brief Fill three rows of @p n uniformly distributed floats in [0, 1) from
+ * Philox counters @p counter to @p counter + @p n - 1 of @p stream.
+ *
+ * Column @c i of the rows @p dst[i], @p dst[n + i] and @p dst[2n + i] only
+ * depends on @p key, @p stream and @p counter + @c i.
+ */
+void philox_fill(uint32_t const key[2],
+                 uint64_t const stream,
+                 uint64_t const counter,
+                 float* const dst,
+                 int const n);
+
+/**
+ * @brief Fill @p dst with @p n uniformly distributed floats in [0, 1).
+ *
+ * Gives the same numbers as @p n calls of @c uniformf(pcg, 0.0f, 1.0f).
+ */
+void uniformf_fill(rnd_pcg_t** pcg, float* const dst, int const n);
+
+/**
+ * @brief Transform @p n uniform floats @p u in [0, 1) to exponentially
+ * distributed floats with parameter @p beta.
+ *
+ * Vectorized counterpart of @c exponential. The logarithm is approximated to
+ * float precision, so results may differ from @c exponential in the last bit.
+ */
+void exponential_fill(float const* const u,
+                      float const beta,
+                      float* const dst,
+                      int const n);
+
+/**
+ * @brief Draw @p n floats from a piecewise uniform distribution.
+ *
+ * With probability @p p0 the result is uniform between @p bounds[0] and
+ * @p bounds[1], with probability @p p1 between @p bounds[2] and
+ * @p bounds[3], otherwise between @p bounds[4] and @p bounds[5]. The segment
+ * is selected by @p y and the position inside by @p u, both uniform in
+ * [0, 1).
+ */
+void uniform3_fill(float const* const y,
+                   float const* const u,
+                   float const p0,
+                   float const p1,
+                   float const* const bounds,
+                   float* const dst,
+                   int const n);
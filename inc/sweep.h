@@ -0,0 +1,130 @@
+/*
+thready - A lightweight and fast scheduling simulator
+Written in 2019 by Robert Schmidt <rschmidt@uni-bremen.de>
+To the extent possible under law, the author(s) have dedicated all copyright and
+related and neighboring rights to this software to the public domain worldwide.
+This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with
+this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+/**
+ * @file sweep.h
+ * @author Robert Schmidt
+ * @brief Defines interface to parameter sweeps over a grid of simulations.
+ *
+ * @remark The runs of the grid are numbered and split into one range per
+ * thread. A thread without runs left steals the upper half of the remaining
+ * runs of another thread, so threads stay busy although runs take from
+ * microseconds to minutes.
+ */
+
+#pragma once
+#include <stdint.h>
+#include "jobgen.h"
+#include "jobq.h"
+#include "ts.h"
+
+/**
+ * @brief Handling of overruns, the options @c -b and @c -a of thready.
+ */
+typedef enum {
+        SWEEP_OVERRUN_NONE = 0, /**< Do not break on overrun */
+        SWEEP_OVERRUN_BREAK,    /**< Break on overrun, @c -b */
+        SWEEP_OVERRUN_FIRST     /**< Break on second overrun, @c -b @c -a */
+} sweep_overrun;
+
+/**
+ * @brief First bytes of a binary sweep result file, including the
+ * terminating zero.
+ */
+#define SWEEP_MAGIC "THRSWEP"
+
+/**
+ * @brief Version of the binary sweep result layout.
+ */
+#define SWEEP_VERSION 1
+
+/**
+ * @brief Grid of simulations, the cross product of all lists and seeds.
+ */
+typedef struct {
+        ts const* const* tsys;
+        int ntsys;
+        uint32_t seedfirst;
+        uint32_t seedlast; /**< Inclusive */
+        JOB_INT const* speeds;
+        int nspeeds;
+        JOB_INT const* breaktimes;
+        int nbreaktimes;
+        sweep_overrun const* overruns;
+        int noverruns;
+        jobq_kind readyq;
+        jobgen_queue arrivalq;
+        jobgen_rng rng;
+} sweep_grid;
+
+/**
+ * @brief Header of a binary sweep result file, followed by one
+ * @c sweep_record per run in order of completion.
+ */
+typedef struct {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteorder; /**< @c DUMP_BYTEORDER in host byte order */
+        uint64_t runs;      /**< Size of the grid */
+} sweep_header;
+
+/**
+ * @brief Parameters and outcome of a run.
+ */
+typedef struct {
+        uint64_t run;       /**< Number of the run within the grid */
+        uint32_t tsy;       /**< Position of the task system in the grid */
+        uint32_t seed;
+        int64_t speed;
+        int64_t breaktime;
+        int64_t now;
+        int64_t events;
+        int64_t jobsdone;
+        uint8_t overrun;    /**< @c sweep_overrun */
+        uint8_t result;     /**< @c eventloop_result */
+        uint8_t reserved[6];
+} sweep_record;
+
+/**
+ * @brief Called with every finished run.
+ */
+typedef void (*sweep_report)(sweep_record const* r, void* arg);
+
+/**
+ * @brief Number of runs of the grid.
+ */
+uint64_t sweep_size(sweep_grid const* const g);
+
+/**
+ * @brief Parameters of run number @p run, with overrun mode varying
+ * fastest, followed by breaktime, speed, seed and task system.
+ */
+sweep_record sweep_point(sweep_grid const* const g, uint64_t const run);
+
+/**
+ * @brief Simulate run number @p run.
+ */
+sweep_record sweep_simulate(sweep_grid const* const g, uint64_t const run);
+
+/**
+ * @brief Simulate all runs of the grid on @p threads work stealing threads.
+ *
+ * Every finished run is passed to @p report in order of completion. @p report
+ * is never called concurrently.
+ *
+ * @param g Grid of runs
+ * @param threads Number of worker threads, at least one
+ * @param report Callback receiving the finished runs
+ * @param arg Passed to @p report
+ */
+void sweep_run(sweep_grid const* const g,
+               int threads,
+               sweep_report report,
+               void* arg);
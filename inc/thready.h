@@ -0,0 +1,194 @@
+/*
+thready - A lightweight and fast scheduling simulator
+Written in 2019 by Robert Schmidt <rschmidt@uni-bremen.de>
+To the extent possible under law, the author(s) have dedicated all copyright and
+related and neighboring rights to this software to the public domain worldwide.
+This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with
+this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+/**
+ * @file thready.h
+ * @author Robert Schmidt
+ * @brief Public interface of libthready, batches of simulations in process.
+ *
+ * @remark A task system is read once, from JSON in memory or from task
+ * parameters, and simulated for a batch of runs. Nothing is read from or
+ * written to files or stdout, and invalid input is reported by the returned
+ * status. Only running out of memory within the simulation still terminates
+ * the process.
+ *
+ * All functions are reentrant. A task system may be simulated by several
+ * threads at once. Jobs are pooled per thread and kept for the next batch,
+ * @c thready_thread_free releases them.
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#define THREADY_NUM_COMP 6
+#define THREADY_NUM_PROB 2
+
+/**
+ * @brief Outcome of a library call.
+ */
+typedef enum {
+        THREADY_OK = 0,
+        THREADY_EINVAL,      /**< Invalid argument */
+        THREADY_EPARSE,      /**< Malformed task system JSON */
+        THREADY_ETASKSYSTEM, /**< Jobs can not be generated from the tasks */
+        THREADY_ENOMEM       /**< Out of memory */
+} thready_status;
+
+/**
+ * @brief Result of a run, in the order of @c eventloop_result.
+ */
+typedef enum {
+        THREADY_RESULT_OK = 0,
+        THREADY_RESULT_DEADLINEMISS,
+        THREADY_RESULT_PASS,
+        THREADY_RESULT_OVERRUN
+} thready_result;
+
+/**
+ * @brief Handling of overruns, the options @c -b and @c -a of thready.
+ */
+typedef enum {
+        THREADY_OVERRUN_NONE = 0, /**< Do not break on overrun */
+        THREADY_OVERRUN_BREAK,    /**< Break on overrun, @c -b */
+        THREADY_OVERRUN_FIRST     /**< Break on second overrun, @c -b @c -a */
+} thready_overrun;
+
+/**
+ * @brief Scheduler queue, option @c -q of thready.
+ */
+typedef enum {
+        THREADY_READYQ_HEAP = 0,
+        THREADY_READYQ_PERTASK,
+        THREADY_READYQ_CALENDAR
+} thready_readyq;
+
+/**
+ * @brief Job generator queue, option @c -g of thready.
+ */
+typedef enum {
+        THREADY_ARRIVALQ_ARRAY = 0,
+        THREADY_ARRIVALQ_HEAP,
+        THREADY_ARRIVALQ_CALENDAR
+} thready_arrivalq;
+
+/**
+ * @brief Random streams of the job generator, option @c -s of thready.
+ */
+typedef enum {
+        THREADY_RNG_SHARED = 0,
+        THREADY_RNG_BATCH,
+        THREADY_RNG_COUNTER
+} thready_rng;
+
+/**
+ * @brief Parameters of a task, the entries of a task in the JSON format of
+ * @c ts_read_json.
+ */
+typedef struct {
+        int64_t id;
+        int64_t period;
+        int64_t reldead;
+        int64_t comp[THREADY_NUM_COMP];
+        float prob[THREADY_NUM_PROB];
+        float beta;
+} thready_task;
+
+/**
+ * @brief Run of a batch, simulated from time zero.
+ */
+typedef struct {
+        uint32_t seed;
+        int64_t breaktime;
+        int64_t speed; /**< Work per time step, at least one */
+        thready_overrun overrun;
+} thready_run;
+
+/**
+ * @brief Outcome of a run.
+ */
+typedef struct {
+        thready_result result;
+        int64_t now;
+        int64_t events;
+        int64_t jobsdone;
+} thready_outcome;
+
+/**
+ * @brief Options shared by the runs of a batch.
+ */
+typedef struct {
+        thready_readyq readyq;
+        thready_arrivalq arrivalq;
+        thready_rng rng;
+        int threads; /**< Threads simulating the batch, one if less */
+} thready_options;
+
+typedef struct thready_tasksystem thready_tasksystem;
+
+/**
+ * @brief Create a task system of @p n tasks.
+ *
+ * @param tsy Receives the task system, NULL unless @c THREADY_OK
+ */
+thready_status thready_tasksystem_init(thready_tasksystem** tsy,
+                                       thready_task const* tasks,
+                                       int n);
+
+/**
+ * @brief Create a task system from @p len bytes of JSON at @p json.
+ *
+ * @param tsy Receives the task system, NULL unless @c THREADY_OK
+ */
+thready_status thready_tasksystem_parse(thready_tasksystem** tsy,
+                                        char const* json,
+                                        size_t len);
+
+void thready_tasksystem_free(thready_tasksystem* tsy);
+
+/**
+ * @brief Number of tasks.
+ */
+int thready_tasksystem_length(thready_tasksystem const* tsy);
+
+/**
+ * @brief Set the options of thready without arguments, on one thread.
+ */
+void thready_options_default(thready_options* o);
+
+/**
+ * @brief Simulate the @p n runs of @p runs.
+ *
+ * All runs are checked before the first is simulated. Every run equals the
+ * simulation by thready with the corresponding options.
+ *
+ * @param o Options, NULL for the defaults
+ * @param outcomes Receives the outcome of run @c i at position @c i
+ */
+thready_status thready_simulate(thready_tasksystem const* tsy,
+                                thready_run const* runs,
+                                size_t n,
+                                thready_options const* o,
+                                thready_outcome* outcomes);
+
+/**
+ * @brief Release the jobs pooled by the calling thread.
+ */
+void thready_thread_free(void);
+
+/**
+ * @brief Description of @p s.
+ */
+char const* thready_strerror(thready_status s);
+
+/**
+ * @brief Version of the library.
+ */
+char const* thready_version(void);
@@ -0,0 +1,54 @@
+/*
+thready - A lightweight and fast scheduling simulator
+Written in 2019 by Robert Schmidt <rschmidt@uni-bremen.de>
+To the extent possible under law, the author(s) have dedicated all copyright and
+related and neighboring rights to this software to the public domain worldwide.
+This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with
+this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+/**
+ * @file tourn.h
+ * @author Robert Schmidt
+ * @brief Defines interface to tournament trees.
+ *
+ * @remark A tournament tree tracks the minimum over a fixed number of slots,
+ * where each slot holds at most one key. Updating the key of a slot costs
+ * O(log n), finding the minimum O(1). Keys are ordered by priority first and
+ * sequence number second.
+ */
+
+#pragma once
+#include <stdint.h>
+#include "job.h"
+
+typedef struct tourn tourn;
+
+/**
+ * @brief Allocate tournament tree of @p n empty slots.
+ */
+tourn* tourn_init(int const n);
+
+/**
+ * @brief Free memory of tournament tree @p tt.
+ */
+void tourn_free(tourn* tt);
+
+/**
+ * @brief Set key of @p slot to @p pri and @p seq.
+ */
+void tourn_update(tourn* const tt,
+                  int const slot,
+                  JOB_INT const pri,
+                  uint64_t const seq);
+
+/**
+ * @brief Remove key from @p slot.
+ */
+void tourn_clear(tourn* const tt, int const slot);
+
+/**
+ * @brief Returns slot holding the minimal key or -1 if all slots are empty.
+ */
+int tourn_winner(tourn const* const tt);
@@ -0,0 +1,193 @@
+/*
+thready - A lightweight and fast scheduling simulator
+Written in 2019 by Robert Schmidt <rschmidt@uni-bremen.de>
+To the extent possible under law, the author(s) have dedicated all copyright and
+related and neighboring rights to this software to the public domain worldwide.
+This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with
+this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+/**
+ * @file trace.h
+ * @author Robert Schmidt
+ * @brief Defines interface to recorded job traces.
+ *
+ * @remark A job trace holds the jobs in the order the job generator released
+ * them. Records are varint encoded relative to the arrival of the former
+ * record, and every @c TRACE_INTERVAL records the arrival is encoded in full
+ * and noted in an index, so that a mapped trace can be replayed from any
+ * record or arrival time. Traces of measured jobs are read as CSV through a
+ * fixed size buffer, so that their length does not matter.
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include "job.h"
+#include "ts.h"
+
+/**
+ * @brief Number of records between two entries of the time index.
+ */
+#ifndef TRACE_INTERVAL
+#define TRACE_INTERVAL 4096
+#endif
+
+/**
+ * @brief Size of the read ahead buffer of CSV job traces, which bounds the
+ * length of a line.
+ */
+#ifndef TRACE_READLEN
+#define TRACE_READLEN 65536
+#endif
+
+/**
+ * @brief First bytes of a job trace, including the terminating zero.
+ */
+#define TRACE_MAGIC "THRTRCE"
+
+/**
+ * @brief Version of the job trace layout.
+ */
+#define TRACE_VERSION 1
+
+/**
+ * @brief Header of a job trace.
+ *
+ * The header is followed by the records, each of which is the task position
+ * and the arrival relative to the former record as unsigned varints, and the
+ * relative deadline, computation and overrun time as zigzag encoded varints.
+ * The records are followed by the index of @c trace_entry and the
+ * @c trace_footer.
+ */
+typedef struct {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteorder; /**< @c DUMP_BYTEORDER in host byte order */
+        uint64_t tshash;    /**< @c ts_hash of the task system */
+        uint64_t first;     /**< Number of the first record */
+        uint32_t interval;  /**< Records per index entry */
+        uint32_t ntasks;
+} trace_header;
+
+/**
+ * @brief Index entry of record number @c first + i * @c interval.
+ */
+typedef struct {
+        uint64_t offset; /**< Byte offset of the record */
+        int64_t time;    /**< Arrival of the record */
+} trace_entry;
+
+/**
+ * @brief End of a job trace.
+ */
+typedef struct {
+        uint64_t records;
+        uint64_t index; /**< Byte offset of the index */
+        uint64_t entries;
+        char magic[8];
+} trace_footer;
+
+typedef struct trace_writer trace_writer;
+typedef struct trace trace;
+typedef struct trace_csv trace_csv;
+
+/**
+ * @brief Start recording a job trace of the task system @p tsy to @p stream.
+ *
+ * @param stream Output stream, which may be a pipe
+ * @param tsy Task system of the recorded jobs
+ * @param first Number of the first recorded job, the count of jobs the job
+ * generator released before
+ * @returns Handle to trace writer
+ */
+trace_writer* trace_writer_init(FILE* stream,
+                                ts const* const tsy,
+                                uint64_t const first);
+
+/**
+ * @brief Append job @p j to the trace.
+ */
+void trace_write(trace_writer* tw, job* const j);
+
+/**
+ * @brief Write index and footer and free the trace writer.
+ *
+ * The stream is left open.
+ */
+void trace_writer_free(trace_writer* tw);
+
+/**
+ * @brief Map the job trace in @p stream for replay.
+ *
+ * The stream has to be a regular file, which may be closed afterwards. The
+ * trace has to be recorded from the task system @p tsy.
+ *
+ * @returns Handle to the trace, positioned at its first record
+ */
+trace* trace_init(FILE* stream, ts const* const tsy);
+
+/**
+ * @brief Unmap and free the trace.
+ */
+void trace_free(trace* tr);
+
+/**
+ * @brief Return the job of the next record or @c NULL at the end of the
+ * trace.
+ */
+job* trace_next(trace* tr);
+
+/**
+ * @brief Position the trace at record number @p record.
+ *
+ * Decoding starts at the closest index entry, so at most @c TRACE_INTERVAL
+ * records are skipped.
+ */
+void trace_seek(trace* tr, uint64_t const record);
+
+/**
+ * @brief Position the trace at the first record arriving at or after
+ * @p time.
+ */
+void trace_seek_time(trace* tr, JOB_INT const time);
+
+/**
+ * @brief Number of the record returned next by @c trace_next.
+ */
+uint64_t trace_tell(trace const* const tr);
+
+/**
+ * @brief Number of the first and one past the last record of the trace.
+ */
+void trace_range(trace const* const tr, uint64_t* first, uint64_t* end);
+
+/**
+ * @brief Start reading the CSV job trace in @p stream.
+ *
+ * Every line holds task id, arrival, overrun time, absolute deadline and
+ * computation of a job, as written by @c out_job_csv, in order of arrival.
+ * An empty deadline is the arrival plus the relative deadline of the task,
+ * an empty overrun time is one beyond the computation, which never overruns.
+ * A first line not starting with a number is skipped as header. The stream
+ * may be a pipe.
+ *
+ * @returns Handle to the CSV job trace
+ */
+trace_csv* trace_csv_init(FILE* stream, ts const* const tsy);
+
+/**
+ * @brief Free the CSV job trace, the stream is left open.
+ */
+void trace_csv_free(trace_csv* tc);
+
+/**
+ * @brief Return the job of the next line or @c NULL at the end of the trace.
+ */
+job* trace_csv_next(trace_csv* tc);
+
+/**
+ * @brief Skip the next @p n jobs of the trace.
+ */
+void trace_csv_skip(trace_csv* tc, uint64_t n);
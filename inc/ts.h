@@ -15,11 +15,36 @@ this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
  */
 
 #pragma once
+#include <stdint.h>
 #include <stdio.h>
 #include "task.h"
 
+/**
+ * @brief Largest ratio of the id range to the number of tasks for which task
+ * ids are looked up in a direct table instead of a hash table.
+ */
+#ifndef TS_INDEX_DIRECT_FACTOR
+#define TS_INDEX_DIRECT_FACTOR 4
+#endif
+
 typedef struct ts ts;
 
+/**
+ * @brief Parameters of all tasks of a task system as structure of arrays.
+ *
+ * Entry @c k of each array belongs to the task at position @c k. Each array
+ * is aligned to 64 bytes.
+ */
+typedef struct {
+        int n; /**< Number of tasks */
+        TASK_INT* ids;
+        TASK_INT* periods;
+        TASK_INT* reldeads;
+        TASK_INT* comp[TASK_NUM_COMP];
+        float* prob[TASK_NUM_PROB];
+        float* beta;
+} ts_params;
+
 /**
  * @brief Allocate memory for task system.
  *
@@ -29,10 +54,35 @@ ts* ts_init();
 void ts_free(ts* tsy);
 
 task* ts_get_by_pos(ts const* const tsy, int const pos);
+
+/**
+ * @brief Look up task by its id in constant time.
+ *
+ * If ids are defined more than once the first definition is returned.
+ */
 task* ts_get_by_id(ts const* const tsy, TASK_INT const id);
+
+/**
+ * @brief Look up position of task by its id in constant time.
+ */
 int ts_get_pos_by_id(ts const* const tsy, TASK_INT const taskid);
 int ts_length(ts const* const tsy);
 
+/**
+ * @brief Get the parameters of all tasks as structure of arrays.
+ *
+ * The table is built by @c ts_read_json, later changes to single tasks are
+ * not reflected.
+ */
+ts_params const* ts_get_params(ts const* const tsy);
+
+/**
+ * @brief Hash of the parameters of all tasks in order of their position.
+ *
+ * Used to check that a checkpoint belongs to the task system.
+ */
+uint64_t ts_hash(ts const* const tsy);
+
 /**
  * @brief Read task system from JSON stored in file.
  *
@@ -80,3 +130,29 @@ int ts_length(ts const* const tsy);
  *     ]
  */
 void ts_read_json(ts* tsy, FILE* stream);
+
+/**
+ * @brief Read task system from the @p len bytes of JSON at @p json.
+ *
+ * Reads the format of @c ts_read_json, but returns instead of exiting on
+ * malformed input. Tasks read before the error are kept.
+ *
+ * @return NULL, or a description of the first error.
+ */
+char const* ts_parse_json(ts* tsy, char const* json, size_t len);
+
+/**
+ * @brief Append the @c n tasks of @p p to the task system.
+ */
+void ts_read_params(ts* tsy, ts_params const* p);
+
+/**
+ * @brief Check that jobs can be generated from the task parameters.
+ *
+ * Periods and relative deadlines have to be positive, probabilities have to
+ * sum up to at most one, and every computation segment of nonzero probability
+ * has to be ordered and demand at least one time step.
+ *
+ * @return NULL, or a description of the first violation.
+ */
+char const* ts_check(ts const* const tsy);
@@ -0,0 +1,532 @@
+/*
+thready - A lightweight and fast scheduling simulator
+Written in 2019 by Robert Schmidt <rschmidt@uni-bremen.de>
+To the extent possible under law, the author(s) have dedicated all copyright and
+related and neighboring rights to this software to the public domain worldwide.
+This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with
+this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+/**
+ * @file threadymodule.c
+ * @author Robert Schmidt
+ * @brief CPython extension over the batch interface of libthready.
+ *
+ * @remark Columns are read from any object supporting the buffer protocol,
+ * NumPy arrays among them, or from (nested) sequences of numbers. Outcomes are
+ * returned as @c array.array, which NumPy wraps without copy by
+ * @c numpy.asarray. The module itself does not depend on NumPy.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "replicate.h"
+#include "thready.h"
+
+typedef struct {
+        PyObject_HEAD
+        thready_tasksystem* tsy;
+} TaskSystem;
+
+static PyTypeObject TaskSystemType;
+
+/* Convert a status other than THREADY_OK to an exception */
+static PyObject* raise_status(thready_status s) {
+        PyErr_SetString(s == THREADY_ENOMEM ? PyExc_MemoryError
+                                            : PyExc_ValueError,
+                        thready_strerror(s));
+        return NULL;
+}
+
+/* Number of values of a column, -1 with exception if it is no column */
+static Py_ssize_t column_length(PyObject* obj, char const* name) {
+        if (PyObject_CheckBuffer(obj)) {
+                Py_buffer view;
+                if (PyObject_GetBuffer(obj, &view, PyBUF_ND)) {
+                        return -1;
+                }
+                Py_ssize_t n = view.ndim ? view.shape[0] : 1;
+                PyBuffer_Release(&view);
+                return n;
+        }
+        if (!PySequence_Check(obj) || PyUnicode_Check(obj)) {
+                PyErr_Format(PyExc_TypeError, "%s is no sequence", name);
+                return -1;
+        }
+        return PySequence_Size(obj);
+}
+
+/* Value i of a contiguous buffer of numbers in native byte order */
+static bool buffer_value(Py_buffer const* view,
+                         Py_ssize_t i,
+                         int64_t* ival,
+                         double* fval) {
+        char const* fmt = view->format ? view->format : "B";
+        fmt += (*fmt == '@' || *fmt == '=') ? 1 : 0;
+        if (!fmt[0] || fmt[1]) {
+                return false;
+        }
+        char const* p = (char const*)view->buf + i * view->itemsize;
+        bool ok = true;
+        if (strchr("bhilq", *fmt)) {
+                switch (view->itemsize) {
+                        case 1:
+                                *ival = *(int8_t const*)p;
+                                break;
+                        case 2:
+                                *ival = *(int16_t const*)p;
+                                break;
+                        case 4:
+                                *ival = *(int32_t const*)p;
+                                break;
+                        default:
+                                ok = view->itemsize == 8;
+                                *ival = ok ? *(int64_t const*)p : 0;
+                }
+                *fval = (double)*ival;
+                return ok;
+        }
+        if (strchr("BHILQ", *fmt)) {
+                switch (view->itemsize) {
+                        case 1:
+                                *ival = *(uint8_t const*)p;
+                                break;
+                        case 2:
+                                *ival = *(uint16_t const*)p;
+                                break;
+                        case 4:
+                                *ival = *(uint32_t const*)p;
+                                break;
+                        default:
+                                ok = view->itemsize == 8;
+                                *ival = ok ? *(int64_t const*)p : 0;
+                }
+                *fval = (double)*ival;
+                return ok;
+        }
+        if (*fmt == 'f' && view->itemsize == sizeof(float)) {
+                *fval = *(float const*)p;
+        } else if (*fmt == 'd' && view->itemsize == sizeof(double)) {
+                *fval = *(double const*)p;
+        } else {
+                return false;
+        }
+        *ival = (int64_t)*fval;
+        return true;
+}
+
+/* Copy @p n values of a buffer or a nested sequence to ints or floats */
+static int read_values(PyObject* obj,
+                       Py_ssize_t n,
+                       int64_t* ints,
+                       double* floats,
+                       char const* name) {
+        if (PyObject_CheckBuffer(obj)) {
+                Py_buffer view;
+                if (PyObject_GetBuffer(obj, &view,
+                                       PyBUF_C_CONTIGUOUS | PyBUF_FORMAT)) {
+                        return -1;
+                }
+                int err = 0;
+                if (view.len / view.itemsize != n) {
+                        PyErr_Format(PyExc_ValueError,
+                                     "%s holds %zd instead of %zd values", name,
+                                     view.len / view.itemsize, n);
+                        err = -1;
+                }
+                for (Py_ssize_t i = 0; !err && i < n; i++) {
+                        int64_t iv;
+                        double fv;
+                        if (!buffer_value(&view, i, &iv, &fv)) {
+                                PyErr_Format(PyExc_TypeError,
+                                             "%s has unsupported format '%s'",
+                                             name, view.format);
+                                err = -1;
+                        } else if (ints) {
+                                ints[i] = iv;
+                        } else {
+                                floats[i] = fv;
+                        }
+                }
+                PyBuffer_Release(&view);
+                return err;
+        }
+        // Flatten nested sequences in row major order
+        PyObject* seq = PySequence_Fast(obj, name);
+        if (!seq) {
+                return -1;
+        }
+        Py_ssize_t len = PySequence_Fast_GET_SIZE(seq);
+        Py_ssize_t width = 1;
+        PyObject** items = PySequence_Fast_ITEMS(seq);
+        if (len && PySequence_Check(items[0]) && !PyUnicode_Check(items[0])) {
+                width = n / len;
+        }
+        if (len * width != n) {
+                PyErr_Format(PyExc_ValueError,
+                             "%s holds %zd instead of %zd values", name,
+                             len * width, n);
+                Py_DECREF(seq);
+                return -1;
+        }
+        for (Py_ssize_t i = 0; i < len; i++) {
+                int err = 0;
+                if (width > 1) {
+                        err = read_values(items[i], width,
+                                          ints ? ints + i * width : NULL,
+                                          floats ? floats + i * width : NULL,
+                                          name);
+                } else if (ints) {
+                        ints[i] = PyLong_AsLongLong(items[i]);
+                        err = ints[i] == -1 && PyErr_Occurred() ? -1 : 0;
+                } else {
+                        floats[i] = PyFloat_AsDouble(items[i]);
+                        err = floats[i] == -1.0 && PyErr_Occurred() ? -1 : 0;
+                }
+                if (err) {
+                        Py_DECREF(seq);
+                        return -1;
+                }
+        }
+        Py_DECREF(seq);
+        return 0;
+}
+
+/* Read a column of n ints, or broadcast a single int */
+static int read_ints(PyObject* obj,
+                     Py_ssize_t n,
+                     int64_t* dst,
+                     char const* name) {
+        if (PyLong_Check(obj)) {
+                int64_t v = PyLong_AsLongLong(obj);
+                if (v == -1 && PyErr_Occurred()) {
+                        return -1;
+                }
+                for (Py_ssize_t i = 0; i < n; i++) {
+                        dst[i] = v;
+                }
+                return 0;
+        }
+        return read_values(obj, n, dst, NULL, name);
+}
+
+static int read_choice(PyObject* obj,
+                       char const* const* names,
+                       int count,
+                       int* dst,
+                       char const* name) {
+        if (!obj) {
+                return 0;
+        }
+        char const* s = PyUnicode_AsUTF8(obj);
+        if (!s) {
+                return -1;
+        }
+        for (int i = 0; i < count; i++) {
+                if (!strcmp(s, names[i])) {
+                        *dst = i;
+                        return 0;
+                }
+        }
+        PyErr_Format(PyExc_ValueError, "unknown %s '%s'", name, s);
+        return -1;
+}
+
+static char const* const overruns_names[] = {"none", "break", "first"};
+static char const* const readyqs[] = {"heap", "pertask", "calendar"};
+static char const* const arrivalqs[] = {"array", "heap", "calendar"};
+static char const* const rngs[] = {"shared", "batch", "counter"};
+
+static int TaskSystem_init(TaskSystem* self, PyObject* args, PyObject* kwds) {
+        static char* kwlist[] = {"ids", "periods", "reldeads", "comp",
+                                 "prob", "beta", NULL};
+        PyObject* cols[6];
+        // Other threads may simulate the task system with the GIL released
+        if (self->tsy) {
+                PyErr_SetString(PyExc_RuntimeError,
+                                "task system already initialized");
+                return -1;
+        }
+        if (!PyArg_ParseTupleAndKeywords(args, kwds, "OOOOOO", kwlist, cols,
+                                         cols + 1, cols + 2, cols + 3,
+                                         cols + 4, cols + 5)) {
+                return -1;
+        }
+        Py_ssize_t n = column_length(cols[0], "ids");
+        if (n < 0) {
+                return -1;
+        }
+        int64_t* ints = PyMem_Calloc((3 + THREADY_NUM_COMP) * n + 1,
+                                     sizeof(int64_t));
+        double* floats = PyMem_Calloc((1 + THREADY_NUM_PROB) * n + 1,
+                                      sizeof(double));
+        thready_task* tasks = PyMem_Calloc(n + 1, sizeof(thready_task));
+        int err = -1;
+        if (!ints || !floats || !tasks) {
+                PyErr_NoMemory();
+        } else if (!read_values(cols[0], n, ints, NULL, "ids") &&
+                   !read_values(cols[1], n, ints + n, NULL, "periods") &&
+                   !read_values(cols[2], n, ints + 2 * n, NULL, "reldeads") &&
+                   !read_values(cols[3], THREADY_NUM_COMP * n, ints + 3 * n,
+                                NULL, "comp") &&
+                   !read_values(cols[4], THREADY_NUM_PROB * n, NULL, floats,
+                                "prob") &&
+                   !read_values(cols[5], n, NULL,
+                                floats + THREADY_NUM_PROB * n, "beta")) {
+                // comp and prob hold one row per task
+                for (Py_ssize_t k = 0; k < n; k++) {
+                        thready_task* t = tasks + k;
+                        t->id = ints[k];
+                        t->period = ints[n + k];
+                        t->reldead = ints[2 * n + k];
+                        for (int j = 0; j < THREADY_NUM_COMP; j++) {
+                                t->comp[j] =
+                                    ints[3 * n + k * THREADY_NUM_COMP + j];
+                        }
+                        for (int j = 0; j < THREADY_NUM_PROB; j++) {
+                                t->prob[j] = floats[k * THREADY_NUM_PROB + j];
+                        }
+                        t->beta = floats[THREADY_NUM_PROB * n + k];
+                }
+                thready_status s =
+                    thready_tasksystem_init(&self->tsy, tasks, n);
+                err = s == THREADY_OK ? 0 : (raise_status(s), -1);
+        }
+        PyMem_Free(ints);
+        PyMem_Free(floats);
+        PyMem_Free(tasks);
+        return err;
+}
+
+static void TaskSystem_dealloc(TaskSystem* self) {
+        thready_tasksystem_free(self->tsy);
+        Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static Py_ssize_t TaskSystem_len(TaskSystem* self) {
+        return self->tsy ? thready_tasksystem_length(self->tsy) : 0;
+}
+
+static PyObject* TaskSystem_from_json(PyTypeObject* type, PyObject* arg) {
+        char const* json = NULL;
+        Py_ssize_t len;
+        if (PyUnicode_Check(arg)) {
+                json = PyUnicode_AsUTF8AndSize(arg, &len);
+        } else {
+                char* bytes;
+                json = PyBytes_AsStringAndSize(arg, &bytes, &len) ? NULL
+                                                                  : bytes;
+        }
+        if (!json) {
+                return NULL;
+        }
+        TaskSystem* self = (TaskSystem*)type->tp_alloc(type, 0);
+        if (!self) {
+                return NULL;
+        }
+        thready_status s = thready_tasksystem_parse(&self->tsy, json, len);
+        if (s != THREADY_OK) {
+                Py_DECREF(self);
+                return raise_status(s);
+        }
+        return (PyObject*)self;
+}
+
+/* array.array of typecode from n values at data */
+static PyObject* to_array(char const* typecode, void const* data, size_t size) {
+        PyObject* module = PyImport_ImportModule("array");
+        if (!module) {
+                return NULL;
+        }
+        PyObject* bytes = PyBytes_FromStringAndSize(data, size);
+        PyObject* array =
+            bytes ? PyObject_CallMethod(module, "array", "sO", typecode, bytes)
+                  : NULL;
+        Py_XDECREF(bytes);
+        Py_DECREF(module);
+        return array;
+}
+
+/* Read the runs of a batch, simulate them, and convert the outcomes */
+static PyObject* run_batch(TaskSystem* tsy,
+                           PyObject* const* cols,
+                           Py_ssize_t n,
+                           thready_options const* const o,
+                           int64_t* values,
+                           thready_run* runs,
+                           thready_outcome* outcomes) {
+        // Columns of seeds, breaktimes, speeds and overrun handling
+        int64_t* seeds = values;
+        int64_t* breaktimes = values + n;
+        int64_t* speeds = values + 2 * n;
+        int64_t* overruns = values + 3 * n;
+        int overrun = THREADY_OVERRUN_NONE;
+        PyObject* overrunobj = cols[3];
+        if (overrunobj && PyUnicode_Check(overrunobj)) {
+                if (read_choice(overrunobj, overruns_names, 3, &overrun,
+                                "overrun")) {
+                        return NULL;
+                }
+                overrunobj = NULL;
+        }
+        if (read_values(cols[0], n, seeds, NULL, "seeds") ||
+            read_ints(cols[1], n, breaktimes, "breaktime") ||
+            (cols[2] && read_ints(cols[2], n, speeds, "speed")) ||
+            (overrunobj && read_ints(overrunobj, n, overruns, "overrun"))) {
+                return NULL;
+        }
+        for (Py_ssize_t i = 0; i < n; i++) {
+                runs[i].seed = (uint32_t)seeds[i];
+                runs[i].breaktime = breaktimes[i];
+                runs[i].speed = cols[2] ? speeds[i] : 1;
+                runs[i].overrun = overrunobj ? overruns[i] : overrun;
+        }
+
+        PyThreadState* save = PyEval_SaveThread();
+        thready_status s = thready_simulate(tsy->tsy, runs, n, o, outcomes);
+        PyEval_RestoreThread(save);
+        if (s != THREADY_OK) {
+                return raise_status(s);
+        }
+
+        // Outcomes as columns, reusing the columns of the runs
+        int8_t* results = (int8_t*)overruns;
+        for (Py_ssize_t i = 0; i < n; i++) {
+                results[i] = outcomes[i].result;
+                seeds[i] = outcomes[i].now;
+                breaktimes[i] = outcomes[i].events;
+                speeds[i] = outcomes[i].jobsdone;
+        }
+        PyObject* arrays[4] = {to_array("b", results, n),
+                               to_array("q", seeds, n * sizeof(int64_t)),
+                               to_array("q", breaktimes, n * sizeof(int64_t)),
+                               to_array("q", speeds, n * sizeof(int64_t))};
+        PyObject* result = NULL;
+        if (arrays[0] && arrays[1] && arrays[2] && arrays[3]) {
+                result = Py_BuildValue("{sOsOsOsO}", "result", arrays[0],
+                                       "now", arrays[1], "events", arrays[2],
+                                       "jobsdone", arrays[3]);
+        }
+        for (int i = 0; i < 4; i++) {
+                Py_XDECREF(arrays[i]);
+        }
+        return result;
+}
+
+static PyObject* simulate(PyObject* self, PyObject* args, PyObject* kwds) {
+        (void)self;
+        static char* kwlist[] = {"tasksystem", "seeds",   "breaktime",
+                                 "speed",      "overrun", "threads",
+                                 "readyq",     "arrivalq", "rng",
+                                 NULL};
+        TaskSystem* tsy;
+        PyObject* cols[4] = {NULL, NULL, NULL, NULL};
+        PyObject* readyqobj = NULL;
+        PyObject* arrivalqobj = NULL;
+        PyObject* rngobj = NULL;
+        thready_options o;
+        thready_options_default(&o);
+        o.threads = 0;
+        if (!PyArg_ParseTupleAndKeywords(
+                args, kwds, "O!OO|OOiUUU", kwlist, &TaskSystemType, &tsy,
+                cols, cols + 1, cols + 2, cols + 3, &o.threads, &readyqobj,
+                &arrivalqobj, &rngobj)) {
+                return NULL;
+        }
+        if (!tsy->tsy) {
+                PyErr_SetString(PyExc_ValueError, "task system not created");
+                return NULL;
+        }
+        int readyq = o.readyq;
+        int arrivalq = o.arrivalq;
+        int rng = o.rng;
+        if (read_choice(readyqobj, readyqs, 3, &readyq, "readyq") ||
+            read_choice(arrivalqobj, arrivalqs, 3, &arrivalq, "arrivalq") ||
+            read_choice(rngobj, rngs, 3, &rng, "rng")) {
+                return NULL;
+        }
+        o.readyq = readyq;
+        o.arrivalq = arrivalq;
+        o.rng = rng;
+        o.threads = o.threads > 0 ? o.threads : replicate_threads();
+
+        Py_ssize_t n = column_length(cols[0], "seeds");
+        if (n < 0) {
+                return NULL;
+        }
+        int64_t* values = PyMem_Calloc(4 * n + 1, sizeof(int64_t));
+        thready_run* runs = PyMem_Calloc(n + 1, sizeof(thready_run));
+        thready_outcome* outcomes =
+            PyMem_Calloc(n + 1, sizeof(thready_outcome));
+        PyObject* result = NULL;
+        if (values && runs && outcomes) {
+                result = run_batch(tsy, cols, n, &o, values, runs, outcomes);
+        } else {
+                PyErr_NoMemory();
+        }
+        PyMem_Free(values);
+        PyMem_Free(runs);
+        PyMem_Free(outcomes);
+        return result;
+}
+
+static PySequenceMethods TaskSystem_as_sequence = {
+    .sq_length = (lenfunc)TaskSystem_len,
+};
+
+static PyMethodDef TaskSystem_methods[] = {
+    {"from_json", (PyCFunction)TaskSystem_from_json, METH_O | METH_CLASS,
+     "Task system from the JSON format of thready, as str or bytes."},
+    {NULL, NULL, 0, NULL}};
+
+static PyTypeObject TaskSystemType = {
+    PyVarObject_HEAD_INIT(NULL, 0).tp_name = "thready.TaskSystem",
+    .tp_doc = "TaskSystem(ids, periods, reldeads, comp, prob, beta)\n\n"
+              "Task system of n tasks, comp and prob holding six and two "
+              "values per task.",
+    .tp_basicsize = sizeof(TaskSystem),
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_new = PyType_GenericNew,
+    .tp_init = (initproc)TaskSystem_init,
+    .tp_dealloc = (destructor)TaskSystem_dealloc,
+    .tp_as_sequence = &TaskSystem_as_sequence,
+    .tp_methods = TaskSystem_methods,
+};
+
+static PyMethodDef module_methods[] = {
+    {"simulate", (PyCFunction)(void (*)(void))simulate,
+     METH_VARARGS | METH_KEYWORDS,
+     "simulate(tasksystem, seeds, breaktime, speed=1, overrun='none', "
+     "threads=0, readyq='heap', arrivalq='array', rng='shared')\n\n"
+     "Simulate one run per seed from time zero on threads, all processors "
+     "if 0. breaktime, speed and overrun (0 none, 1 break, 2 first) are "
+     "single values or one per seed. Returns a dict of arrays result, now, "
+     "events and jobsdone, result 0 ok, 1 deadline miss, 2 pass, 3 overrun."},
+    {NULL, NULL, 0, NULL}};
+
+static struct PyModuleDef module = {
+    PyModuleDef_HEAD_INIT, "thready",
+    "Batches of thready simulations without files or text output.", -1,
+    module_methods, NULL, NULL, NULL, NULL};
+
+PyMODINIT_FUNC PyInit_thready(void) {
+        if (PyType_Ready(&TaskSystemType) < 0) {
+                return NULL;
+        }
+        PyObject* m = PyModule_Create(&module);
+        if (!m) {
+                return NULL;
+        }
+        Py_INCREF(&TaskSystemType);
+        if (PyModule_AddObject(m, "TaskSystem", (PyObject*)&TaskSystemType) ||
+            PyModule_AddStringConstant(m, "version", thready_version())) {
+                Py_DECREF(&TaskSystemType);
+                Py_DECREF(m);
+                return NULL;
+        }
+        return m;
+}
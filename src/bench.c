@@ -0,0 +1,568 @@
+/*
+thready - A lightweight and fast scheduling simulator
+Written in 2019 by Robert Schmidt <rschmidt@uni-bremen.de>
+To the extent possible under law, the author(s) have dedicated all copyright and
+related and neighboring rights to this software to the public domain worldwide.
+This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with
+this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+#define _POSIX_C_SOURCE 199309L  // clock_gettime
+#define _DEFAULT_SOURCE          // syscall
+#include "bench.h"
+#include <inttypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "eventloop.h"
+#include "json.h"
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifndef VERSION
+#define VERSION "unknown"
+#endif
+
+#define NOHI "test/p41-ts-nointerarrival-nohi.json"
+#define HALFHI "test/p41-ts-nointerarrival-0.5hi.json"
+#define GEN1000 "test/gen-1000-0.9.json"  // made by thready-gen, see README
+#define BENCH_CHUNK 4096  // jobs generated or queued per counted block
+
+// Client requests of valgrind.h and callgrind.h
+#define VALGRIND_RUNNING 0x1001
+#define CALLGRIND_DUMP_STATS (('C' << 24) | ('T' << 16))
+#define CALLGRIND_TOGGLE_COLLECT (CALLGRIND_DUMP_STATS + 2)
+#define COUNTER_CALLGRIND (-2)  // counter handle when counting by callgrind
+
+bench_workload const bench_workloads[] = {
+    {"nohi", NOHI, 36000000, 1, JOBQ_HEAP, JOBGEN_ARRAY, JOBGEN_RNG_SHARED},
+    {"nohi-pertask", NOHI, 36000000, 1, JOBQ_PERTASK, JOBGEN_ARRAY,
+     JOBGEN_RNG_SHARED},
+    {"nohi-calendar", NOHI, 36000000, 1, JOBQ_CALENDAR, JOBGEN_CALENDAR,
+     JOBGEN_RNG_SHARED},
+    {"nohi-counter", NOHI, 36000000, 1, JOBQ_HEAP, JOBGEN_ARRAY,
+     JOBGEN_RNG_COUNTER},
+    {"halfhi-speed2", HALFHI, 36000000, 2, JOBQ_HEAP, JOBGEN_ARRAY,
+     JOBGEN_RNG_SHARED},
+    {"gen1000", GEN1000, 360000000, 1, JOBQ_HEAP, JOBGEN_ARRAY,
+     JOBGEN_RNG_SHARED},
+    {"gen1000-calendar", GEN1000, 360000000, 1, JOBQ_HEAP, JOBGEN_CALENDAR,
+     JOBGEN_RNG_SHARED},
+    {NULL, NULL, 0, 0, JOBQ_HEAP, JOBGEN_ARRAY, JOBGEN_RNG_SHARED}};
+
+/* State of reading results, the last key and whether inside the timings */
+typedef struct {
+        bench_result* r;
+        int n;
+        int cap;
+        char key[BENCH_NAMELEN];
+        bool timings;
+} reader;
+
+double bench_seconds(void) {
+        struct timespec t;
+        clock_gettime(CLOCK_MONOTONIC, &t);
+        return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+void* bench_calloc(size_t const n, size_t const size) {
+        void* p = calloc(n, size);
+        if (!p) {  // GCOVR_EXCL_START
+                fprintf(stderr, "error allocating memory for benchmark\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        return p;
+}
+
+static int compare_double(void const* a, void const* b) {
+        double const x = *(double const*)a;
+        double const y = *(double const*)b;
+        return (x > y) - (x < y);
+}
+
+static double* sorted(double const* const values, int const n) {
+        double* s = malloc((n ? n : 1) * sizeof(double));
+        if (!s) {  // GCOVR_EXCL_START
+                fprintf(stderr, "error allocating memory\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        memcpy(s, values, n * sizeof(double));
+        qsort(s, n, sizeof(double), compare_double);
+        return s;
+}
+
+bench_workload const* bench_find(char const* name) {
+        for (bench_workload const* w = bench_workloads; w->name; w++) {
+                if (!strcmp(w->name, name)) {
+                        return w;
+                }
+        }
+        return NULL;
+}
+
+void bench_run(ts const* const tsy,
+               bench_workload const* const w,
+               uint32_t const seed,
+               JOB_INT const breaktime,
+               int const warmup,
+               int const reps,
+               bench_result* const r) {
+        memset(r, 0, sizeof(bench_result));
+        strncpy(r->name, w->name, BENCH_NAMELEN - 1);
+        r->n = reps;
+        r->nspe = bench_calloc(reps, sizeof(double));
+        JOB_INT const t = breaktime > 0 ? breaktime : w->breaktime;
+        for (int i = -warmup; i < reps; i++) {
+                jobgen* jg = jobgen_init(tsy, seed, true, w->arrivalq, w->rng);
+                eventloop* evl = eventloop_init(jg, true, false, w->readyq);
+                eventloop_set_quiet(evl, true);
+                double const start = bench_seconds();
+                eventloop_run(evl, t, w->speed, false);
+                double const elapsed = bench_seconds() - start;
+                r->events = eventloop_get_events(evl);
+                r->jobsdone = eventloop_get_jobsdone(evl);
+                if (i >= 0) {
+                        r->nspe[i] =
+                            elapsed * 1e9 / (r->events ? r->events : 1);
+                }
+                eventloop_free(evl);
+                jobgen_free(jg);
+        }
+}
+
+/* Client request to valgrind as issued by valgrind.h, a no-op without */
+static uint64_t valgrind_request(uint64_t const request) {
+#if defined(__x86_64__) && defined(__GNUC__)
+        volatile uint64_t args[6] = {request, 0, 0, 0, 0, 0};
+        uint64_t result = 0;
+        __asm__ volatile(
+            "rolq $3, %%rdi; rolq $13, %%rdi\n\t"
+            "rolq $61, %%rdi; rolq $51, %%rdi\n\t"
+            "xchgq %%rbx, %%rbx"
+            : "=d"(result)
+            : "a"(&args[0]), "0"(result)
+            : "cc", "memory");
+        return result;
+#else
+        (void)request;
+        return 0;
+#endif
+}
+
+/* Instructions collected by callgrind since its last dump, read back from
+ * the dump file named by default, or -1 if not run by callgrind */
+static double callgrind_dump(void) {  // GCOVR_EXCL_START
+        double count = -1.0;
+#ifdef __linux__
+        static int dumps;
+        valgrind_request(CALLGRIND_DUMP_STATS);
+        char fname[64];
+        snprintf(fname, sizeof(fname), "callgrind.out.%ld.%d",
+                 (long)getpid(), ++dumps);
+        FILE* stream = fopen(fname, "r");
+        if (!stream) {
+                return count;
+        }
+        char line[256];
+        while (count < 0.0 && fgets(line, sizeof(line), stream)) {
+                if (!strncmp(line, "summary:", 8) ||
+                    !strncmp(line, "totals:", 7)) {
+                        count = strtod(strchr(line, ':') + 1, NULL);
+                }
+        }
+        fclose(stream);
+        remove(fname);
+#endif
+        return count;
+}  // GCOVR_EXCL_STOP
+
+/* Counter of the user space instructions of this thread, the hardware counter
+ * or else callgrind, or -1 */
+static int counter_open(void) {
+#ifdef __linux__
+        struct perf_event_attr a;
+        memset(&a, 0, sizeof(a));
+        a.type = PERF_TYPE_HARDWARE;
+        a.size = sizeof(a);
+        a.config = PERF_COUNT_HW_INSTRUCTIONS;
+        a.disabled = 1;
+        a.exclude_kernel = 1;
+        a.exclude_hv = 1;
+        int const fd = (int)syscall(SYS_perf_event_open, &a, 0, -1, -1, 0);
+        if (fd < 0 && valgrind_request(VALGRIND_RUNNING)) {
+                return COUNTER_CALLGRIND;  // GCOVR_EXCL_LINE
+        }
+        return fd;
+#else
+        return -1;
+#endif
+}
+
+/* Without counter, the measured code runs uncounted */
+static void counter_enable(int const fd, bool const enable) {
+        if (fd == COUNTER_CALLGRIND) {
+                valgrind_request(CALLGRIND_TOGGLE_COLLECT);  // GCOVR_EXCL_LINE
+        }
+#ifdef __linux__
+        if (fd >= 0) {
+                ioctl(fd, enable ? PERF_EVENT_IOC_ENABLE
+                                 : PERF_EVENT_IOC_DISABLE,
+                      0);
+        }
+#else
+        (void)enable;
+#endif
+}
+
+/* Instructions counted, or -1 if callgrind did not dump them */
+static double counter_close(int const fd) {
+        if (fd == COUNTER_CALLGRIND) {
+                return callgrind_dump();  // GCOVR_EXCL_LINE
+        }
+        uint64_t count = 0;
+#ifdef __linux__
+        if (fd >= 0) {
+                if (read(fd, &count, sizeof(count)) != sizeof(count)) {
+                        count = 0;
+                }
+                close(fd);
+        }
+#endif
+        return (double)count;
+}
+
+bool bench_counter_available(void) {
+        int const fd = counter_open();
+        double const count = counter_close(fd);
+        return fd != -1 && count >= 0.0;
+}
+
+bool bench_count(ts const* const tsy,
+                 bench_workload const* const w,
+                 uint32_t const seed,
+                 JOB_INT const breaktime,
+                 bench_result* const r) {
+        memset(r, 0, sizeof(bench_result));
+        strncpy(r->name, w->name, BENCH_NAMELEN - 1);
+        JOB_INT const t = breaktime > 0 ? breaktime : w->breaktime;
+        int fd = -1;
+        // The first run fills the job pool, the second is counted
+        for (int i = 0; i < 2; i++) {
+                jobgen* jg = jobgen_init(tsy, seed, true, w->arrivalq, w->rng);
+                eventloop* evl = eventloop_init(jg, true, false, w->readyq);
+                eventloop_set_quiet(evl, true);
+                fd = i ? counter_open() : -1;
+                counter_enable(fd, true);
+                eventloop_run(evl, t, w->speed, false);
+                counter_enable(fd, false);
+                r->events = eventloop_get_events(evl);
+                r->jobsdone = eventloop_get_jobsdone(evl);
+                eventloop_free(evl);
+                jobgen_free(jg);
+        }
+        bool const counted = fd != -1;
+        r->instructions.eventloop =
+            counter_close(fd) / (r->events ? r->events : 1);
+        int64_t const total = r->jobsdone ? r->jobsdone : 1;
+        job* jobs[BENCH_CHUNK];
+
+        // Generation of as many jobs as the simulation finished
+        jobgen* jg = jobgen_init(tsy, seed, true, w->arrivalq, w->rng);
+        fd = counter_open();
+        for (int64_t done = 0; done < total; done += BENCH_CHUNK) {
+                int const k = total - done < BENCH_CHUNK ? (int)(total - done)
+                                                         : BENCH_CHUNK;
+                counter_enable(fd, true);
+                for (int i = 0; i < k; i++) {
+                        jobs[i] = jobgen_rise(jg);
+                }
+                counter_enable(fd, false);
+                for (int i = 0; i < k; i++) {
+                        job_free(jobs[i]);
+                }
+        }
+        r->instructions.jobgen = counter_close(fd) / total;
+        jobgen_free(jg);
+
+        // Steady scheduler queue of one job per task, each generated job is
+        // inserted and the earliest deadline popped
+        jg = jobgen_init(tsy, seed, true, w->arrivalq, w->rng);
+        jobq* jq = jobq_init_as(w->readyq, tsy);
+        for (int i = 0; i < ts_length(tsy); i++) {
+                jobq_insert_by(jq, jobgen_rise(jg), job_get_deadline);
+        }
+        fd = counter_open();
+        for (int64_t done = 0; done < total; done += BENCH_CHUNK) {
+                int const k = total - done < BENCH_CHUNK ? (int)(total - done)
+                                                         : BENCH_CHUNK;
+                for (int i = 0; i < k; i++) {
+                        jobs[i] = jobgen_rise(jg);
+                }
+                counter_enable(fd, true);
+                for (int i = 0; i < k; i++) {
+                        jobq_insert_by(jq, jobs[i], job_get_deadline);
+                        jobs[i] = jobq_pop(jq);
+                }
+                counter_enable(fd, false);
+                for (int i = 0; i < k; i++) {
+                        job_free(jobs[i]);
+                }
+        }
+        r->instructions.jobq = counter_close(fd) / total;
+        jobq_free(jq);
+        jobgen_free(jg);
+        r->counted = counted;
+        return counted;
+}
+
+void bench_result_free(bench_result* const r) {
+        free(r->nspe);
+        r->nspe = NULL;
+        r->n = 0;
+}
+
+double bench_quantile(double const* const values,
+                      int const n,
+                      double const q) {
+        if (n < 1) {
+                return NAN;
+        }
+        double* s = sorted(values, n);
+        double const pos = q * (n - 1);
+        int const lo = (int)pos;
+        int const hi = lo + 1 < n ? lo + 1 : lo;
+        double const v = s[lo] + (pos - lo) * (s[hi] - s[lo]);
+        free(s);
+        return v;
+}
+
+bench_summary bench_summarize(bench_result const* const r) {
+        bench_summary s;
+        s.median = bench_quantile(r->nspe, r->n, 0.5);
+        s.p95 = bench_quantile(r->nspe, r->n, 0.95);
+        s.events_per_sec = 1e9 / s.median;
+        s.jobs_per_sec =
+            s.events_per_sec * r->jobsdone / (r->events ? r->events : 1);
+        return s;
+}
+
+double bench_mannwhitney(double const* const a,
+                         int const na,
+                         double const* const b,
+                         int const nb) {
+        int const n = na + nb;
+        if (na < 1 || nb < 1) {
+                return 1.0;
+        }
+        // Rank the pooled values, ties get the mean of their ranks
+        double* pool = malloc(n * sizeof(double));
+        if (!pool) {  // GCOVR_EXCL_START
+                fprintf(stderr, "error allocating memory\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        memcpy(pool, a, na * sizeof(double));
+        memcpy(pool + na, b, nb * sizeof(double));
+        double* s = sorted(pool, n);
+        free(pool);
+        double ranksum = 0.0;
+        for (int i = 0; i < na; i++) {
+                int below = 0;
+                int equal = 0;
+                for (int j = 0; j < n; j++) {
+                        below += s[j] < a[i];
+                        equal += s[j] == a[i];
+                }
+                ranksum += below + (equal + 1) / 2.0;
+        }
+        double ties = 0.0;
+        for (int i = 0; i < n;) {
+                int j = i;
+                while (j < n && s[j] == s[i]) {
+                        j++;
+                }
+                double const t = j - i;
+                ties += t * t * t - t;
+                i = j;
+        }
+        free(s);
+        double const u = ranksum - na * (na + 1) / 2.0;
+        double const mean = na * (double)nb / 2.0;
+        double const var = na * (double)nb / 12.0 *
+                           ((n + 1) - ties / ((double)n * (n - 1)));
+        if (var <= 0.0) {
+                return 1.0;
+        }
+        double const z = fmax(fabs(u - mean) - 0.5, 0.0) / sqrt(var);
+        return erfc(z / sqrt(2.0));
+}
+
+bench_comparison bench_compare(bench_result const* const base,
+                               bench_result const* const r) {
+        bench_comparison c;
+        double const before = bench_quantile(base->nspe, base->n, 0.5);
+        c.change = bench_quantile(r->nspe, r->n, 0.5) / before - 1.0;
+        c.p = bench_mannwhitney(base->nspe, base->n, r->nspe, r->n);
+        return c;
+}
+
+void bench_write_json(FILE* stream,
+                      bench_result const* const r,
+                      int const n,
+                      uint32_t const seed,
+                      int const warmup) {
+        fprintf(stream, "{\n  \"version\": \"%s\",\n", VERSION);
+        fprintf(stream, "  \"seed\": %" PRIu32 ",\n", seed);
+        fprintf(stream, "  \"warmup\": %d,\n", warmup);
+        fprintf(stream, "  \"workloads\": [");
+        for (int i = 0; i < n; i++) {
+                fprintf(stream, "%s\n    {\n", i ? "," : "");
+                fprintf(stream, "      \"name\": \"%s\",\n", r[i].name);
+                fprintf(stream, "      \"repetitions\": %d,\n", r[i].n);
+                fprintf(stream, "      \"events\": %" PRId64 ",\n",
+                        r[i].events);
+                fprintf(stream, "      \"jobsdone\": %" PRId64, r[i].jobsdone);
+                if (r[i].counted) {
+                        bench_instructions const* c = &r[i].instructions;
+                        fprintf(stream,
+                                ",\n      \"instructions_per_event\": %.2f",
+                                c->eventloop);
+                        fprintf(stream,
+                                ",\n      \"instructions_per_job\": %.2f",
+                                c->jobgen);
+                        fprintf(stream,
+                                ",\n      \"instructions_per_queue_op\": %.2f",
+                                c->jobq);
+                }
+                if (r[i].n) {
+                        bench_summary const s = bench_summarize(r + i);
+                        fprintf(stream, ",\n      \"events_per_sec\": %.0f",
+                                s.events_per_sec);
+                        fprintf(stream, ",\n      \"jobs_per_sec\": %.0f",
+                                s.jobs_per_sec);
+                        fprintf(stream,
+                                ",\n      \"ns_per_event_median\": %.4f",
+                                s.median);
+                        fprintf(stream, ",\n      \"ns_per_event_p95\": %.4f",
+                                s.p95);
+                        fprintf(stream, ",\n      \"ns_per_event\": [");
+                        for (int j = 0; j < r[i].n; j++) {
+                                fprintf(stream, "%s%.4f", j ? ", " : "",
+                                        r[i].nspe[j]);
+                        }
+                        fprintf(stream, "]");
+                }
+                fprintf(stream, "\n    }");
+        }
+        fprintf(stream, "\n  ]\n}\n");
+}
+
+static bench_result* last(reader* rd) {
+        return rd->n ? rd->r + rd->n - 1 : NULL;
+}
+
+static int callback_result(void* userdata,
+                           int type,
+                           const char* data,
+                           uint32_t length) {
+        reader* rd = userdata;
+        bench_result* r = last(rd);
+        switch (type) {
+                case JSON_KEY:
+                        length = length < BENCH_NAMELEN ? length
+                                                        : BENCH_NAMELEN - 1;
+                        memcpy(rd->key, data, length);
+                        rd->key[length] = '\0';
+                        break;
+                case JSON_ARRAY_BEGIN:
+                        rd->timings = r && !strcmp(rd->key, "ns_per_event");
+                        break;
+                case JSON_ARRAY_END:
+                        rd->timings = false;
+                        break;
+                case JSON_STRING:
+                        if (strcmp(rd->key, "name")) {
+                                break;
+                        }
+                        if (rd->n == rd->cap) {
+                                rd->cap = rd->cap ? 2 * rd->cap : 8;
+                                r = realloc(rd->r,
+                                            rd->cap * sizeof(bench_result));
+                                if (!r) {  // GCOVR_EXCL_START
+                                        fprintf(stderr,
+                                                "error allocating memory\n");
+                                        exit(EXIT_FAILURE);
+                                }  // GCOVR_EXCL_STOP
+                                rd->r = r;
+                        }
+                        r = rd->r + rd->n++;
+                        memset(r, 0, sizeof(bench_result));
+                        length = length < BENCH_NAMELEN ? length
+                                                        : BENCH_NAMELEN - 1;
+                        memcpy(r->name, data, length);
+                        break;
+                case JSON_INT:
+                case JSON_FLOAT:
+                        if (!r) {
+                                break;
+                        }
+                        if (rd->timings) {
+                                // Grows by one, results hold few repetitions
+                                double* t = realloc(
+                                    r->nspe, (r->n + 1) * sizeof(double));
+                                if (!t) {  // GCOVR_EXCL_START
+                                        fprintf(stderr,
+                                                "error allocating memory\n");
+                                        exit(EXIT_FAILURE);
+                                }  // GCOVR_EXCL_STOP
+                                r->nspe = t;
+                                r->nspe[r->n++] = strtod(data, NULL);
+                        } else if (!strcmp(rd->key, "events")) {
+                                r->events = strtoll(data, NULL, 10);
+                        } else if (!strcmp(rd->key, "jobsdone")) {
+                                r->jobsdone = strtoll(data, NULL, 10);
+                        } else if (!strcmp(rd->key,
+                                           "instructions_per_event")) {
+                                r->instructions.eventloop = strtod(data, NULL);
+                                r->counted = true;
+                        } else if (!strcmp(rd->key, "instructions_per_job")) {
+                                r->instructions.jobgen = strtod(data, NULL);
+                        } else if (!strcmp(rd->key,
+                                           "instructions_per_queue_op")) {
+                                r->instructions.jobq = strtod(data, NULL);
+                        }
+                        break;
+        }
+        return 0;
+}
+
+int bench_read_json(FILE* stream, bench_result** r) {
+        reader rd;
+        memset(&rd, 0, sizeof(reader));
+        json_parser p;
+        json_config cfg = {0};
+        if (json_parser_init(&p, &cfg, callback_result,
+                             &rd)) {  // GCOVR_EXCL_START
+                fprintf(stderr, "json parser init fail\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        char block[1024];
+        size_t len;
+        while ((len = fread(block, 1, sizeof(block), stream)) > 0) {
+                uint32_t processed = 0;
+                if (json_parser_string(&p, block, len,
+                                       &processed)) {  // GCOVR_EXCL_START
+                        fprintf(stderr, "error parsing json at char %d\n",
+                                processed);
+                        exit(EXIT_FAILURE);
+                }  // GCOVR_EXCL_STOP
+        }
+        json_parser_free(&p);
+        *r = rd.r;
+        return rd.n;
+}
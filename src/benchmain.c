@@ -0,0 +1,350 @@
+/*
+thready - A lightweight and fast scheduling simulator
+Written in 2019 by Robert Schmidt <rschmidt@uni-bremen.de>
+To the extent possible under law, the author(s) have dedicated all copyright and
+related and neighboring rights to this software to the public domain worldwide.
+This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with
+this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+/**
+ * @file benchmain.c
+ * @author Robert Schmidt
+ * @brief Command line parsing, measurement and comparison of thready-bench.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "job.h"
+#include "parg.h"
+#include "ts.h"
+
+#define BENCH_MAXWORKLOADS 64
+
+static void list(void) {
+        for (bench_workload const* w = bench_workloads; w->name; w++) {
+                printf("%s %s breaktime %lld speed %lld\n", w->name,
+                       w->tasksystem, (long long)w->breaktime,
+                       (long long)w->speed);
+        }
+}
+
+static bench_result* read_results(char const* fname, int* n) {
+        FILE* stream = fopen(fname, "r");
+        if (!stream) {
+                fprintf(stderr, "can't open results '%s'\n", fname);
+                exit(EXIT_FAILURE);
+        }
+        bench_result* r;
+        *n = bench_read_json(stream, &r);
+        fclose(stream);
+        return r;
+}
+
+static bench_result const* find(bench_result const* base,
+                                int const nbase,
+                                char const* name) {
+        for (int j = 0; j < nbase; j++) {
+                if (!strcmp(base[j].name, name)) {
+                        return base + j;
+                }
+        }
+        return NULL;
+}
+
+/* Print instruction counts of r and base, returns whether not more */
+static bool compare_count(char const* workload,
+                          char const* component,
+                          double const base,
+                          double const count,
+                          double const threshold) {
+        double const change = count / base - 1.0;
+        char const* verdict = "same";
+        if (change > threshold) {
+                verdict = "more";
+        } else if (change < -threshold) {
+                verdict = "fewer";
+        }
+        printf("%s,%s,%.2f,%.2f,%+.2f%%,%s\n", workload, component, base,
+               count, change * 100.0, verdict);
+        return change <= threshold;
+}
+
+/* Compare instructions of r to base, returns whether none exceeds threshold
+ * or is missing */
+static bool compare_instructions(bench_result const* base,
+                                 int const nbase,
+                                 bench_result const* r,
+                                 int const n,
+                                 double const threshold) {
+        bool ok = true;
+        printf(
+            "workload,component,baseline_instructions,instructions,change,"
+            "verdict\n");
+        for (int i = 0; i < n; i++) {
+                bench_result const* b = find(base, nbase, r[i].name);
+                if (!b || !b->counted || !r[i].counted) {
+                        printf("%s,,,,,missing\n", r[i].name);
+                        ok = false;
+                        continue;
+                }
+                bench_instructions const* x = &b->instructions;
+                bench_instructions const* y = &r[i].instructions;
+                ok &= compare_count(r[i].name, "eventloop_run", x->eventloop,
+                                    y->eventloop, threshold);
+                ok &= compare_count(r[i].name, "jobgen_rise", x->jobgen,
+                                    y->jobgen, threshold);
+                ok &= compare_count(r[i].name, "jobq", x->jobq, y->jobq,
+                                    threshold);
+        }
+        return ok;
+}
+
+/* Compare timings of r to base, returns whether none is slower or missing */
+static bool compare_timings(bench_result const* base,
+                            int const nbase,
+                            bench_result const* r,
+                            int const n,
+                            double const alpha,
+                            double const threshold) {
+        bool ok = true;
+        printf(
+            "workload,baseline_ns_per_event,ns_per_event,change,p,verdict\n");
+        for (int i = 0; i < n; i++) {
+                bench_result const* b = find(base, nbase, r[i].name);
+                if (!b || !b->n || !r[i].n) {
+                        printf("%s,,,,,missing\n", r[i].name);
+                        ok = false;
+                        continue;
+                }
+                bench_comparison const c = bench_compare(b, r + i);
+                char const* verdict = "same";
+                if (c.p < alpha && c.change > threshold) {
+                        verdict = "slower";
+                        ok = false;
+                } else if (c.p < alpha && c.change < -threshold) {
+                        verdict = "faster";
+                }
+                printf("%s,%.4f,%.4f,%+.2f%%,%.4g,%s\n", r[i].name,
+                       bench_summarize(b).median,
+                       bench_summarize(r + i).median, c.change * 100.0, c.p,
+                       verdict);
+        }
+        return ok;
+}
+
+/* Compare the results of fname to baseline, instructions if counted */
+static bool compare(char const* baseline,
+                    char const* fname,
+                    double const alpha,
+                    double const threshold) {
+        int nbase;
+        int n;
+        bench_result* base = read_results(baseline, &nbase);
+        bench_result* r = read_results(fname, &n);
+        bool const ok =
+            n && r[0].counted
+                ? compare_instructions(base, nbase, r, n, threshold)
+                : compare_timings(base, nbase, r, n, alpha, threshold);
+        for (int j = 0; j < nbase; j++) {
+                bench_result_free(base + j);
+        }
+        for (int i = 0; i < n; i++) {
+                bench_result_free(r + i);
+        }
+        free(base);
+        free(r);
+        return ok;
+}
+
+int main(int argc, char* argv[]) {
+        bench_workload const* workloads[BENCH_MAXWORKLOADS];
+        int nworkloads = 0;
+        int reps = 10;
+        int warmup = 1;
+        uint32_t seed = 1;
+        JOB_INT breaktime = 0;
+        char const* output = NULL;
+        char const* baseline = NULL;
+        char const* current = NULL;
+        double alpha = 0.01;
+        double threshold = 0.02;
+        bool count = false;
+
+        struct parg_state ps;
+        int c;
+        parg_init(&ps);
+        // abcdefghijklmnopqrstuvwxyz ABCDEFGHIJKLMNOPQRSTUVWXYZ
+        // x x    xx  x  x  x xxxxx x
+        while ((c = parg_getopt(&ps, argc, argv, "hvliw:r:u:z:t:o:c:a:x:")) !=
+               -1) {
+                switch (c) {
+                        case 1:  // Current results compared to baseline
+                                current = ps.optarg;
+                                break;
+                        case 'h':
+                                printf(
+                                    "Usage: thready-bench [-h] [-v] [-l] "
+                                    "[-w workload ...] [-r repetitions] "
+                                    "[-u warmup] [-z seed] [-t breaktime] "
+                                    "[-o results.json]\n"
+                                    "       thready-bench -i "
+                                    "[-w workload ...] [-z seed] "
+                                    "[-t breaktime] [-o results.json]\n"
+                                    "       thready-bench -c baseline.json "
+                                    "[-a alpha] [-x threshold%%] "
+                                    "results.json\n");
+                                exit(EXIT_SUCCESS);
+                                break;
+                        case 'v':
+                                printf("thready-bench %s\n", VERSION);
+                                return EXIT_SUCCESS;
+                                break;
+                        case 'l':
+                                list();
+                                return EXIT_SUCCESS;
+                                break;
+                        case 'i':  // Count instructions instead of timing
+                                count = true;
+                                break;
+                        case 'w':
+                                if (nworkloads == BENCH_MAXWORKLOADS) {
+                                        fprintf(stderr,
+                                                "more than %d workloads\n",
+                                                BENCH_MAXWORKLOADS);
+                                        exit(EXIT_FAILURE);
+                                }
+                                workloads[nworkloads] = bench_find(ps.optarg);
+                                if (!workloads[nworkloads++]) {
+                                        fprintf(stderr,
+                                                "unknown workload '%s'\n",
+                                                ps.optarg);
+                                        exit(EXIT_FAILURE);
+                                }
+                                break;
+                        case 'r':
+                                reps = atoi(ps.optarg);
+                                break;
+                        case 'u':
+                                warmup = atoi(ps.optarg);
+                                break;
+                        case 'z':
+                                seed = strtoul(ps.optarg, NULL, 10);
+                                break;
+                        case 't':
+                                breaktime = strtoll(ps.optarg, NULL, 10);
+                                break;
+                        case 'o':
+                                output = ps.optarg;
+                                break;
+                        case 'c':
+                                baseline = ps.optarg;
+                                break;
+                        case 'a':
+                                alpha = atof(ps.optarg);
+                                break;
+                        case 'x':
+                                threshold = atof(ps.optarg) / 100.0;
+                                break;
+                        case '?':
+                                if (strchr("wruztocax", ps.optopt)) {
+                                        printf(
+                                            "option -%c requires an argument\n",
+                                            ps.optopt);
+                                } else {
+                                        printf("unknown option -%c\n",
+                                               ps.optopt);
+                                }
+                                exit(EXIT_FAILURE);
+                                break;
+                        default:
+                                printf("error: unhandled option -%c\n", c);
+                                exit(EXIT_FAILURE);
+                                break;
+                }
+        }
+
+        if (baseline) {
+                if (!current) {
+                        fprintf(stderr, "no results to compare specified\n");
+                        exit(EXIT_FAILURE);
+                }
+                return compare(baseline, current, alpha, threshold)
+                           ? EXIT_SUCCESS
+                           : EXIT_FAILURE;
+        }
+        if (count && !bench_counter_available()) {
+                fprintf(stderr,
+                        "no instruction counter, perf_event_open failed and "
+                        "not run by callgrind --collect-atstart=no\n");
+                exit(EXIT_FAILURE);
+        }
+        if (reps < 1 || warmup < 0) {
+                fprintf(stderr, "invalid number of repetitions\n");
+                exit(EXIT_FAILURE);
+        }
+        if (!nworkloads) {
+                for (bench_workload const* w = bench_workloads;
+                     w->name && nworkloads < BENCH_MAXWORKLOADS; w++) {
+                        workloads[nworkloads++] = w;
+                }
+        }
+
+        bench_result* r = calloc(nworkloads, sizeof(bench_result));
+        if (!r) {
+                fprintf(stderr, "error allocating memory\n");
+                exit(EXIT_FAILURE);
+        }
+        for (int i = 0; i < nworkloads; i++) {
+                FILE* stream = fopen(workloads[i]->tasksystem, "r");
+                if (!stream) {
+                        fprintf(stderr, "can't open task system '%s'\n",
+                                workloads[i]->tasksystem);
+                        exit(EXIT_FAILURE);
+                }
+                ts* tsy = ts_init();
+                ts_read_json(tsy, stream);
+                fclose(stream);
+                if (count) {
+                        bench_count(tsy, workloads[i], seed, breaktime, r + i);
+                        ts_free(tsy);
+                        bench_instructions const* n = &r[i].instructions;
+                        fprintf(stderr,
+                                "%s: %.2f instructions/event, %.2f "
+                                "instructions/job, %.2f instructions/queue "
+                                "operation\n",
+                                r[i].name, n->eventloop, n->jobgen, n->jobq);
+                        continue;
+                }
+                bench_run(tsy, workloads[i], seed, breaktime, warmup, reps,
+                          r + i);
+                ts_free(tsy);
+                bench_summary const s = bench_summarize(r + i);
+                fprintf(stderr,
+                        "%s: %.2f ns/event median, %.2f p95, "
+                        "%.0f events/second, %.0f jobs/second\n",
+                        r[i].name, s.median, s.p95, s.events_per_sec,
+                        s.jobs_per_sec);
+        }
+
+        FILE* stream = output ? fopen(output, "w") : stdout;
+        if (!stream) {
+                fprintf(stderr, "result io error\n");
+                exit(EXIT_FAILURE);
+        }
+        bench_write_json(stream, r, nworkloads, seed, warmup);
+        if (output && fclose(stream)) {
+                fprintf(stderr, "result io error\n");
+                exit(EXIT_FAILURE);
+        }
+        for (int i = 0; i < nworkloads; i++) {
+                bench_result_free(r + i);
+        }
+        free(r);
+        job_pool_free();
+        return EXIT_SUCCESS;
+}
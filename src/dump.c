@@ -7,170 +7,299 @@ This software is distributed without any warranty.
 You should have received a copy of the CC0 Public Domain Dedication along with
 this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
 */
+#define _POSIX_C_SOURCE 200112L  // fileno
 #include "dump.h"
 #include <errno.h>
-#include <float.h>
 #include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include "selist.h"
-
-void** merge(void** a, void** b, int na, int nb) {
-        void** r = calloc(na + nb, sizeof(void*));
-        if (r) {
-                memcpy(r, a, na * sizeof(void*));
-                memcpy(r + na, b, nb * sizeof(void*));
-        }
-        return r;
-}
-
-static int compare_ptr_descending(const void* a, const void* b) {
-        uintptr_t* x = (uintptr_t*)a;
-        uintptr_t* y = (uintptr_t*)b;
-        if (*x < *y) {
-                return 1;      // Return -1 if you want ascending, 1 if you want
-                               // descending order
-        } else if (*x > *y) {  // GCOVR_EXCL_START
-                return -1;     // Return 1 if you want ascending, -1 if you want
-                               // descending order
-        }                      // GCOVR_EXCL_STOP
-        return 0;
-}
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-int uniq(void* const* const src, void** dst, int n) {
-        void** dup = calloc(n, sizeof(void*));
-        if (dup) {
-                memcpy(dup, src, n * sizeof(void*));
-        } else {  // GCOVR_EXCL_START
-                return 0;
-        }  // GCOVR_EXCL_STOP
-        qsort(dup, n, sizeof(void*), compare_ptr_descending);
-
-        void* last = (void*)0;
-        int k = 0;
-        for (int i = 0; i < n; i++) {
-                void* next = *(dup + i);
-                if (next != last) {
-                        *(dst + k) = next;
-                        last = next;
-                        k++;
+void dump_reader_init(dump_reader* r, FILE* stream) {
+        memset(r, 0, sizeof(dump_reader));
+        struct stat st;
+        int fd = fileno(stream);
+        long offset = ftell(stream);
+        if (fd >= 0 && !fstat(fd, &st) && S_ISREG(st.st_mode) &&
+            st.st_size > 0 && offset >= 0 && offset <= st.st_size) {
+                r->map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (r->map != MAP_FAILED) {
+                        r->maplen = st.st_size;
+                        r->begin = r->map;
+                        r->pos = (char const*)r->map + offset;
+                        r->end = (char const*)r->map + r->maplen;
+                        return;
                 }
+                r->map = NULL;
         }
-        free(dup);
-        return k;
-}
-
-static int dump_json_tostream_cb(void* userdata,
-                                 const char* s,
-                                 uint32_t length) {
-        FILE* stream = userdata;
-        if (fwrite(s, sizeof(char), length, stream)) {
-                return 0;
-        } else {  // GCOVR_EXCL_START
-                return 1;
-        }  // GCOVR_EXCL_STOP
-}
-
-json_printer* dump_json_tostream_init(FILE* stream) {
-        json_printer* print = calloc(1, sizeof(json_printer));
-        if (print) {
-                if (json_print_init(print, dump_json_tostream_cb,
-                                    stream)) {  // GCOVR_EXCL_START
-                        fprintf(stderr, "error init dump json\n");
-                        exit(EXIT_FAILURE);
-                }  // GCOVR_EXCL_STOP
-        }
-        return print;
-}
-
-void dump_json_tostream_free(json_printer* p) {
-        json_print_free(p);
-        free(p);
-}
-
-void dump_json_tostream(json_printer* p, int64_t const data) {
-        char s[DUMP_BUFLEN] = "";
-        int slen = snprintf(s, DUMP_BUFLEN, "%" PRId64 "", data);
-        json_print_raw(p, JSON_INT, s, slen);
-}
-
-static int callback_append(void* userdata,
-                           int type,
-                           const char* data,
-                           __attribute__((unused)) uint32_t length) {
-        struct selist** l = userdata;
-        intmax_t* vali;
-        float* valf;
-        switch (type) {
-                case JSON_FLOAT:
-                        valf = calloc(1, sizeof(float));
-                        if (valf) {
-                                // See `man strtol` example for error handling
-                                errno = 0;
-                                *valf = strtof(data, NULL);
-                                if ((errno == ERANGE &&  // GCOVR_EXCL_START
-                                     (*valf == FLT_MAX || *valf == FLT_MIN)) ||
-                                    (errno != 0 && valf == 0)) {
-                                        fprintf(
-                                            stderr,
-                                            "error converting string to int\n");
-                                        exit(EXIT_FAILURE);
-                                }  // GCOVR_EXCL_STOP
-                                selist_push(l, valf);
-                        } else {  // GCOVR_EXCL_START
-                                fprintf(stderr, "error adding float value\n");
-                                exit(EXIT_FAILURE);
-                        }  // GCOVR_EXCL_STOP
-                        break;
-                case JSON_INT:
-                        vali = calloc(1, sizeof(intmax_t));
-                        if (vali) {
-                                *vali = strtoimax(data, NULL, 10);
-                                if (errno == ERANGE) {  // GCOVR_EXCL_START
-                                        fprintf(
-                                            stderr,
-                                            "error converting string to int\n");
-                                        exit(EXIT_FAILURE);
-                                }  // GCOVR_EXCL_STOP
-                                selist_push(l, vali);
-                        } else {  // GCOVR_EXCL_START
-                                fprintf(stderr, "error adding integer value\n");
+        // Streams which can not be mapped are read to a single buffer
+        size_t avail = 0;
+        size_t len = 0;
+        do {
+                if (len == avail) {
+                        avail = avail ? 2 * avail : DUMP_READLEN;
+                        char* buf = realloc(r->buf, avail);
+                        if (!buf) {  // GCOVR_EXCL_START
+                                fprintf(stderr,
+                                        "error allocating memory for json\n");
                                 exit(EXIT_FAILURE);
                         }  // GCOVR_EXCL_STOP
-                        break;
+                        r->buf = buf;
+                }
+                len += fread(r->buf + len, sizeof(char), avail - len, stream);
+        } while (len == avail);
+        r->begin = r->pos = r->buf;
+        r->end = r->buf + len;
+}
+
+void dump_reader_init_mem(dump_reader* r, char const* data, size_t len) {
+        memset(r, 0, sizeof(dump_reader));
+        r->begin = r->pos = data;
+        r->end = data + len;
+        r->memory = true;
+}
+
+void dump_reader_free(dump_reader* r) {
+        if (r->map) {
+                munmap(r->map, r->maplen);
+        }
+        free(r->buf);
+}
+
+char const* dump_reader_key(dump_reader const* r) {
+        return r->key;
+}
+
+char const* dump_reader_error(dump_reader const* r) {
+        return r->error;
+}
+
+/* A reader of memory ends its input at the first error, others exit */
+static void reader_error(dump_reader* r, char const* what) {
+        if (r->memory) {
+                r->error = r->error ? r->error : what;
+                r->pos = r->end;
+                r->scratch[0] = '\0';
+                return;
+        }
+        // GCOVR_EXCL_START
+        fprintf(stderr, "error parsing json at char %ld: %s\n",
+                (long)(r->pos - r->begin), what);
+        exit(EXIT_FAILURE);
+        // GCOVR_EXCL_STOP
+}
+
+static inline bool is_space(char const c) {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static inline bool is_digit(char const c) {
+        return c >= '0' && c <= '9';
+}
+
+static inline bool in_object(dump_reader const* r) {
+        return r->depth && ((r->objects >> (r->depth - 1)) & 1);
+}
+
+static inline bool expects_value(dump_reader const* r) {
+        return r->expect == DUMP_EXPECT_VALUE || r->expect == DUMP_EXPECT_FIRST;
+}
+
+/* A value is complete, the document if at the top level */
+static inline void reader_value(dump_reader* r) {
+        r->expect = r->depth ? DUMP_EXPECT_NEXT : DUMP_EXPECT_END;
+}
+
+/* Skip the string at the cursor; a key of the top level object is kept. */
+static void reader_string(dump_reader* r, bool const key) {
+        char const* start = ++r->pos;
+        char const* p = start;
+        while (p < r->end && *p != '"') {
+                p += (*p == '\\') ? 2 : 1;
+        }
+        if (p >= r->end) {
+                reader_error(r, "unterminated string");
+                return;
+        }
+        r->pos = p + 1;
+        if (key && r->depth == 1) {
+                size_t n = p - start;
+                n = n < DUMP_KEYLEN ? n : DUMP_KEYLEN - 1;
+                memcpy(r->key, start, n);
+                r->key[n] = '\0';
+        }
+}
+
+static char const* skip_digits(char const* p, char const* const end) {
+        while (p < end && is_digit(*p)) {
+                p++;
+        }
+        return p;
+}
+
+/* Copy the number at the cursor to the scratch buffer, true if floating
+ * point */
+static bool reader_number(dump_reader* r) {
+        char const* const start = r->pos;
+        char const* const end = r->end;
+        char const* p = start + (*start == '-');
+        char const* digits = p;
+        p = skip_digits(p, end);
+        bool isfloat = false;
+        bool ok = p > digits && (*digits != '0' || p - digits == 1);
+        if (ok && p < end && *p == '.') {
+                isfloat = true;
+                digits = ++p;
+                p = skip_digits(p, end);
+                ok = p > digits;
+        }
+        if (ok && p < end && (*p == 'e' || *p == 'E')) {
+                isfloat = true;
+                p++;
+                p += p < end && (*p == '+' || *p == '-');
+                digits = p;
+                p = skip_digits(p, end);
+                ok = p > digits;
+        }
+        if (!ok) {
+                reader_error(r, "invalid number");
+                return false;
+        }
+        if (p - start >= DUMP_BUFLEN) {
+                reader_error(r, "number too long");
+                return false;
+        }
+        memcpy(r->scratch, start, p - start);
+        r->scratch[p - start] = '\0';
+        r->pos = p;
+        return isfloat;
+}
+
+/* Length of the literal true, false, or null at the cursor, or zero */
+static size_t reader_literal(dump_reader const* r) {
+        char const* const literals[] = {"true", "false", "null"};
+        for (int i = 0; i < 3; i++) {
+                size_t const n = strlen(literals[i]);
+                if ((size_t)(r->end - r->pos) >= n &&
+                    !strncmp(r->pos, literals[i], n)) {
+                        return n;
+                }
         }
         return 0;
 }
 
-/* Fetch all numbers from JSON, ignore everything else */
-json_parser* dump_read_json_init(void* cb_data) {
-        json_parser* parser = calloc(1, sizeof(json_parser));
-        json_config cfg = {0};
-        cfg.allow_yaml_comments = 1;
-        if (json_parser_init(parser, &cfg, callback_append,
-                             cb_data)) {  // GCOVR_EXCL_START
-                fprintf(stderr, "json parser init fail\n");
-                exit(EXIT_FAILURE);
-        }  // GCOVR_EXCL_STOP
-        return parser;
-}
-
-void dump_read_json_parse(json_parser* p, FILE* stream) {
-        char block[1024];
-        int len;
-        while ((len = fread(&block, sizeof(char), 1024, stream)) > 0) {
-                uint32_t processed = 0;
-                int ret = json_parser_string(p, block, len, &processed);
-                if (ret) {  // GCOVR_EXCL_START
-                        fprintf(stderr, "error parsing json at char %d\n",
-                                processed);
-                        exit(EXIT_FAILURE);
-                }  // GCOVR_EXCL_STOP
-        }
-}
-
-void dump_read_json_free(json_parser* p) {
-        json_parser_free(p);
-        free(p);
+/* Open an array or object at the cursor */
+static void reader_open(dump_reader* r, bool const object) {
+        if (!expects_value(r)) {
+                reader_error(r, "unexpected bracket");
+        } else if (r->depth == DUMP_MAXDEPTH) {
+                reader_error(r, "nesting too deep");
+        } else {
+                uint64_t const bit = (uint64_t)1 << r->depth++;
+                r->objects = object ? r->objects | bit : r->objects & ~bit;
+                r->expect = object ? DUMP_EXPECT_FIRSTKEY : DUMP_EXPECT_FIRST;
+                r->pos++;
+        }
+}
+
+/* Close the array or object at the cursor */
+static void reader_close(dump_reader* r, bool const object) {
+        dump_expect const empty =
+            object ? DUMP_EXPECT_FIRSTKEY : DUMP_EXPECT_FIRST;
+        if (!r->depth || in_object(r) != object ||
+            (r->expect != DUMP_EXPECT_NEXT && r->expect != empty)) {
+                reader_error(r, "unbalanced brackets");
+        } else {
+                r->depth--;
+                reader_value(r);
+                r->pos++;
+        }
+}
+
+/* Advance to the next number. The scratch buffer is empty at end of input. */
+static bool reader_token(dump_reader* r) {
+        while (r->pos < r->end) {
+                char const c = *r->pos;
+                if (is_space(c)) {
+                        r->pos++;
+                } else if (c == '#') {  // yaml comment
+                        while (r->pos < r->end && *r->pos != '\n') {
+                                r->pos++;
+                        }
+                } else if (c == '-' || is_digit(c)) {
+                        if (!expects_value(r)) {
+                                reader_error(r, "unexpected number");
+                                continue;
+                        }
+                        bool const isfloat = reader_number(r);
+                        if (r->scratch[0]) {
+                                reader_value(r);
+                                return isfloat;
+                        }
+                } else if (c == '"') {
+                        bool const key = r->expect == DUMP_EXPECT_KEY ||
+                                         r->expect == DUMP_EXPECT_FIRSTKEY;
+                        if (!key && !expects_value(r)) {
+                                reader_error(r, "unexpected string");
+                                continue;
+                        }
+                        reader_string(r, key);
+                        if (key) {
+                                r->expect = DUMP_EXPECT_COLON;
+                        } else {
+                                reader_value(r);
+                        }
+                } else if (c == '[' || c == '{') {
+                        reader_open(r, c == '{');
+                } else if (c == ']' || c == '}') {
+                        reader_close(r, c == '}');
+                } else if (c == ',' && r->expect == DUMP_EXPECT_NEXT) {
+                        r->expect = in_object(r) ? DUMP_EXPECT_KEY
+                                                 : DUMP_EXPECT_VALUE;
+                        r->pos++;
+                } else if (c == ':' && r->expect == DUMP_EXPECT_COLON) {
+                        r->expect = DUMP_EXPECT_VALUE;
+                        r->pos++;
+                } else if (expects_value(r) && reader_literal(r)) {
+                        r->pos += reader_literal(r);
+                        reader_value(r);
+                } else {
+                        reader_error(r, "unexpected character");
+                }
+        }
+        // Either nothing or exactly one complete document
+        if (r->depth || (r->expect != DUMP_EXPECT_END &&
+                         r->expect != DUMP_EXPECT_VALUE)) {
+                reader_error(r, "unexpected end of input");
+                r->expect = DUMP_EXPECT_END;
+        }
+        r->scratch[0] = '\0';
+        return false;
+}
+
+bool dump_reader_int(dump_reader* r, intmax_t* val) {
+        if (reader_token(r)) {
+                reader_error(r, "expected integer");
+        }
+        if (!r->scratch[0]) {
+                return false;
+        }
+        errno = 0;
+        *val = strtoimax(r->scratch, NULL, 10);
+        if (errno == ERANGE) {
+                reader_error(r, "integer out of range");
+                return false;
+        }
+        return true;
+}
+
+bool dump_reader_float(dump_reader* r, float* val) {
+        reader_token(r);
+        if (!r->scratch[0]) {
+                return false;
+        }
+        *val = strtof(r->scratch, NULL);
+        return true;
 }
@@ -7,16 +7,19 @@ This software is distributed without any warranty.
 You should have received a copy of the CC0 Public Domain Dedication along with
 this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
 */
+#define _POSIX_C_SOURCE 200112L  // fileno
 #include "eventloop.h"
 #include <assert.h>
 #include <inttypes.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "dump.h"
 #include "jobq.h"
-#include "json.h"
-#include "selist.h"
+#include "out.h"
 
 struct eventloop {
         jobgen* jg;
@@ -28,25 +31,32 @@ struct eventloop {
         job* nextjob;
         bool had_overrun;
         bool allow_first_overrun;
+        bool quiet;
+        jobq_kind readyq;
 };
 
 eventloop* eventloop_init(jobgen* const jg,
                           bool init,
-                          bool allow_first_overrun) {
+                          bool allow_first_overrun,
+                          jobq_kind readyq) {
         eventloop* evl = calloc(1, sizeof(eventloop));
         if (evl) {
                 evl->had_overrun = false;
                 evl->allow_first_overrun = allow_first_overrun;
+                evl->readyq = readyq;
                 evl->jg = jg;
-                evl->pq = jobq_init();
+                evl->pq = jobq_init_as(readyq, jobgen_get_tasksystem(jg));
                 if (init) {  // differentiate to support resume from state dump
                         evl->currentjob = jobgen_rise(evl->jg);
                         evl->nextjob = jobgen_rise(evl->jg);
-                        assert(job_get_starttime(evl->currentjob) <=
-                               job_get_starttime(evl->nextjob));
-                        evl->now = job_get_starttime(evl->currentjob);
-                        jobq_insert_by(evl->pq, evl->currentjob,
-                                       job_get_deadline);
+                        assert(!evl->nextjob ||
+                               job_get_starttime(evl->currentjob) <=
+                                   job_get_starttime(evl->nextjob));
+                        if (evl->currentjob) {
+                                evl->now = job_get_starttime(evl->currentjob);
+                                jobq_insert_by(evl->pq, evl->currentjob,
+                                               job_get_deadline);
+                        }
                         evl->jobs_done = 0;
                         evl->events_done = 0;
                 }
@@ -68,6 +78,31 @@ EVL_INT eventloop_get_now(eventloop* evl) {
         return evl->now;
 }
 
+EVL_INT eventloop_get_events(eventloop const* const evl) {
+        return evl->events_done;
+}
+
+JOB_INT eventloop_get_jobsdone(eventloop const* const evl) {
+        return evl->jobs_done;
+}
+
+size_t eventloop_get_maxready(eventloop const* const evl) {
+        return jobq_peak(evl->pq);
+}
+
+void eventloop_set_quiet(eventloop* evl, bool quiet) {
+        evl->quiet = quiet;
+}
+
+static void print_overrun(job* const j, JOB_INT const overrunby) {
+        fprintf(stdout,
+                "Overflowing job of task %" PRId64 " arrives at %" PRId64
+                " with deadline at %" PRId64 " and computation of %" PRId64
+                " which is an overrun of %" PRId64 "\n",
+                job_get_taskid(j), job_get_starttime(j), job_get_deadline(j),
+                job_get_computation(j), overrunby);
+}
+
 static JOB_INT max(JOB_INT a, JOB_INT b) {
         return a > b ? a : b;
 }
@@ -86,8 +121,10 @@ eventloop_result eventloop_run(eventloop* evl,
         job* nextjob = evl->nextjob;
 
         while (evl->now < breaktime) {
-                // Assert now is arrival of current job
-                JOB_INT arrival = job_get_starttime(nextjob);
+                // Assert now is arrival of current job, without next job
+                // simulate up to breaktime
+                JOB_INT arrival =
+                    nextjob ? job_get_starttime(nextjob) : breaktime;
                 JOB_INT runtime;
                 if (arrival < breaktime) {
                         runtime = arrival - evl->now;
@@ -122,19 +159,10 @@ eventloop_result eventloop_run(eventloop* evl,
                                         /* Execution of next job is beyond its
                                          * overrun; take note. */
                                         evl->had_overrun = true;
-                                        fprintf(
-                                            stdout,
-                                            "Overflowing job of task %" PRId64
-                                            " arrives at %" PRId64
-                                            " with deadline at %" PRId64
-                                            " and computation of %" PRId64
-                                            " which is an overrun of %" PRId64
-                                            "\n",
-                                            job_get_taskid(currentjob),
-                                            job_get_starttime(currentjob),
-                                            job_get_deadline(currentjob),
-                                            job_get_computation(currentjob),
-                                            overrunby);
+                                        if (!evl->quiet) {
+                                                print_overrun(currentjob,
+                                                              overrunby);
+                                        }
                                 }
                         } else {
                                 evl->had_overrun = true;
@@ -248,121 +276,149 @@ void eventloop_print_result(eventloop const* const evl,
         }
 }
 
+static void print_job(out* o, job* const j, bool const first) {
+        if (!first) {
+                out_char(o, ',');
+        }
+        out_job_json(o, j);
+}
+
 void eventloop_dump(eventloop const* const evl, FILE* stream) {
-        // Get list of unique jobs
-        void** dump_jg = (void*)0;
-        void** dump_pq = (void*)0;
-        int len_jg = jobgen_dump(evl->jg, &dump_jg);
-        int len_pq = jobq_dump(evl->pq, &dump_pq);
-
-        int len = len_jg + len_pq;
-        void** m = merge(dump_jg, dump_pq, len_jg, len_pq);
-        void** u = calloc(len, sizeof(void*));
-        int lenuniq = uniq(m, u, len);
-        free(m);
-        free(dump_jg);
-        free(dump_pq);
+        // Jobs are listed in the order they leave their queue, which restores
+        // the order of jobs with equal priority as well.
+        void** ready = (void*)0;
+        void** pending = (void*)0;
+        int len_pq = jobq_dump(evl->pq, &ready);
+        int len_jg = jobgen_dump(evl->jg, &pending);
 
         // Write JSON to stream
-        json_printer* print = dump_json_tostream_init(stream);
+        out* o = out_init(stream);
 
-        json_print_raw(print, JSON_OBJECT_BEGIN, NULL, 0);
-        json_print_raw(print, JSON_KEY, "now", 3);
-        dump_json_tostream(print, evl->now);
+        out_str(o, "{\"now\":");
+        out_int(o, evl->now);
 
-        json_print_raw(print, JSON_KEY, "jobs", 4);
-        json_print_raw(print, JSON_ARRAY_BEGIN, NULL, 0);
+        out_str(o, ",\"jobs\":[");
+        for (int i = 0; i < len_pq; i++) {
+                print_job(o, ready[i], i == 0);
+        }
+        if (evl->nextjob) {
+                print_job(o, evl->nextjob, len_pq == 0);
+        }
+        for (int i = 0; i < len_jg; i++) {
+                print_job(o, pending[i], i == 0 && !len_pq && !evl->nextjob);
+        }
+        out_char(o, ']');
+        free(ready);
+        free(pending);
 
-        job** jp = (job**)u;
-        for (int i = 0; i < lenuniq; i++) {
-                job* j = *(jp + i);
-                json_print_raw(print, JSON_ARRAY_BEGIN, NULL, 0);
+        out_str(o, ",\"ready\":");
+        out_int(o, len_pq);
+        out_str(o, ",\"next\":");
+        out_int(o, evl->nextjob != NULL);
+        out_str(o, ",\"events\":");
+        out_int(o, evl->events_done);
+        out_str(o, ",\"jobsdone\":");
+        out_int(o, evl->jobs_done);
+        out_str(o, ",\"overrun\":");
+        out_int(o, evl->had_overrun);
+        jobgen_dump_json(evl->jg, o);
 
-                dump_json_tostream(print, job_get_taskid(j));
-                dump_json_tostream(print, job_get_starttime(j));
-                dump_json_tostream(print, job_get_overruntime(j));
-                dump_json_tostream(print, job_get_deadline(j));
-                dump_json_tostream(print, job_get_computation(j));
+        out_char(o, '}');
+        out_free(o);
+}
 
-                json_print_raw(print, JSON_ARRAY_END, NULL, 0);
-        }
-        free(u);
+/* State read from a checkpoint or JSON state dump */
+typedef struct {
+        EVL_INT now;
+        EVL_INT events;
+        JOB_INT jobsdone;
+        bool overrun;
+        uint32_t seed;
+        uint64_t pcg[2];
+        job** jobs;  // ready jobs, next job, and pending jobs in queue order
+        size_t njobs;
+        size_t nready;
+        int next;
+        JOB_INT* simtimes;
+        uint64_t* counts;
+} restore_state;
 
-        json_print_raw(print, JSON_ARRAY_END, NULL, 0);
-        json_print_raw(print, JSON_OBJECT_END, NULL, 0);
-        dump_json_tostream_free(print);
+static void restore_init(restore_state* const st, int const n) {
+        memset(st, 0, sizeof(restore_state));
+        st->simtimes = calloc(n ? n : 1, sizeof(JOB_INT));
+        st->counts = calloc(n ? n : 1, sizeof(uint64_t));
+        if (!st->simtimes || !st->counts) {  // GCOVR_EXCL_START
+                fprintf(stderr,
+                        "error allocating memory while restoring state\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
 }
 
-void eventloop_read_json(eventloop* evl, FILE* stream) {
-        // This is a partial state restoration, beware!
-        struct selist* l = (void*)0;
-        json_parser* parser = dump_read_json_init(&l);
-        dump_read_json_parse(parser, stream);
-        dump_read_json_free(parser);
+static void restore_free(restore_state* const st) {
+        free(st->jobs);
+        free(st->simtimes);
+        free(st->counts);
+}
 
-        int i = 0;
+static void restore(eventloop* evl, restore_state const* const st) {
+        ts const* tsy = jobgen_get_tasksystem(evl->jg);
+        int n = ts_length(tsy);
+        if (st->nready + st->next > st->njobs) {  // GCOVR_EXCL_START
+                fprintf(stderr, "state dump misses jobs\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
 
-        // Order is important, therefore use get instead of pop.
-        intmax_t* now = selist_get(l, i++);
-        evl->now = *now;
+        // Loading jobs in queue order keeps the order of equal priorities
+        size_t first = st->nready + st->next;
+        jobq* scheduler = jobq_init_as(evl->readyq, tsy);
+        jobq* generator = jobq_init();
+        jobq_load_by(scheduler, st->jobs, st->nready, job_get_deadline);
+        jobq_load_by(generator, st->jobs + first, st->njobs - first,
+                     job_get_starttime);
+        job_free(evl->nextjob);
+        evl->nextjob = st->next ? st->jobs[st->nready] : NULL;
+        jobq_free(evl->pq);
+        evl->pq = scheduler;
+        evl->currentjob = jobq_peek(evl->pq);
+        evl->now = st->now;
+        evl->events_done = st->events;
+        evl->jobs_done = st->jobsdone;
+        evl->had_overrun = st->overrun;
+        jobgen_replace_jobq(evl->jg, generator);
+        jobgen_set_rngstate(evl->jg, st->seed, st->pcg);
+        jobgen_set_simtime(evl->jg, st->simtimes, n);
+        jobgen_set_jobcount(evl->jg, st->counts, n);
+}
 
+/* Dumps without generator state only allow a partial state restoration. */
+static void restore_legacy(eventloop* evl, restore_state const* const st) {
         ts const* tsy = jobgen_get_tasksystem(evl->jg);
-        jobq* scheduler = jobq_init();
+        evl->now = st->now;
+
+        jobq* scheduler = jobq_init_as(evl->readyq, tsy);
         jobq* generator = jobq_init();
-        JOB_INT* simtimes = calloc(ts_length(tsy), sizeof(JOB_INT));
-        if (!simtimes) {  // GCOVR_EXCL_START
-                fprintf(stderr,
-                        "error allocating memory while restoring state\n");
-                exit(EXIT_FAILURE);
-        }                               // GCOVR_EXCL_STOP
-        while (i < selist_length(l)) {  // skipped if no job in list due to drop
-                // Recreate job from list with knowledge about order,
-                // sorry future me/others!
-                intmax_t* taskid = selist_get(l, i++);
-                intmax_t* starttime = selist_get(l, i++);
-                intmax_t* overruntime = selist_get(l, i++);
-                intmax_t* deadline = selist_get(l, i++);
-                intmax_t* computation = selist_get(l, i++);
-                job* j = job_init(*taskid, *starttime, *overruntime, *deadline,
-                                  *computation);
-                if (*starttime > *now) {
+        // skipped if no job in list due to drop
+        for (size_t i = 0; i < st->njobs; i++) {
+                job* j = st->jobs[i];
+                if (job_get_starttime(j) > evl->now) {
                         jobq_insert_by(generator, j, job_get_starttime);
-                        int k = ts_get_pos_by_id(tsy, *taskid);
-                        task* t = ts_get_by_id(tsy, *taskid);
-                        JOB_INT delta = task_get_period(t) - *computation;
+                        task* t = ts_get_by_pos(tsy, job_get_taskpos(j));
+                        JOB_INT delta =
+                            task_get_period(t) - job_get_computation(j);
                         // Random duration between two jobs of a task is set to
-                        // zero. For seamless restoration a dump of the random
-                        // number generator state would be required.
-                        *(simtimes + k) = *starttime + *computation + delta;
+                        // zero, as the legacy dump misses the random number
+                        // generator state.
+                        *(st->simtimes + job_get_taskpos(j)) =
+                            job_get_starttime(j) + job_get_computation(j) +
+                            delta;
                 } else {
                         jobq_insert_by(scheduler, j, job_get_deadline);
                 }
-                free(taskid);
-                free(starttime);
-                free(overruntime);
-                free(deadline);
-                free(computation);
-        }
-        for (; i >= 0; i--) {
-                selist_delete(&l, i);
         }
-        assert(selist_empty(l));
-        selist_free(l);
         jobq_free(evl->pq);
         evl->pq = scheduler;
-        jobgen_set_simtime(evl->jg, simtimes, ts_length(tsy));
+        jobgen_set_simtime(evl->jg, st->simtimes, ts_length(tsy));
         jobgen_replace_jobq(evl->jg, generator);
-        /* This is unused legacy code?
-        if (i == 1) {  // we dropped everything
-                // simtimes are all zero, need to set them to current
-                // missiontime
-                for (int k = 0; k < ts_length(tsy); k++) {
-                        *(simtimes + k) = *now;
-                }
-                jobgen_set_simtime(evl->jg, simtimes, ts_length(tsy));
-                jobgen_refill_all(evl->jg);
-        }
-        */
         // It is perfectly fine to raise NULL if no job is due because we might
         // already have passed beyond the mission duration, which would prevent
         // the generator from creating new jobs.
@@ -373,6 +429,262 @@ void eventloop_read_json(eventloop* evl, FILE* stream) {
                        job_get_starttime(evl->nextjob));
                 jobq_insert_by(evl->pq, evl->currentjob, job_get_deadline);
         }
-        free(simtimes);
-        free(now);
+}
+
+/* Recreate job of task @p taskid from the jobs list, sorry future me/others!
+ */
+static job* read_job(dump_reader* r, ts const* const tsy, intmax_t taskid) {
+        intmax_t v[4];
+        for (int i = 0; i < 4; i++) {
+                if (!dump_reader_int(r, v + i)) {  // GCOVR_EXCL_START
+                        fprintf(stderr, "state dump misses job values\n");
+                        exit(EXIT_FAILURE);
+                }  // GCOVR_EXCL_STOP
+        }
+        job* j = job_init(taskid, v[0], v[1], v[2], v[3]);
+        job_set_taskpos(j, ts_get_pos_by_id(tsy, taskid));
+        return j;
+}
+
+static void push_job(restore_state* const st, size_t* avail, job* const j) {
+        if (st->njobs == *avail) {
+                *avail = *avail ? 2 * *avail : 64;
+                job** jobs = realloc(st->jobs, *avail * sizeof(job*));
+                if (!jobs) {  // GCOVR_EXCL_START
+                        fprintf(stderr,
+                                "error allocating memory while restoring "
+                                "state\n");
+                        exit(EXIT_FAILURE);
+                }  // GCOVR_EXCL_STOP
+                st->jobs = jobs;
+        }
+        st->jobs[st->njobs++] = j;
+}
+
+void eventloop_read_json(eventloop* evl, FILE* stream) {
+        ts const* tsy = jobgen_get_tasksystem(evl->jg);
+        restore_state st;
+        restore_init(&st, ts_length(tsy));
+        size_t avail = 0;
+        bool exact = false;
+        intmax_t rng = jobgen_get_rng(evl->jg);
+        int npcg = 0;
+
+        // Numbers are dispatched by key while streaming through the dump
+        dump_reader r;
+        dump_reader_init(&r, stream);
+        intmax_t v;
+        while (dump_reader_int(&r, &v)) {
+                char const* key = dump_reader_key(&r);
+                if (!strcmp(key, "jobs")) {
+                        push_job(&st, &avail, read_job(&r, tsy, v));
+                } else if (!strcmp(key, "tasks")) {
+                        intmax_t simtime;
+                        intmax_t count;
+                        if (!dump_reader_int(&r, &simtime) ||
+                            !dump_reader_int(&r, &count)) {
+                                // GCOVR_EXCL_START
+                                fprintf(stderr,
+                                        "state dump misses task values\n");
+                                exit(EXIT_FAILURE);
+                        }  // GCOVR_EXCL_STOP
+                        int k = ts_get_pos_by_id(tsy, v);
+                        st.simtimes[k] = simtime;
+                        st.counts[k] = count;
+                } else if (!strcmp(key, "now")) {
+                        st.now = v;
+                } else if (!strcmp(key, "ready")) {
+                        st.nready = v;
+                        exact = true;
+                } else if (!strcmp(key, "next")) {
+                        st.next = v;
+                } else if (!strcmp(key, "events")) {
+                        st.events = v;
+                } else if (!strcmp(key, "jobsdone")) {
+                        st.jobsdone = v;
+                } else if (!strcmp(key, "overrun")) {
+                        st.overrun = v;
+                } else if (!strcmp(key, "seed")) {
+                        st.seed = v;
+                } else if (!strcmp(key, "rng")) {
+                        rng = v;
+                } else if (!strcmp(key, "pcg") && npcg < 2) {
+                        st.pcg[npcg++] = v;
+                }
+        }
+        dump_reader_free(&r);
+
+        if (!exact) {
+                restore_legacy(evl, &st);
+        } else if (rng != jobgen_get_rng(evl->jg)) {  // GCOVR_EXCL_START
+                fprintf(stderr,
+                        "state dump requires random stream mode %" PRIdMAX
+                        "\n",
+                        rng);
+                exit(EXIT_FAILURE);
+        } else {  // GCOVR_EXCL_STOP
+                restore(evl, &st);
+        }
+        restore_free(&st);
+}
+
+static void write_job(dump_job* const d, job* const j) {
+        d->starttime = job_get_starttime(j);
+        d->overruntime = job_get_overruntime(j);
+        d->deadline = job_get_deadline(j);
+        d->computation = job_get_computation(j);
+        d->taskpos = job_get_taskpos(j);
+}
+
+void eventloop_dump_bin(eventloop const* const evl, FILE* stream) {
+        void** ready = (void*)0;
+        void** pending = (void*)0;
+        int len_pq = jobq_dump(evl->pq, &ready);
+        int len_jg = jobgen_dump(evl->jg, &pending);
+        ts const* tsy = jobgen_get_tasksystem(evl->jg);
+        int n = ts_length(tsy);
+        int next = evl->nextjob != NULL;
+
+        // Assemble the checkpoint in memory for a single write
+        size_t size = sizeof(dump_header) + n * sizeof(dump_task) +
+                      (len_pq + next + len_jg) * sizeof(dump_job);
+        dump_header* h = calloc(1, size);
+        if (!h) {  // GCOVR_EXCL_START
+                fprintf(stderr, "error allocating memory for checkpoint\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        memcpy(h->magic, DUMP_MAGIC, sizeof(DUMP_MAGIC));
+        h->version = DUMP_VERSION;
+        h->byteorder = DUMP_BYTEORDER;
+        h->tshash = ts_hash(tsy);
+        h->now = evl->now;
+        h->events = evl->events_done;
+        h->jobsdone = evl->jobs_done;
+        jobgen_get_rngstate(evl->jg, &h->seed, h->pcg);
+        h->ntasks = n;
+        h->nready = len_pq;
+        h->npending = len_jg;
+        h->rng = jobgen_get_rng(evl->jg);
+        h->next = next;
+        h->overrun = evl->had_overrun;
+
+        dump_task* tasks = (dump_task*)(h + 1);
+        for (int k = 0; k < n; k++) {
+                tasks[k].simtime = jobgen_get_simtime(evl->jg, k);
+                tasks[k].jobcount = jobgen_get_jobcount(evl->jg, k);
+        }
+        dump_job* jobs = (dump_job*)(tasks + n);
+        for (int i = 0; i < len_pq; i++) {
+                write_job(jobs++, ready[i]);
+        }
+        if (next) {
+                write_job(jobs++, evl->nextjob);
+        }
+        for (int i = 0; i < len_jg; i++) {
+                write_job(jobs++, pending[i]);
+        }
+        free(ready);
+        free(pending);
+
+        if (fwrite(h, size, 1, stream) != 1) {  // GCOVR_EXCL_START
+                fprintf(stderr, "checkpoint io error\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        free(h);
+}
+
+static job* read_bin_job(dump_job const* const d, ts_params const* const p) {
+        if (d->taskpos < 0 || d->taskpos >= p->n) {  // GCOVR_EXCL_START
+                fprintf(stderr, "checkpoint holds job of unknown task\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        job* j = job_init(p->ids[d->taskpos], d->starttime, d->overruntime,
+                          d->deadline, d->computation);
+        job_set_taskpos(j, d->taskpos);
+        return j;
+}
+
+void eventloop_read_bin(eventloop* evl, FILE* stream) {
+        ts const* tsy = jobgen_get_tasksystem(evl->jg);
+        ts_params const* p = ts_get_params(tsy);
+        struct stat st;
+        int fd = fileno(stream);
+        if (fd < 0 || fstat(fd, &st) ||
+            (size_t)st.st_size < sizeof(dump_header)) {  // GCOVR_EXCL_START
+                fprintf(stderr, "checkpoint truncated\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        size_t size = st.st_size;
+        void* mem = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mem == MAP_FAILED) {  // GCOVR_EXCL_START
+                fprintf(stderr, "error mapping checkpoint\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+
+        dump_header const* h = mem;
+        if (memcmp(h->magic, DUMP_MAGIC, sizeof(DUMP_MAGIC)) ||
+            h->version != DUMP_VERSION ||
+            h->byteorder != DUMP_BYTEORDER) {  // GCOVR_EXCL_START
+                fprintf(stderr, "unsupported checkpoint format\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        if (h->ntasks != (uint64_t)ts_length(tsy) ||
+            h->tshash != ts_hash(tsy)) {  // GCOVR_EXCL_START
+                fprintf(stderr, "checkpoint of another task system\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        if (h->rng != jobgen_get_rng(evl->jg)) {  // GCOVR_EXCL_START
+                fprintf(stderr, "checkpoint requires random stream mode %d\n",
+                        h->rng);
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        size_t n = h->ntasks;
+        size_t njobs = h->nready + h->next + h->npending;
+        if (size != sizeof(dump_header) + n * sizeof(dump_task) +
+                        njobs * sizeof(dump_job)) {  // GCOVR_EXCL_START
+                fprintf(stderr, "checkpoint truncated\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+
+        restore_state rs;
+        restore_init(&rs, n);
+        rs.now = h->now;
+        rs.events = h->events;
+        rs.jobsdone = h->jobsdone;
+        rs.overrun = h->overrun;
+        rs.seed = h->seed;
+        rs.pcg[0] = h->pcg[0];
+        rs.pcg[1] = h->pcg[1];
+        rs.nready = h->nready;
+        rs.next = h->next;
+        rs.njobs = njobs;
+        rs.jobs = calloc(njobs ? njobs : 1, sizeof(job*));
+        if (!rs.jobs) {  // GCOVR_EXCL_START
+                fprintf(stderr,
+                        "error allocating memory while restoring state\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        dump_task const* tasks = (dump_task const*)(h + 1);
+        for (size_t k = 0; k < n; k++) {
+                rs.simtimes[k] = tasks[k].simtime;
+                rs.counts[k] = tasks[k].jobcount;
+        }
+        dump_job const* records = (dump_job const*)(tasks + n);
+        for (size_t i = 0; i < njobs; i++) {
+                rs.jobs[i] = read_bin_job(records + i, p);
+        }
+        munmap(mem, size);
+
+        restore(evl, &rs);
+        restore_free(&rs);
+}
+
+void eventloop_read(eventloop* evl, FILE* stream) {
+        int c = getc(stream);
+        ungetc(c, stream);
+        if (c == DUMP_MAGIC[0]) {
+                eventloop_read_bin(evl, stream);
+        } else {
+                eventloop_read_json(evl, stream);
+        }
 }
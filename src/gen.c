@@ -0,0 +1,234 @@
+/*
+thready - A lightweight and fast scheduling simulator
+Written in 2019 by Robert Schmidt <rschmidt@uni-bremen.de>
+To the extent possible under law, the author(s) have dedicated all copyright and
+related and neighboring rights to this software to the public domain worldwide.
+This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with
+this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+#include "gen.h"
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+
+#define GEN_ATTEMPTS 1000  // UUniFast attempts before giving up
+
+void gen_config_default(gen_config* c) {
+        c->n = 10;
+        c->utilization = 0.5;
+        c->method = GEN_UUNIFAST;
+        c->periods = GEN_LOGUNIFORM;
+        c->pmin = 10;
+        c->pmax = 10000;
+        c->dmin = 1.0;
+        c->dmax = 1.0;
+        c->cratio = 1.0;
+        c->hifraction = 0.0;
+        c->hifactor = 2.0;
+        c->hiprob = 0.01f;
+        c->beta = 0.0f;
+        c->seed = 0;
+}
+
+char const* gen_check(gen_config const* const c) {
+        if (c->n < 1) {
+                return "less than one task";
+        }
+        if (!(c->utilization > 0.0) || c->utilization > c->n) {
+                return "utilization not in (0, number of tasks]";
+        }
+        if (c->pmin < 1 || c->pmax < c->pmin) {
+                return "periods not in [1, maximum] or maximum below minimum";
+        }
+        if (!(c->dmin > 0.0) || c->dmax < c->dmin) {
+                return "deadline ratios not positive or maximum below minimum";
+        }
+        if (!(c->cratio > 0.0) || c->cratio > 1.0) {
+                return "computation ratio not in (0, 1]";
+        }
+        if (!(c->hifraction >= 0.0) || c->hifraction > 1.0) {
+                return "high criticality fraction not in [0, 1]";
+        }
+        if (!(c->hifactor >= 1.0)) {
+                return "overrun factor below one";
+        }
+        if (!(c->hiprob >= 0.0f) || c->hiprob > 1.0f) {
+                return "overrun probability not in [0, 1]";
+        }
+        if (!(c->beta >= 0.0f)) {
+                return "negative interarrival parameter";
+        }
+        return NULL;
+}
+
+/* Uniform double in [0, 1) of 53 random bits */
+static double uniform(rnd_pcg_t* const pcg) {
+        uint64_t const a = rnd_pcg_next(pcg) >> 5;
+        uint64_t const b = rnd_pcg_next(pcg) >> 6;
+        return (a * 67108864.0 + b) / 9007199254740992.0;
+}
+
+static bool uunifast(rnd_pcg_t* const pcg,
+                     int const n,
+                     double const sum,
+                     double* const u) {
+        for (int attempt = 0; attempt < GEN_ATTEMPTS; attempt++) {
+                double rest = sum;
+                bool valid = true;
+                for (int i = 0; i < n - 1; i++) {
+                        double next =
+                            rest * pow(1.0 - uniform(pcg), 1.0 / (n - 1 - i));
+                        u[i] = rest - next;
+                        valid = valid && u[i] <= 1.0;
+                        rest = next;
+                }
+                u[n - 1] = rest;
+                if (valid && rest <= 1.0) {
+                        return true;
+                }
+        }
+        return false;
+}
+
+/* Stafford's algorithm for one vector in [0, 1]^n. Only the columns up to
+ * k + 1 of the transition table are ever reached. */
+static void randfixedsum(rnd_pcg_t* const pcg,
+                         int const n,
+                         double s,
+                         double* const x) {
+        int const k = (int)fmax(fmin(floor(s), n - 1), 0);
+        int const cols = k + 1;
+        s = fmax(fmin(s, k + 1), k);
+        // Column c of the text book algorithm is c - 1 here
+        double* w = calloc(2 * (cols + 2), sizeof(double));
+        double* t = calloc((size_t)(n > 1 ? n - 1 : 1) * cols, sizeof(double));
+        if (!w || !t) {  // GCOVR_EXCL_START
+                fprintf(stderr, "error allocating memory\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        double* prev = w;
+        double* cur = w + cols + 2;
+        prev[1] = 1.0;
+        for (int i = 2; i <= n; i++) {
+                cur[0] = 0.0;
+                for (int m = 1; m <= i && m <= cols; m++) {
+                        double const s1 = s - (k - m + 1);
+                        double const s2 = (k + i - m + 1) - s;
+                        double const tmp1 = prev[m] * s1 / i;
+                        double const tmp2 = prev[m - 1] * s2 / i;
+                        cur[m] = tmp1 + tmp2;
+                        double const tmp3 = cur[m] + DBL_MIN;
+                        t[(size_t)(i - 2) * cols + m - 1] =
+                            s2 > s1 ? tmp2 / tmp3 : 1.0 - tmp1 / tmp3;
+                }
+                // Only ratios within a row matter, rescale against underflow
+                double max = 0.0;
+                for (int m = 1; m < cols + 2; m++) {
+                        if (m > i || m > cols) {
+                                cur[m] = 0.0;
+                        }
+                        max = fmax(max, cur[m]);
+                }
+                for (int m = 1; max > 0.0 && m <= cols; m++) {
+                        cur[m] /= max;
+                }
+                double* swap = prev;
+                prev = cur;
+                cur = swap;
+        }
+
+        int j = cols;
+        double sm = 0.0;
+        double pr = 1.0;
+        for (int i = n - 1; i >= 1; i--) {
+                double const rt = uniform(pcg);
+                double const rs = uniform(pcg);
+                int const e = rt <= t[(size_t)(i - 1) * cols + j - 1];
+                double const sx = pow(rs, 1.0 / i);
+                sm += (1.0 - sx) * pr * s / (i + 1);
+                pr *= sx;
+                x[n - i - 1] = sm + pr * e;
+                s -= e;
+                j -= e;
+        }
+        x[n - 1] = sm + pr * s;
+        free(w);
+        free(t);
+
+        // The algorithm orders the values, shuffle them
+        for (int i = n - 1; i > 0; i--) {
+                int const r = (int)(uniform(pcg) * (i + 1));
+                double const v = x[i];
+                x[i] = x[r];
+                x[r] = v;
+        }
+}
+
+bool gen_utilizations(rnd_pcg_t* const pcg,
+                      gen_method const method,
+                      int const n,
+                      double const sum,
+                      double* const u) {
+        if (method == GEN_RANDFIXEDSUM) {
+                randfixedsum(pcg, n, sum, u);
+                return true;
+        }
+        return uunifast(pcg, n, sum, u);
+}
+
+static TASK_INT period(rnd_pcg_t* const pcg, gen_config const* const c) {
+        if (c->periods == GEN_HARMONIC) {
+                int levels = 0;
+                while (c->pmin << (levels + 1) <= c->pmax) {
+                        levels++;
+                }
+                return c->pmin << (int)(uniform(pcg) * (levels + 1));
+        }
+        double const lo = log((double)c->pmin);
+        double const hi = log((double)c->pmax);
+        TASK_INT const p = llround(exp(lo + uniform(pcg) * (hi - lo)));
+        return p < c->pmin ? c->pmin : (p > c->pmax ? c->pmax : p);
+}
+
+double gen_write_json(gen_config const* const c, FILE* stream) {
+        rnd_pcg_t pcg;
+        rnd_pcg_seed(&pcg, c->seed);
+        double* u = calloc(c->n, sizeof(double));
+        if (!u) {  // GCOVR_EXCL_START
+                fprintf(stderr, "error allocating memory\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        if (!gen_utilizations(&pcg, c->method, c->n, c->utilization, u)) {
+                free(u);
+                return -1.0;
+        }
+        double total = 0.0;
+        fprintf(stream, "[\n");
+        for (int i = 0; i < c->n; i++) {
+                TASK_INT const p = period(&pcg, c);
+                double const ratio =
+                    c->dmin + uniform(&pcg) * (c->dmax - c->dmin);
+                TASK_INT const d = fmax(llround(ratio * p), 1);
+                TASK_INT const c1 = fmax(llround(u[i] * p), 1);
+                TASK_INT const c0 = fmin(fmax(ceil(c->cratio * c1), 1), c1);
+                bool const hi = uniform(&pcg) < c->hifraction;
+                TASK_INT const c2 = hi ? c1 + 1 : 0;
+                TASK_INT const c3 =
+                    hi ? fmax(llround(c->hifactor * c1), c2) : 0;
+                float const p1 = hi ? c->hiprob : 0.0f;
+                total += (double)c1 / p;
+                // The third segment repeats the second, as the probabilities
+                // read back may leave it a rounding error
+                fprintf(stream,
+                        "        [%d,%lld,%lld, %lld,%lld, %lld,%lld, "
+                        "%lld,%lld, %.6f,%.6f, %.6f]%s\n",
+                        i, (long long)p, (long long)d, (long long)c0,
+                        (long long)c1, (long long)c2, (long long)c3,
+                        (long long)c2, (long long)c3, 1.0f - p1, p1, c->beta,
+                        i + 1 < c->n ? "," : "");
+        }
+        fprintf(stream, "]\n");
+        free(u);
+        return total;
+}
@@ -0,0 +1,189 @@
+/*
+thready - A lightweight and fast scheduling simulator
+Written in 2019 by Robert Schmidt <rschmidt@uni-bremen.de>
+To the extent possible under law, the author(s) have dedicated all copyright and
+related and neighboring rights to this software to the public domain worldwide.
+This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with
+this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+/**
+ * @file genmain.c
+ * @author Robert Schmidt
+ * @brief Command line parsing of thready-gen.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gen.h"
+#include "parg.h"
+
+/* Parse min or min:max into lo and hi */
+static void parse_range(char const* arg,
+                        double* lo,
+                        double* hi,
+                        char const* name) {
+        char* end;
+        char const* c = arg;
+        *lo = strtod(c, &end);
+        *hi = *lo;
+        if (end != c && *end == ':') {
+                c = end + 1;
+                *hi = strtod(c, &end);
+        }
+        if (end == c || *end) {
+                fprintf(stderr, "invalid %s '%s'\n", name, arg);
+                exit(EXIT_FAILURE);
+        }
+}
+
+int main(int argc, char* argv[]) {
+        gen_config c;
+        gen_config_default(&c);
+        char const* fname = NULL;
+        double lo;
+        double hi;
+
+        struct parg_state ps;
+        int o;
+        parg_init(&ps);
+        // abcdefghijklmnopqrstuvwxyz ABCDEFGHIJKLMNOPQRSTUVWXYZ
+        // xxxx   x xx  xxx x  xx x x
+        while ((o = parg_getopt(&ps, argc, argv,
+                                "hvn:u:a:p:r:d:c:x:k:o:b:z:j:")) != -1) {
+                switch (o) {
+                        case 1:
+                                printf("nonoption '%s'\n", ps.optarg);
+                                break;
+                        case 'h':
+                                printf(
+                                    "Usage: thready-gen [-h] [-v] "
+                                    "[-n tasks] [-u utilization] "
+                                    "[-a uunifast|randfixedsum] "
+                                    "[-p loguniform|harmonic] "
+                                    "[-r minperiod:maxperiod] "
+                                    "[-d deadlineratio|min:max] "
+                                    "[-c computationratio] "
+                                    "[-x hicriticalityfraction] "
+                                    "[-k overrunfactor] "
+                                    "[-o overrunprobability] "
+                                    "[-b beta] [-z seed] "
+                                    "[-j tasksystemfile.json]\n");
+                                exit(EXIT_SUCCESS);
+                                break;
+                        case 'v':
+                                printf("thready-gen %s\n", VERSION);
+                                return EXIT_SUCCESS;
+                                break;
+                        case 'n':
+                                c.n = atoi(ps.optarg);
+                                break;
+                        case 'u':
+                                c.utilization = atof(ps.optarg);
+                                break;
+                        case 'a':  // Method drawing utilizations
+                                if (!strcmp(ps.optarg, "uunifast")) {
+                                        c.method = GEN_UUNIFAST;
+                                } else if (!strcmp(ps.optarg,
+                                                   "randfixedsum")) {
+                                        c.method = GEN_RANDFIXEDSUM;
+                                } else {
+                                        fprintf(stderr,
+                                                "unknown method '%s'\n",
+                                                ps.optarg);
+                                        exit(EXIT_FAILURE);
+                                }
+                                break;
+                        case 'p':  // Distribution of periods
+                                if (!strcmp(ps.optarg, "loguniform")) {
+                                        c.periods = GEN_LOGUNIFORM;
+                                } else if (!strcmp(ps.optarg, "harmonic")) {
+                                        c.periods = GEN_HARMONIC;
+                                } else {
+                                        fprintf(stderr,
+                                                "unknown periods '%s'\n",
+                                                ps.optarg);
+                                        exit(EXIT_FAILURE);
+                                }
+                                break;
+                        case 'r':
+                                parse_range(ps.optarg, &lo, &hi,
+                                            "period range");
+                                c.pmin = llround(lo);
+                                c.pmax = llround(hi);
+                                break;
+                        case 'd':
+                                parse_range(ps.optarg, &c.dmin, &c.dmax,
+                                            "deadline ratio");
+                                break;
+                        case 'c':
+                                c.cratio = atof(ps.optarg);
+                                break;
+                        case 'x':
+                                c.hifraction = atof(ps.optarg);
+                                break;
+                        case 'k':
+                                c.hifactor = atof(ps.optarg);
+                                break;
+                        case 'o':
+                                c.hiprob = atof(ps.optarg);
+                                break;
+                        case 'b':
+                                c.beta = atof(ps.optarg);
+                                break;
+                        case 'z':
+                                c.seed = strtoul(ps.optarg, NULL, 10);
+                                break;
+                        case 'j':
+                                fname = ps.optarg;
+                                break;
+                        case '?':
+                                if (strchr("nuaprdcxkobzj", ps.optopt)) {
+                                        printf(
+                                            "option -%c requires an argument\n",
+                                            ps.optopt);
+                                } else {
+                                        printf("unknown option -%c\n",
+                                               ps.optopt);
+                                }
+                                exit(EXIT_FAILURE);
+                                break;
+                        default:
+                                printf("error: unhandled option -%c\n", o);
+                                exit(EXIT_FAILURE);
+                                break;
+                }
+        }
+
+        char const* error = gen_check(&c);
+        if (error) {
+                fprintf(stderr, "invalid task system parameters: %s\n", error);
+                exit(EXIT_FAILURE);
+        }
+        FILE* stream = fname ? fopen(fname, "w") : stdout;
+        if (!stream) {
+                fprintf(stderr, "can't open task system '%s'\n", fname);
+                exit(EXIT_FAILURE);
+        }
+        double const u = gen_write_json(&c, stream);
+        if (u < 0.0) {
+                fprintf(stderr,
+                        "no utilizations of at most one drawn by uunifast, "
+                        "use randfixedsum\n");
+                exit(EXIT_FAILURE);
+        }
+        if (fname && fclose(stream)) {
+                fprintf(stderr, "task system io error\n");
+                exit(EXIT_FAILURE);
+        }
+        // Budgets of a few time units round utilizations noticeably
+        if (fabs(u - c.utilization) > 0.01 * c.utilization) {
+                fprintf(stderr,
+                        "utilization %f instead of %f, increase periods\n", u,
+                        c.utilization);
+        }
+        return EXIT_SUCCESS;
+}
@@ -7,11 +7,16 @@ This software is distributed without any warranty.
 You should have received a copy of the CC0 Public Domain Dedication along with
 this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
 */
+#define _DEFAULT_SOURCE  // MAP_ANONYMOUS and madvise
 #include "job.h"
 #include <errno.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifndef JOB_MALLOC
+#include <sys/mman.h>
+#endif
 
 struct job {
         JOB_INT taskid;
@@ -19,20 +24,106 @@ struct job {
         JOB_INT overruntime;
         JOB_INT deadline;
         JOB_INT computation;
+        int taskpos;
 };
 
+#ifdef JOB_MALLOC
+static job* job_alloc(void) {
+        return calloc(1, sizeof(job));
+}
+
+static void job_release(job* const j) {
+        free(j);
+}
+
+void job_pool_free(void) {}
+#else
+/* Jobs are carved from large chunks and recycled through an intrusive free
+ * list, so that in steady state no job touches the system allocator. The
+ * first slot of every chunk links to the previously allocated chunk. Every
+ * thread has a pool of its own, so jobs must be freed by the thread which
+ * allocated them. */
+typedef union slot {
+        struct job j;
+        union slot* next;
+} slot;
+
+static __thread slot* pool_free;   // recycled jobs
+static __thread slot* pool_chunk;  // most recently allocated chunk
+static __thread size_t pool_used;  // slots handed out from pool_chunk
+
+#define JOB_POOL_SLOTS (JOB_POOL_CHUNKSIZE / sizeof(slot))
+
+static slot* chunk_map(void) {
+        size_t const len = JOB_POOL_CHUNKSIZE;
+        // Over-allocate to be able to trim the mapping to an aligned chunk
+        // that can be backed by a single huge page.
+        uint8_t* p = mmap(NULL, 2 * len, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) {  // GCOVR_EXCL_START
+                fprintf(stderr, "error allocating memory for job pool: %s\n",
+                        strerror(errno));
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        size_t head = (len - (uintptr_t)p % len) % len;
+        if (head) {
+                munmap(p, head);
+        }
+        munmap(p + head + len, len - head);
+        p += head;
+#ifdef MADV_HUGEPAGE
+        madvise(p, len, MADV_HUGEPAGE);
+#endif
+        return (slot*)p;
+}
+
+static job* job_alloc(void) {
+        slot* s = pool_free;
+        if (s) {
+                pool_free = s->next;
+                return &s->j;
+        }
+        if (!pool_chunk || pool_used == JOB_POOL_SLOTS) {
+                slot* c = chunk_map();
+                c->next = pool_chunk;
+                pool_chunk = c;
+                pool_used = 1;
+        }
+        return &(pool_chunk + pool_used++)->j;
+}
+
+static void job_release(job* const j) {
+        if (j) {
+                slot* s = (slot*)j;
+                s->next = pool_free;
+                pool_free = s;
+        }
+}
+
+void job_pool_free(void) {
+        while (pool_chunk) {
+                slot* next = pool_chunk->next;
+                munmap(pool_chunk, JOB_POOL_CHUNKSIZE);
+                pool_chunk = next;
+        }
+        pool_free = NULL;
+        pool_used = 0;
+}
+#endif
+
 job* job_init(JOB_INT const taskid,
               JOB_INT const starttime,
               JOB_INT const overruntime,
               JOB_INT const deadline,
               JOB_INT const computation) {
-        job* j = calloc(1, sizeof(job));
+        job* j = job_alloc();
         if (j) {
                 j->taskid = taskid;
                 j->starttime = starttime;
                 j->overruntime = overruntime;
                 j->deadline = deadline;
                 j->computation = computation;
+                j->taskpos = -1;
                 return j;
         } else {  // GCOVR_EXCL_START
                 fprintf(stderr, "error allocating memory for job: %s\n",
@@ -42,12 +133,18 @@ job* job_init(JOB_INT const taskid,
 }
 
 void job_free(job* const j) {
-        free(j);
+        job_release(j);
 }
 
 JOB_INT job_get_taskid(job* const j) {
         return j->taskid;
 }
+int job_get_taskpos(job* const j) {
+        return j->taskpos;
+}
+void job_set_taskpos(job* const j, int taskpos) {
+        j->taskpos = taskpos;
+}
 JOB_INT job_get_starttime(job* const j) {
         return j->starttime;
 }
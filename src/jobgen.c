@@ -7,6 +7,7 @@ This software is distributed without any warranty.
 You should have received a copy of the CC0 Public Domain Dedication along with
 this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
 */
+#define _POSIX_C_SOURCE 200112L  // posix_memalign
 #include "jobgen.h"
 #include <assert.h>
 #include <inttypes.h>
@@ -14,32 +15,294 @@ this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#if defined(__AVX2__) || defined(__SSE4_2__)
+#include <immintrin.h>
+#endif
 #include "jobq.h"
 #include "rnd.h"
 #include "stats.h"
 #include "task.h"
+#include "tourn.h"
 #include "ts.h"
 
+#define JOBGEN_NONE INT64_MAX    // next arrival of task without pending job
+#define JOBGEN_LANES 4           // int64 per SIMD register
+#define JOBGEN_CACHELINE 64
+
+/*
+ * With JOBGEN_ARRAY the generator holds the pending job of each task in a slot
+ * indexed by task position, next to a flat array of the arrival times of these
+ * jobs. The earliest arrival is found by scanning the array, or for more than
+ * JOBGEN_SCAN_MAX tasks by a tournament tree over the slots. Jobs of equal
+ * arrival leave in order of their creation, like in a job queue.
+ */
 struct jobgen {
         ts const* tsy;
+        ts_params const* params;
+
+        jobgen_queue queue;
+        jobq* jq;  // other than JOBGEN_ARRAY
+        int64_t* next;
+        uint64_t* seq;
+        job** pending;
+        tourn* tt;  // more than JOBGEN_SCAN_MAX tasks
+        int n;
+        int padded;  // n rounded up to full SIMD registers
+        uint64_t seqno;
 
-        jobq* jq;
         JOB_INT* simtime_state;
         rnd_pcg_t** pcg;
+
+        jobgen_rng rng;
+        uint32_t seed;
+        uint64_t* jobcount;  // jobs generated per task
+        rnd_pcg_t* streams;  // JOBGEN_RNG_BATCH, one per task
+        float* expo;         // JOBGEN_BATCH interarrival factors per task
+        float* comp;         // JOBGEN_BATCH computation times per task
+        int* drawn;          // used up entries of expo and comp per task
+
+        trace_writer* record;
+        trace* replay;
+        trace_csv* csv;
 };
 
-static void refill_generator(jobgen* jg, TASK_INT taskid);
+#define JOBGEN_PHILOX_KEY 0x7468726561647921  // Arbitrary second key word
+
+static void refill_generator(jobgen* jg, int k);
+
+static jobq_kind jobq_kind_of(jobgen_queue const queue) {
+        switch (queue) {
+                case JOBGEN_CALENDAR:
+                        return JOBQ_CALENDAR;
+                default:
+                        return JOBQ_HEAP;
+        }
+}
+
+static void slots_init(jobgen* const jg) {
+        int n = jg->n = ts_length(jg->tsy);
+        // Pad the arrays with empty slots to at least one SIMD register
+        int padded = jg->padded = (n / JOBGEN_LANES + 1) * JOBGEN_LANES;
+        void* next = NULL;
+        if (posix_memalign(&next, JOBGEN_CACHELINE, padded * sizeof(int64_t))) {
+                next = NULL;  // GCOVR_EXCL_LINE
+        }
+        jg->next = next;
+        jg->seq = calloc(padded, sizeof(uint64_t));
+        jg->pending = calloc(padded, sizeof(job*));
+        if (!jg->next || !jg->seq || !jg->pending) {  // GCOVR_EXCL_START
+                fprintf(stderr, "error allocating memory for jobgen\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        for (int k = 0; k < padded; k++) {
+                jg->next[k] = JOBGEN_NONE;
+        }
+        if (n > JOBGEN_SCAN_MAX) {
+                jg->tt = tourn_init(n);
+        }
+}
+
+static void slots_set(jobgen* const jg, int const k, job* const j) {
+        jg->pending[k] = j;
+        jg->next[k] = job_get_starttime(j);
+        jg->seq[k] = jg->seqno++;
+        if (jg->tt) {
+                tourn_update(jg->tt, k, jg->next[k], jg->seq[k]);
+        }
+}
+
+static void slots_clear(jobgen* const jg, int const k) {
+        jg->pending[k] = NULL;
+        jg->next[k] = JOBGEN_NONE;
+        if (jg->tt) {
+                tourn_clear(jg->tt, k);
+        }
+}
+
+/* Lanes holding the earliest arrival, whose position is the earliest one of
+ * the lane; sets dup if more than one task arrives at min */
+static int lanes_argmin(int64_t const* const min,
+                        int64_t const* const pos,
+                        int64_t const* const dup,
+                        int const lanes,
+                        bool* const tie) {
+        int best = 0;
+        for (int l = 1; l < lanes; l++) {
+                best = min[l] < min[best] ? l : best;
+        }
+        *tie = dup[best] != 0;
+        for (int l = 0; l < lanes; l++) {
+                *tie = *tie || (l != best && min[l] == min[best]);
+        }
+        return min[best] == JOBGEN_NONE ? -1 : (int)pos[best];
+}
 
-jobgen* jobgen_init(ts const* const tasksystem, uint32_t seed, bool refill) {
-        jobq* jque = jobq_init();
+/* Returns the position of a task with the earliest arrival or -1, and
+ * whether another task arrives at the same time, in one pass */
+static int slots_argmin(int64_t const* const next,
+                        int const padded,
+                        bool* const tie) {
+#if defined(__AVX2__)
+        __m256i vmin = _mm256_set1_epi64x(JOBGEN_NONE);
+        __m256i vpos = _mm256_setzero_si256();
+        __m256i vdup = _mm256_setzero_si256();
+        __m256i k = _mm256_set_epi64x(3, 2, 1, 0);
+        __m256i const step = _mm256_set1_epi64x(4);
+        for (int i = 0; i < padded; i += 4) {
+                __m256i v = _mm256_load_si256((__m256i const*)(next + i));
+                __m256i lt = _mm256_cmpgt_epi64(vmin, v);
+                __m256i eq = _mm256_cmpeq_epi64(vmin, v);
+                vmin = _mm256_blendv_epi8(vmin, v, lt);
+                vpos = _mm256_blendv_epi8(vpos, k, lt);
+                vdup = _mm256_or_si256(_mm256_andnot_si256(lt, vdup), eq);
+                k = _mm256_add_epi64(k, step);
+        }
+        int64_t min[4];
+        int64_t pos[4];
+        int64_t dup[4];
+        _mm256_storeu_si256((__m256i*)min, vmin);
+        _mm256_storeu_si256((__m256i*)pos, vpos);
+        _mm256_storeu_si256((__m256i*)dup, vdup);
+        return lanes_argmin(min, pos, dup, 4, tie);
+#elif defined(__SSE4_2__)
+        __m128i vmin = _mm_set1_epi64x(JOBGEN_NONE);
+        __m128i vpos = _mm_setzero_si128();
+        __m128i vdup = _mm_setzero_si128();
+        __m128i k = _mm_set_epi64x(1, 0);
+        __m128i const step = _mm_set1_epi64x(2);
+        for (int i = 0; i < padded; i += 2) {
+                __m128i v = _mm_load_si128((__m128i const*)(next + i));
+                __m128i lt = _mm_cmpgt_epi64(vmin, v);
+                __m128i eq = _mm_cmpeq_epi64(vmin, v);
+                vmin = _mm_blendv_epi8(vmin, v, lt);
+                vpos = _mm_blendv_epi8(vpos, k, lt);
+                vdup = _mm_or_si128(_mm_andnot_si128(lt, vdup), eq);
+                k = _mm_add_epi64(k, step);
+        }
+        int64_t min[2];
+        int64_t pos[2];
+        int64_t dup[2];
+        _mm_storeu_si128((__m128i*)min, vmin);
+        _mm_storeu_si128((__m128i*)pos, vpos);
+        _mm_storeu_si128((__m128i*)dup, vdup);
+        return lanes_argmin(min, pos, dup, 2, tie);
+#else
+        int64_t min = JOBGEN_NONE;
+        int64_t pos = 0;
+        int64_t dup = 0;
+        for (int i = 0; i < padded; i++) {
+                dup = next[i] < min ? 0 : dup || next[i] == min;
+                pos = next[i] < min ? i : pos;
+                min = next[i] < min ? next[i] : min;
+        }
+        return lanes_argmin(&min, &pos, &dup, 1, tie);
+#endif
+}
+
+/* Returns position of the task with the earliest pending job or -1 */
+static int slots_earliest(jobgen const* const jg) {
+        if (jg->tt) {
+                return tourn_winner(jg->tt);
+        }
+        int const padded = jg->padded;
+        bool tie;
+        int const earliest = slots_argmin(jg->next, padded, &tie);
+        if (earliest < 0 || !tie) {
+                return earliest;
+        }
+        // Among all tasks with a job arriving at min pick the oldest job
+        int64_t const min = jg->next[earliest];
+        int oldest = earliest;
+        for (int k = 0; k < padded; k++) {
+                if ((jg->next[k] == min) && (jg->seq[k] < jg->seq[oldest])) {
+                        oldest = k;
+                }
+        }
+        return oldest;
+}
+
+static void batch_init(jobgen* const jg) {
+        int n = ts_length(jg->tsy);
+        jg->streams = calloc(n ? n : 1, sizeof(rnd_pcg_t));
+        jg->expo = calloc(n ? n * JOBGEN_BATCH : 1, sizeof(float));
+        jg->comp = calloc(n ? n * JOBGEN_BATCH : 1, sizeof(float));
+        jg->drawn = calloc(n ? n : 1, sizeof(int));
+        if (!jg->streams || !jg->expo || !jg->comp || !jg->drawn) {
+                // GCOVR_EXCL_START
+                fprintf(stderr, "error allocating memory for jobgen\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        for (int k = 0; k < n; k++) {
+                stats_seed_stream(jg->streams + k, jg->seed,
+                                  (uint64_t)jg->params->ids[k]);
+                jg->drawn[k] = JOBGEN_BATCH;
+        }
+}
+
+/* Draw the random numbers of the next JOBGEN_BATCH jobs of task k */
+static void batch_draw(jobgen* const jg, int const k) {
+        ts_params const* p = jg->params;
+        float u[3 * JOBGEN_BATCH];
+        if (jg->rng == JOBGEN_RNG_COUNTER) {
+                uint32_t key[2] = {jg->seed, (uint32_t)JOBGEN_PHILOX_KEY};
+                philox_fill(key, (uint64_t)p->ids[k], jg->jobcount[k], u,
+                            JOBGEN_BATCH);
+        } else {
+                rnd_pcg_t* pcg = jg->streams + k;
+                uniformf_fill(&pcg, u, 3 * JOBGEN_BATCH);
+        }
+
+        float bounds[TASK_NUM_COMP];
+        for (int i = 0; i < TASK_NUM_COMP; i++) {
+                bounds[i] = (float)p->comp[i][k];
+        }
+        exponential_fill(u, p->beta[k], jg->expo + k * JOBGEN_BATCH,
+                         JOBGEN_BATCH);
+        uniform3_fill(u + JOBGEN_BATCH, u + 2 * JOBGEN_BATCH, p->prob[0][k],
+                      p->prob[1][k], bounds, jg->comp + k * JOBGEN_BATCH,
+                      JOBGEN_BATCH);
+        jg->drawn[k] = 0;
+}
+
+/* Continue the random numbers of task k at its job jobcount[k] */
+static void batch_seek(jobgen* const jg, int const k) {
+        uint64_t count = jg->jobcount[k];
+        jg->drawn[k] = JOBGEN_BATCH;
+        if (jg->rng == JOBGEN_RNG_BATCH) {
+                // Batches are drawn at multiples of JOBGEN_BATCH jobs
+                uint64_t offset = count % JOBGEN_BATCH;
+                stats_seed_stream(jg->streams + k, jg->seed,
+                                  (uint64_t)jg->params->ids[k]);
+                stats_pcg_advance(jg->streams + k, 3 * (count - offset));
+                if (offset) {
+                        batch_draw(jg, k);
+                        jg->drawn[k] = offset;
+                }
+        }
+}
+
+jobgen* jobgen_init(ts const* const tasksystem,
+                    uint32_t seed,
+                    bool refill,
+                    jobgen_queue queue,
+                    jobgen_rng rng) {
         JOB_INT* simtime_state = calloc(ts_length(tasksystem), sizeof(JOB_INT));
+        uint64_t* jobcount = calloc(ts_length(tasksystem), sizeof(uint64_t));
         jobgen* jgen = calloc(1, sizeof(jobgen));
 
         // Maybe flatten error handling with goto?
-        if (jgen && simtime_state) {
-                jgen->jq = jque;
+        if (jgen && simtime_state && jobcount) {
+                jgen->queue = queue;
                 jgen->tsy = tasksystem;
+                jgen->params = ts_get_params(tasksystem);
+                if (queue == JOBGEN_ARRAY) {
+                        slots_init(jgen);
+                } else {
+                        jgen->jq =
+                            jobq_init_as(jobq_kind_of(queue), tasksystem);
+                }
                 jgen->simtime_state = simtime_state;
+                jgen->jobcount = jobcount;
                 jgen->pcg = calloc(1, sizeof(rnd_pcg_t*));
                 if (jgen->pcg) {
                         *(jgen->pcg) = calloc(1, sizeof(rnd_pcg_t));
@@ -53,6 +316,11 @@ jobgen* jobgen_init(ts const* const tasksystem, uint32_t seed, bool refill) {
                         exit(EXIT_FAILURE);
                 }  // GCOVR_EXCL_STOP
                 rnd_pcg_seed(*(jgen->pcg), seed);
+                jgen->rng = rng;
+                jgen->seed = seed;
+                if (rng != JOBGEN_RNG_SHARED) {
+                        batch_init(jgen);
+                }
         } else {  // GCOVR_EXCL_START
                 fprintf(stderr, "error allocating memory for jobgen\n");
                 exit(EXIT_FAILURE);
@@ -60,26 +328,46 @@ jobgen* jobgen_init(ts const* const tasksystem, uint32_t seed, bool refill) {
 
         if (refill) {
                 for (int k = 0; k < ts_length(tasksystem); k++) {
-                        task* t = ts_get_by_pos(tasksystem, k);
-                        refill_generator(jgen, task_get_id(t));
+                        refill_generator(jgen, k);
                 }
         }
 
         return jgen;
 }
 
+static void slots_free(jobgen* jg) {
+        for (int k = 0; k < jg->n; k++) {
+                job_free(jg->pending[k]);
+        }
+        free(jg->next);
+        free(jg->seq);
+        free(jg->pending);
+        if (jg->tt) {
+                tourn_free(jg->tt);
+        }
+}
+
 void jobgen_free(jobgen* jg) {
         free(jg->simtime_state);
-        jobq_free(jg->jq);
+        free(jg->jobcount);
+        if (jg->queue == JOBGEN_ARRAY) {
+                slots_free(jg);
+        } else {
+                jobq_free(jg->jq);
+        }
         free(*(jg->pcg));
         free(jg->pcg);
+        free(jg->streams);
+        free(jg->expo);
+        free(jg->comp);
+        free(jg->drawn);
         free(jg);
 }
 
-static float uniform3(rnd_pcg_t** pcg, task* t) {
+static float uniform3(rnd_pcg_t** pcg, ts_params const* const p, int k) {
         float y = uniformf(pcg, 0.0f, 1.0f);
-        float p0 = task_get_prob(t, 0);
-        float p1 = task_get_prob(t, 1);
+        float p0 = p->prob[0][k];
+        float p1 = p->prob[1][k];
 
         int segment = 0;
         if (y > p0 + p1) {
@@ -89,33 +377,44 @@ static float uniform3(rnd_pcg_t** pcg, task* t) {
         } else {
                 segment = 0;
         }
-        TASK_INT clow = task_get_comp(t, 2 * segment);
-        TASK_INT chigh = task_get_comp(t, 2 * segment + 1);
+        TASK_INT clow = p->comp[2 * segment][k];
+        TASK_INT chigh = p->comp[2 * segment + 1][k];
 
         return uniformf(pcg, (float)clow, (float)chigh);
 }
 
-static void refill_generator(jobgen* jg, TASK_INT taskid) {
-        int k = ts_get_pos_by_id(jg->tsy, taskid);
-        task* t = ts_get_by_id(jg->tsy, taskid);
+static void refill_generator(jobgen* jg, int k) {
+        ts_params const* p = jg->params;
 
         JOB_INT simtime = *(jg->simtime_state + k);
-        TASK_INT period = task_get_period(t);
-        TASK_INT reldead = task_get_reldead(t);
-        float interarrivalfactor = task_get_beta(t);
+        TASK_INT period = p->periods[k];
+        TASK_INT reldead = p->reldeads[k];
+        float interarrivalfactor = p->beta[k];
 
-        JOB_INT rho = exponential(jg->pcg, interarrivalfactor) * period;
-        JOB_INT gamma = ceil(uniform3(jg->pcg, t));
+        float expo;
+        float comp;
+        if (jg->rng != JOBGEN_RNG_SHARED) {
+                if (jg->drawn[k] == JOBGEN_BATCH) {
+                        batch_draw(jg, k);
+                }
+                expo = jg->expo[k * JOBGEN_BATCH + jg->drawn[k]];
+                comp = jg->comp[k * JOBGEN_BATCH + jg->drawn[k]++];
+        } else {
+                expo = exponential(jg->pcg, interarrivalfactor);
+                comp = uniform3(jg->pcg, p, k);
+        }
+        JOB_INT rho = expo * period;
+        JOB_INT gamma = ceil(comp);
         assert(gamma > 0);
         JOB_INT alpha = simtime;
         simtime = simtime + period + rho;
         JOB_INT deadline = alpha + reldead;
 
-        JOB_INT c1 = task_get_comp(t, 1);
+        JOB_INT c1 = p->comp[1][k];
         // If a non-zero computation budget is defined and we can reach it by
         // chance the task is a high criticality task and can overrun.
-        JOB_INT c2 = task_get_comp(t, 2);
-        float p0 = task_get_prob(t, 0);
+        JOB_INT c2 = p->comp[2][k];
+        float p0 = p->prob[0][k];
         JOB_INT overruntime;
         if ((c2 > 0) && (p0 < 1.0f)) {
                 /* Overrun time is relative, don't know absolute times until
@@ -128,25 +427,119 @@ static void refill_generator(jobgen* jg, TASK_INT taskid) {
                 overruntime = gamma + 1;
         }
 
-        job* job = job_init(taskid, alpha, overruntime, deadline, gamma);
+        job* job = job_init(p->ids[k], alpha, overruntime, deadline, gamma);
+        job_set_taskpos(job, k);
 
         *(jg->simtime_state + k) = simtime;
-        jobq_insert_by(jg->jq, job, job_get_starttime);
+        jg->jobcount[k]++;
+        if (jg->queue == JOBGEN_ARRAY) {
+                slots_set(jg, k, job);
+        } else {
+                jobq_insert_by(jg->jq, job, job_get_starttime);
+        }
+}
+
+static job* replay_rise(jobgen* jg) {
+        if (jg->csv) {
+                // Nothing arrives after the last job of a measured trace
+                job* j = trace_csv_next(jg->csv);
+                if (j) {
+                        jg->jobcount[job_get_taskpos(j)]++;
+                }
+                return j;
+        }
+        job* j = trace_next(jg->replay);
+        if (!j) {  // GCOVR_EXCL_START
+                fprintf(stderr,
+                        "job trace ends after %" PRIu64
+                        " jobs, record up to a later breaktime\n",
+                        trace_tell(jg->replay));
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        jg->jobcount[job_get_taskpos(j)]++;
+        return j;
+}
+
+static job* generate_rise(jobgen* jg) {
+        job* j;
+        int k;
+        if (jg->queue == JOBGEN_ARRAY) {
+                k = slots_earliest(jg);
+                if (k < 0) {
+                        return NULL;
+                }
+                j = jg->pending[k];
+        } else {
+                j = jobq_pop(jg->jq);
+                if (!j) {
+                        return NULL;
+                }
+                k = job_get_taskpos(j);
+        }
+        // mission still running, generator not exhausted
+        refill_generator(jg, k);
+        return j;
 }
 
 job* jobgen_rise(jobgen* jg) {
-        job* j = jobq_pop(jg->jq);
-        if (j) {  // mission still running, generator not exhausted
-                refill_generator(jg, job_get_taskid(j));
+        job* j = jg->replay || jg->csv ? replay_rise(jg) : generate_rise(jg);
+        if (jg->record && j) {
+                trace_write(jg->record, j);
         }
         return j;
 }
+
+void jobgen_record(jobgen* jg, trace_writer* tw) {
+        jg->record = tw;
+}
+
+uint64_t jobgen_get_released(jobgen const* const jg) {
+        // Every generated job is either released or pending
+        uint64_t released = 0;
+        for (int k = 0; k < ts_length(jg->tsy); k++) {
+                released += jg->jobcount[k];
+        }
+        if (jg->queue == JOBGEN_ARRAY) {
+                for (int k = 0; k < jg->n; k++) {
+                        released -= jg->pending[k] != NULL;
+                }
+        } else {
+                released -= jobq_length(jg->jq);
+        }
+        return released;
+}
+
+/* Drop the pending jobs, which are part of the replayed trace */
+static void drop_pending(jobgen* jg) {
+        if (jg->queue == JOBGEN_ARRAY) {
+                for (int k = 0; k < jg->n; k++) {
+                        job_free(jg->pending[k]);
+                        slots_clear(jg, k);
+                }
+        } else {
+                job* j;
+                while ((j = jobq_pop(jg->jq))) {
+                        job_free(j);
+                }
+        }
+}
+
+void jobgen_replay(jobgen* jg, trace* tr) {
+        jg->replay = tr;
+        trace_seek(tr, jobgen_get_released(jg));
+        drop_pending(jg);
+}
+
+void jobgen_replay_csv(jobgen* jg, trace_csv* tc) {
+        jg->csv = tc;
+        trace_csv_skip(tc, jobgen_get_released(jg));
+        drop_pending(jg);
+}
+
 void jobgen_refill_all(jobgen* jg) {
         int n = ts_length(jg->tsy);
         for (int i = 0; i < n; i++) {
-                task* t = ts_get_by_pos(jg->tsy, i);
-                TASK_INT tid = task_get_id(t);
-                refill_generator(jg, tid);
+                refill_generator(jg, i);
         }
 }
 
@@ -161,15 +554,147 @@ void jobgen_set_simtime(jobgen* jg, JOB_INT* simtimes, int len) {
         }
 }
 
+void jobgen_set_jobcount(jobgen* jg, uint64_t const* counts, int len) {
+        int tasks = ts_length(jg->tsy);
+        if (tasks != len) {  // GCOVR_EXCL_START
+                fprintf(stderr,
+                        "can't set job counts due to length mismatch\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        for (int i = 0; i < tasks; i++) {
+                jg->jobcount[i] = counts[i];
+                if (jg->rng != JOBGEN_RNG_SHARED) {
+                        batch_seek(jg, i);
+                }
+        }
+}
+
+uint64_t jobgen_get_jobcount(jobgen const* const jg, int const pos) {
+        return jg->jobcount[pos];
+}
+
+JOB_INT jobgen_get_simtime(jobgen const* const jg, int const pos) {
+        return jg->simtime_state[pos];
+}
+
+jobgen_rng jobgen_get_rng(jobgen const* const jg) {
+        return jg->rng;
+}
+
+void jobgen_get_rngstate(jobgen const* const jg,
+                         uint32_t* const seed,
+                         uint64_t pcg[2]) {
+        *seed = jg->seed;
+        pcg[0] = (*(jg->pcg))->state[0];
+        pcg[1] = (*(jg->pcg))->state[1];
+}
+
+void jobgen_set_rngstate(jobgen* jg,
+                         uint32_t const seed,
+                         uint64_t const pcg[2]) {
+        jg->seed = seed;
+        (*(jg->pcg))->state[0] = pcg[0];
+        (*(jg->pcg))->state[1] = pcg[1];
+}
+
 ts const* jobgen_get_tasksystem(jobgen const* const jg) {
         return jg->tsy;
 }
 
+typedef struct {
+        int64_t next;
+        uint64_t seq;
+        job* j;
+} arrival;
+
+static int compare_arrival(void const* a, void const* b) {
+        arrival const* x = a;
+        arrival const* y = b;
+        if (x->next != y->next) {
+                return x->next < y->next ? -1 : 1;
+        }
+        return x->seq < y->seq ? -1 : x->seq > y->seq;
+}
+
+void jobgen_dump_json(jobgen const* const jg, out* o) {
+        out_str(o, ",\"seed\":");
+        out_int(o, jg->seed);
+        out_str(o, ",\"rng\":");
+        out_int(o, jg->rng);
+        // Unsigned state is stored as two's complement
+        out_str(o, ",\"pcg\":[");
+        out_int(o, (int64_t)(*(jg->pcg))->state[0]);
+        out_char(o, ',');
+        out_int(o, (int64_t)(*(jg->pcg))->state[1]);
+        out_str(o, "],\"tasks\":[");
+        for (int k = 0; k < ts_length(jg->tsy); k++) {
+                out_str(o, k ? ",[" : "[");
+                out_int(o, jg->params->ids[k]);
+                out_char(o, ',');
+                out_int(o, jg->simtime_state[k]);
+                out_char(o, ',');
+                out_int(o, (int64_t)jg->jobcount[k]);
+                out_char(o, ']');
+        }
+        out_char(o, ']');
+}
+
 int jobgen_dump(jobgen const* const jg, void*** dst) {
-        return jobq_dump(jg->jq, dst);
+        if (jg->queue != JOBGEN_ARRAY) {
+                return jobq_dump(jg->jq, dst);
+        }
+        // List pending jobs in the order they rise
+        int n = jg->n;
+        arrival* s = calloc(n ? n : 1, sizeof(arrival));
+        *dst = calloc(n ? n : 1, sizeof(void*));
+        if (!s || !*dst) {  // GCOVR_EXCL_START
+                fprintf(stderr, "error allocating memory for jobgen dump\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        int len = 0;
+        for (int k = 0; k < n; k++) {
+                if (jg->pending[k]) {
+                        s[len++] = (arrival){jg->next[k], jg->seq[k],
+                                          jg->pending[k]};
+                }
+        }
+        qsort(s, len, sizeof(arrival), compare_arrival);
+        for (int i = 0; i < len; i++) {
+                *(*dst + i) = s[i].j;
+        }
+        free(s);
+        return len;
 }
 
 void jobgen_replace_jobq(jobgen* const jgen, jobq* const jq) {
-        jobq_free(jgen->jq);
-        jgen->jq = jq;
+        job* j;
+        if (jgen->queue == JOBGEN_ARRAY) {
+                for (int k = 0; k < jgen->n; k++) {
+                        job_free(jgen->pending[k]);
+                        slots_clear(jgen, k);
+                }
+                while ((j = jobq_pop(jq))) {
+                        int k = job_get_taskpos(j);
+                        if (k < 0) {
+                                k = ts_get_pos_by_id(jgen->tsy,
+                                                     job_get_taskid(j));
+                                job_set_taskpos(j, k);
+                        }
+                        if (jgen->pending[k]) {  // GCOVR_EXCL_START
+                                fprintf(stderr,
+                                        "more than one pending job of task "
+                                        "%" PRId64 "\n",
+                                        (int64_t)job_get_taskid(j));
+                                exit(EXIT_FAILURE);
+                        }  // GCOVR_EXCL_STOP
+                        slots_set(jgen, k, j);
+                }
+        } else {
+                jobq_free(jgen->jq);
+                jgen->jq = jobq_init_as(jobq_kind_of(jgen->queue), jgen->tsy);
+                while ((j = jobq_pop(jq))) {
+                        jobq_insert_by(jgen->jq, j, job_get_starttime);
+                }
+        }
+        jobq_free(jq);
 }
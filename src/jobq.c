@@ -7,17 +7,261 @@ This software is distributed without any warranty.
 You should have received a copy of the CC0 Public Domain Dedication along with
 this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
 */
+#define _POSIX_C_SOURCE 200112L  // posix_memalign
 #include "jobq.h"
 #include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "tourn.h"
+#ifdef JOBQ_PQUEUE
 #include "pqueue.h"
+#endif
 
+/* Queue key; jobs of equal priority leave the queue in insertion order. */
+typedef struct key {
+        JOB_INT pri;
+        uint64_t seq;
+} key;
+
+typedef struct entry {
+        key k;
+        job* j;
+} entry;
+
+/* Jobs of a single task ordered by priority */
+typedef struct fifo {
+        key* keys;
+        job** jobs;
+        size_t head;
+        size_t count;
+        size_t avail;  // power of two
+} fifo;
+
+/* Jobs of a calendar day ordered by priority, live entries are [head, end) */
+typedef struct bucket {
+        entry* e;
+        size_t head;
+        size_t end;
+        size_t avail;
+} bucket;
+
+/*
+ * JOBQ_HEAP is a d-ary min-heap stored in two parallel arrays: the keys, which
+ * are all a sift has to compare, and the jobs, which are only moved. The key
+ * array is offset such that all children of a node share one cache line.
+ *
+ * JOBQ_PERTASK keeps one fifo per task of the task system and a tournament
+ * tree over the heads of all fifos.
+ *
+ * JOBQ_CALENDAR is a calendar queue (R. Brown, 1988): Jobs are hashed by
+ * priority into days (buckets) of width priorities, which wrap around after a
+ * year of nbuckets days. Dequeue scans the days of the current year starting at
+ * the day of the last dequeued job. The calendar is resized to keep about one
+ * to two jobs per day, deriving the width from the spacing of the earliest
+ * jobs.
+ */
 struct jobq {
+        jobq_kind kind;
+        uint64_t seq;
+        size_t count;  // queued jobs of any kind
+        size_t peak;   // greatest count since initialization
+#ifndef JOBQ_PQUEUE
+        key* keys;
+        job** jobs;
+        void* mem;  // allocation backing keys
+        size_t size;
+        size_t avail;
+#else
         pqueue_t* pq;
+#endif
+        ts const* tsy;
+        fifo* fifos;
+        tourn* tt;
+        bucket* days;
+        size_t ndays;  // power of two
+        size_t length;
+        size_t today;
+        JOB_INT width;
+        JOB_INT top;  // end of today in the current year
 };
 
+static inline int before(key const a, key const b) {
+        return (a.pri < b.pri) || ((a.pri == b.pri) && (a.seq < b.seq));
+}
+
+static int compare_entry(const void* a, const void* b) {
+        return before(((entry*)b)->k, ((entry*)a)->k) -
+               before(((entry*)a)->k, ((entry*)b)->k);
+}
+
+/* Write jobs of @p e in order of priority to a new array @p dst */
+static int dump_entries(entry* const e, size_t const n, void*** dst) {
+        *dst = calloc(n, sizeof(void*));
+        if (!*dst) {
+                return 0;
+        }
+        qsort(e, n, sizeof(entry), compare_entry);
+        for (size_t i = 0; i < n; i++) {
+                *(*dst + i) = e[i].j;
+        }
+        return n;
+}
+
+#ifndef JOBQ_PQUEUE
+#define JOBQ_CACHELINE 64
+#define JOBQ_KEYS_PER_LINE (JOBQ_CACHELINE / sizeof(key))
+#define JOBQ_OFFSET (JOBQ_KEYS_PER_LINE - 1)
+
+static void heap_grow(jobq* const jq) {
+        size_t avail = jq->avail ? 2 * jq->avail : JOBQ_KEYS_PER_LINE * 4;
+        void* mem = NULL;
+        job** jobs = realloc(jq->jobs, avail * sizeof(job*));
+        if (!jobs || posix_memalign(&mem, JOBQ_CACHELINE,
+                                    (avail + JOBQ_OFFSET) * sizeof(key))) {
+                // GCOVR_EXCL_START
+                fprintf(stderr, "error allocating memory for jobq: %s\n",
+                        strerror(errno));
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        key* keys = (key*)mem + JOBQ_OFFSET;
+        if (jq->size) {
+                memcpy(keys, jq->keys, jq->size * sizeof(key));
+        }
+        free(jq->mem);
+        jq->mem = mem;
+        jq->keys = keys;
+        jq->jobs = jobs;
+        jq->avail = avail;
+}
+
+static void sift_up(jobq* const jq, size_t i, key const k, job* const j) {
+        while (i > 0) {
+                size_t parent = (i - 1) / JOBQ_ARITY;
+                if (!before(k, jq->keys[parent])) {
+                        break;
+                }
+                jq->keys[i] = jq->keys[parent];
+                jq->jobs[i] = jq->jobs[parent];
+                i = parent;
+        }
+        jq->keys[i] = k;
+        jq->jobs[i] = j;
+}
+
+static void sift_down(jobq* const jq, size_t i, key const k, job* const j) {
+        size_t const n = jq->size;
+        for (;;) {
+                size_t first = JOBQ_ARITY * i + 1;
+                if (first >= n) {
+                        break;
+                }
+                size_t last = first + JOBQ_ARITY < n ? first + JOBQ_ARITY : n;
+                size_t min = first;
+                for (size_t c = first + 1; c < last; c++) {
+                        if (before(jq->keys[c], jq->keys[min])) {
+                                min = c;
+                        }
+                }
+                if (!before(jq->keys[min], k)) {
+                        break;
+                }
+                jq->keys[i] = jq->keys[min];
+                jq->jobs[i] = jq->jobs[min];
+                i = min;
+        }
+        jq->keys[i] = k;
+        jq->jobs[i] = j;
+}
+
+static void heap_init(jobq* const jq) {
+        heap_grow(jq);
+}
+
+static void heap_insert(jobq* const jq, job* const j, key const k) {
+        if (jq->size == jq->avail) {
+                heap_grow(jq);
+        }
+        sift_up(jq, jq->size++, k, j);
+}
+
+/* Floyd's heap construction, O(n) for n appended jobs */
+static void heap_load(jobq* const jq,
+                      job** const jobs,
+                      size_t const n,
+                      JOB_INT (*func)(job* const)) {
+        while (jq->avail < jq->size + n) {
+                heap_grow(jq);
+        }
+        for (size_t i = 0; i < n; i++) {
+                jq->keys[jq->size] = (key){func(jobs[i]), jq->seq++};
+                jq->jobs[jq->size] = jobs[i];
+                jq->size++;
+        }
+        if (jq->size > 1) {
+                for (size_t i = (jq->size - 2) / JOBQ_ARITY + 1; i-- > 0;) {
+                        sift_down(jq, i, jq->keys[i], jq->jobs[i]);
+                }
+        }
+}
+
+static job* heap_pop(jobq* const jq) {
+        if (!jq->size) {
+                return NULL;
+        }
+        job* j = jq->jobs[0];
+        jq->size--;
+        if (jq->size) {
+                sift_down(jq, 0, jq->keys[jq->size], jq->jobs[jq->size]);
+        }
+        return j;
+}
+
+static job* heap_peek(jobq* const jq) {
+        return jq->size ? jq->jobs[0] : NULL;
+}
+
+static void heap_free(jobq* const jq) {
+        for (size_t i = 0; i < jq->size; i++) {
+                job_free(jq->jobs[i]);
+        }
+        free(jq->mem);
+        free(jq->jobs);
+}
+
+static int heap_dump(jobq const* const jq, void*** dst) {
+        // Pop all jobs from a copy to list them in order of priority
+        jobq dup = *jq;
+        dup.avail = 0;
+        dup.size = 0;
+        dup.mem = NULL;
+        dup.jobs = NULL;
+        while (dup.avail < jq->size) {
+                heap_grow(&dup);
+        }
+        if (jq->size) {
+                memcpy(dup.keys, jq->keys, jq->size * sizeof(key));
+                memcpy(dup.jobs, jq->jobs, jq->size * sizeof(job*));
+        }
+        dup.size = jq->size;
+
+        *dst = calloc(jq->size, sizeof(void*));
+        int i = 0;
+        if (*dst) {
+                job* j;
+                while ((j = heap_pop(&dup))) {
+                        *(*dst + i) = j;
+                        i++;
+                }
+        }
+        free(dup.mem);
+        free(dup.jobs);
+        return i;
+}
+#else
+/* Reference implementation on top of the generic pqueue */
 typedef struct node_t {
         pqueue_pri_t pri;
         size_t pos;
@@ -47,30 +291,22 @@ static void set_pos(void* a, size_t pos) {
         ((node_t*)a)->pos = pos;
 }
 
-jobq* jobq_init() {
-        jobq* jq = calloc(1, sizeof(jobq));
-        if (!jq) {  // GCOVR_EXCL_START
-                fprintf(stderr, "error allocating memory for jobq: %s\n",
-                        strerror(errno));
-                exit(EXIT_FAILURE);
-        }  // GCOVR_EXCL_STOP
+static void heap_init(jobq* const jq) {
         jq->pq = pqueue_init(10, cmp_pri, get_pri, set_pri, get_pos, set_pos);
         if (!jq->pq) {  // GCOVR_EXCL_START
                 fprintf(stderr, "error allocating memory for jobq\n");
                 exit(EXIT_FAILURE);
         }  // GCOVR_EXCL_STOP
-        return jq;
 }
 
-void jobq_insert_by(jobq* const jq, job* const j, JOB_INT (*func)(job* const)) {
-        JOB_INT pri = func(j);
+static void heap_insert(jobq* const jq, job* const j, key const k) {
         node_t* n = calloc(1, sizeof(node_t));
         if (!n) {  // GCOVR_EXCL_START
                 fprintf(stderr, "error allocating memory for jobq node: %s\n",
                         strerror(errno));
                 exit(EXIT_FAILURE);
         }  // GCOVR_EXCL_STOP
-        n->pri = pri;
+        n->pri = k.pri;
         n->job = j;
         if (pqueue_insert(jq->pq, n)) {  // GCOVR_EXCL_START
                 fprintf(stderr, "error inserting jobq node\n");
@@ -78,7 +314,7 @@ void jobq_insert_by(jobq* const jq, job* const j, JOB_INT (*func)(job* const)) {
         }  // GCOVR_EXCL_STOP
 }
 
-job* jobq_pop(jobq* const jq) {
+static job* heap_pop(jobq* const jq) {
         job* j = NULL;
         node_t* n = pqueue_pop(jq->pq);
         if (n) {
@@ -88,7 +324,7 @@ job* jobq_pop(jobq* const jq) {
         return j;
 }
 
-job* jobq_peek(jobq* const jq) {
+static job* heap_peek(jobq* const jq) {
         node_t* n = pqueue_peek(jq->pq);
         if (n) {
                 return n->job;
@@ -97,7 +333,7 @@ job* jobq_peek(jobq* const jq) {
         }
 }
 
-void jobq_free(jobq* const jq) {
+static void heap_free(jobq* const jq) {
         node_t* n = NULL;
         while ((n = pqueue_pop(jq->pq))) {
                 job_free(n->job);
@@ -105,7 +341,6 @@ void jobq_free(jobq* const jq) {
         }
         pqueue_free(jq->pq);
         jq->pq = (void*)0;
-        free(jq);
 }
 
 static pqueue_t* pqueue_duplicate(pqueue_t const* const src) {
@@ -121,7 +356,7 @@ static pqueue_t* pqueue_duplicate(pqueue_t const* const src) {
         return dst;
 }
 
-int jobq_dump(jobq const* const jq, void*** dst) {
+static int heap_dump(jobq const* const jq, void*** dst) {
         pqueue_t* dup = pqueue_duplicate(jq->pq);
         *dst = calloc(pqueue_size(dup), sizeof(void*));
         int i = 0;
@@ -135,3 +370,423 @@ int jobq_dump(jobq const* const jq, void*** dst) {
         pqueue_free(dup);
         return i;
 }
+#endif
+
+static void fifo_grow(fifo* const f) {
+        size_t avail = f->avail ? 2 * f->avail : 4;
+        key* keys = calloc(avail, sizeof(key));
+        job** jobs = calloc(avail, sizeof(job*));
+        if (!keys || !jobs) {  // GCOVR_EXCL_START
+                fprintf(stderr, "error allocating memory for jobq: %s\n",
+                        strerror(errno));
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        for (size_t i = 0; i < f->count; i++) {
+                size_t k = (f->head + i) & (f->avail - 1);
+                keys[i] = f->keys[k];
+                jobs[i] = f->jobs[k];
+        }
+        free(f->keys);
+        free(f->jobs);
+        f->keys = keys;
+        f->jobs = jobs;
+        f->head = 0;
+        f->avail = avail;
+}
+
+/* Returns true if the job became the head of the fifo */
+static bool fifo_push(fifo* const f, job* const j, key const k) {
+        if (f->count == f->avail) {
+                fifo_grow(f);
+        }
+        size_t const mask = f->avail - 1;
+        size_t i = f->count++;
+        // Jobs of a task usually arrive in order of priority, only jobs
+        // restored from a state dump may need to be sorted in.
+        while (i > 0 && before(k, f->keys[(f->head + i - 1) & mask])) {
+                size_t to = (f->head + i) & mask;
+                size_t from = (f->head + i - 1) & mask;
+                f->keys[to] = f->keys[from];
+                f->jobs[to] = f->jobs[from];
+                i--;
+        }
+        f->keys[(f->head + i) & mask] = k;
+        f->jobs[(f->head + i) & mask] = j;
+        return i == 0;
+}
+
+static job* fifo_pop(fifo* const f) {
+        job* j = f->jobs[f->head];
+        f->head = (f->head + 1) & (f->avail - 1);
+        f->count--;
+        return j;
+}
+
+static void pertask_init(jobq* const jq, ts const* const tsy) {
+        int n = ts_length(tsy);
+        jq->tsy = tsy;
+        jq->fifos = calloc(n, sizeof(fifo));
+        if (!jq->fifos) {  // GCOVR_EXCL_START
+                fprintf(stderr, "error allocating memory for jobq: %s\n",
+                        strerror(errno));
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        jq->tt = tourn_init(n);
+}
+
+static void pertask_insert(jobq* const jq, job* const j, key const k) {
+        int pos = job_get_taskpos(j);
+        if (pos < 0) {
+                pos = ts_get_pos_by_id(jq->tsy, job_get_taskid(j));
+                job_set_taskpos(j, pos);
+        }
+        if (fifo_push(jq->fifos + pos, j, k)) {
+                tourn_update(jq->tt, pos, k.pri, k.seq);
+        }
+}
+
+static job* pertask_pop(jobq* const jq) {
+        int pos = tourn_winner(jq->tt);
+        if (pos < 0) {
+                return NULL;
+        }
+        fifo* f = jq->fifos + pos;
+        job* j = fifo_pop(f);
+        if (f->count) {
+                key k = f->keys[f->head];
+                tourn_update(jq->tt, pos, k.pri, k.seq);
+        } else {
+                tourn_clear(jq->tt, pos);
+        }
+        return j;
+}
+
+static job* pertask_peek(jobq* const jq) {
+        int pos = tourn_winner(jq->tt);
+        if (pos < 0) {
+                return NULL;
+        }
+        fifo* f = jq->fifos + pos;
+        return f->jobs[f->head];
+}
+
+static void pertask_free(jobq* const jq) {
+        for (int pos = 0; pos < ts_length(jq->tsy); pos++) {
+                fifo* f = jq->fifos + pos;
+                while (f->count) {
+                        job_free(fifo_pop(f));
+                }
+                free(f->keys);
+                free(f->jobs);
+        }
+        free(jq->fifos);
+        tourn_free(jq->tt);
+}
+
+static int pertask_dump(jobq const* const jq, void*** dst) {
+        size_t len = 0;
+        for (int pos = 0; pos < ts_length(jq->tsy); pos++) {
+                len += jq->fifos[pos].count;
+        }
+        entry* e = calloc(len, sizeof(entry));
+        int n = 0;
+        if (e) {
+                for (int pos = 0; pos < ts_length(jq->tsy); pos++) {
+                        fifo* f = jq->fifos + pos;
+                        for (size_t i = 0; i < f->count; i++) {
+                                size_t k = (f->head + i) & (f->avail - 1);
+                                e[i + n].k = f->keys[k];
+                                e[i + n].j = f->jobs[k];
+                        }
+                        n += f->count;
+                }
+                n = dump_entries(e, n, dst);
+        }
+        free(e);
+        return n;
+}
+
+static inline JOB_INT floordiv(JOB_INT const a, JOB_INT const b) {
+        return a / b - ((a % b != 0) && ((a < 0) != (b < 0)));
+}
+
+static inline size_t day_of(jobq const* const jq, JOB_INT const pri) {
+        return (size_t)floordiv(pri, jq->width) & (jq->ndays - 1);
+}
+
+/* Make the day of @p pri today */
+static inline void calendar_goto(jobq* const jq, JOB_INT const pri) {
+        jq->today = day_of(jq, pri);
+        jq->top = (floordiv(pri, jq->width) + 1) * jq->width;
+}
+
+static void bucket_push(bucket* const b, entry const e) {
+        if (b->head && b->end == b->avail) {  // reclaim popped entries
+                b->end -= b->head;
+                memmove(b->e, b->e + b->head, b->end * sizeof(entry));
+                b->head = 0;
+        }
+        if (b->end == b->avail) {
+                b->avail = b->avail ? 2 * b->avail : 4;
+                b->e = realloc(b->e, b->avail * sizeof(entry));
+                if (!b->e) {  // GCOVR_EXCL_START
+                        fprintf(stderr,
+                                "error allocating memory for jobq: %s\n",
+                                strerror(errno));
+                        exit(EXIT_FAILURE);
+                }  // GCOVR_EXCL_STOP
+        }
+        size_t i = b->end++;
+        while (i > b->head && before(e.k, b->e[i - 1].k)) {
+                b->e[i] = b->e[i - 1];
+                i--;
+        }
+        b->e[i] = e;
+}
+
+static void calendar_insert(jobq* const jq, entry const e);
+
+static void calendar_resize(jobq* const jq, size_t const ndays) {
+        size_t n = jq->length;
+        entry* e = calloc(n ? n : 1, sizeof(entry));
+        bucket* days = calloc(ndays, sizeof(bucket));
+        if (!e || !days) {  // GCOVR_EXCL_START
+                fprintf(stderr, "error allocating memory for jobq: %s\n",
+                        strerror(errno));
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        size_t k = 0;
+        for (size_t d = 0; d < jq->ndays; d++) {
+                bucket* b = jq->days + d;
+                for (size_t i = b->head; i < b->end; i++) {
+                        e[k++] = b->e[i];
+                }
+                free(b->e);
+        }
+        free(jq->days);
+        qsort(e, n, sizeof(entry), compare_entry);
+
+        // A day spans three times the average distance of the earliest jobs
+        size_t sample = n < 25 ? n : 25;
+        JOB_INT width = 1;
+        if (sample > 1) {
+                JOB_INT span = e[sample - 1].k.pri - e[0].k.pri;
+                width = 3 * span / (JOB_INT)(sample - 1);
+                width = width > 0 ? width : 1;
+        }
+
+        jq->days = days;
+        jq->ndays = ndays;
+        jq->width = width;
+        jq->length = 0;
+        calendar_goto(jq, n ? e[0].k.pri : 0);
+        for (size_t i = 0; i < n; i++) {
+                calendar_insert(jq, e[i]);
+        }
+        free(e);
+}
+
+static void calendar_init(jobq* const jq) {
+        calendar_resize(jq, 2);
+}
+
+static void calendar_insert(jobq* const jq, entry const e) {
+        if (e.k.pri < jq->top - jq->width) {  // earlier than today
+                calendar_goto(jq, e.k.pri);
+        }
+        bucket_push(jq->days + day_of(jq, e.k.pri), e);
+        jq->length++;
+        if (jq->length > 2 * jq->ndays) {
+                calendar_resize(jq, 2 * jq->ndays);
+        }
+}
+
+/* Returns the day of the earliest job and makes it today */
+static bucket* calendar_find(jobq* const jq) {
+        if (!jq->length) {
+                return NULL;
+        }
+        for (size_t d = 0; d < jq->ndays; d++) {
+                bucket* b = jq->days + jq->today;
+                if ((b->head < b->end) && (b->e[b->head].k.pri < jq->top)) {
+                        return b;
+                }
+                jq->today = (jq->today + 1) & (jq->ndays - 1);
+                jq->top += jq->width;
+        }
+        // Nothing this year, the days are too short for the spacing of the
+        // jobs. Derive the width anew, which makes the earliest job today.
+        calendar_resize(jq, jq->ndays);
+        return jq->days + jq->today;
+}
+
+static job* calendar_pop(jobq* const jq) {
+        bucket* b = calendar_find(jq);
+        if (!b) {
+                return NULL;
+        }
+        job* j = b->e[b->head++].j;
+        if (b->head == b->end) {
+                b->head = b->end = 0;
+        }
+        jq->length--;
+        if ((jq->ndays > 2) && (jq->length < jq->ndays / 2)) {
+                calendar_resize(jq, jq->ndays / 2);
+        }
+        return j;
+}
+
+static job* calendar_peek(jobq* const jq) {
+        bucket* b = calendar_find(jq);
+        return b ? b->e[b->head].j : NULL;
+}
+
+static void calendar_free(jobq* const jq) {
+        for (size_t d = 0; d < jq->ndays; d++) {
+                bucket* b = jq->days + d;
+                for (size_t i = b->head; i < b->end; i++) {
+                        job_free(b->e[i].j);
+                }
+                free(b->e);
+        }
+        free(jq->days);
+}
+
+static int calendar_dump(jobq const* const jq, void*** dst) {
+        entry* e = calloc(jq->length, sizeof(entry));
+        int n = 0;
+        if (e) {
+                for (size_t d = 0; d < jq->ndays; d++) {
+                        bucket* b = jq->days + d;
+                        for (size_t i = b->head; i < b->end; i++) {
+                                e[n++] = b->e[i];
+                        }
+                }
+                n = dump_entries(e, n, dst);
+        }
+        free(e);
+        return n;
+}
+
+jobq* jobq_init() {
+        return jobq_init_as(JOBQ_HEAP, NULL);
+}
+
+jobq* jobq_init_as(jobq_kind const kind, ts const* const tsy) {
+        jobq* jq = calloc(1, sizeof(jobq));
+        if (!jq) {  // GCOVR_EXCL_START
+                fprintf(stderr, "error allocating memory for jobq: %s\n",
+                        strerror(errno));
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        jq->kind = kind;
+        switch (kind) {
+                case JOBQ_PERTASK:
+                        pertask_init(jq, tsy);
+                        break;
+                case JOBQ_CALENDAR:
+                        calendar_init(jq);
+                        break;
+                default:
+                        heap_init(jq);
+                        break;
+        }
+        return jq;
+}
+
+void jobq_insert_by(jobq* const jq, job* const j, JOB_INT (*func)(job* const)) {
+        key k = {func(j), jq->seq++};
+        if (++jq->count > jq->peak) {
+                jq->peak = jq->count;
+        }
+        switch (jq->kind) {
+                case JOBQ_PERTASK:
+                        pertask_insert(jq, j, k);
+                        break;
+                case JOBQ_CALENDAR:
+                        calendar_insert(jq, (entry){k, j});
+                        break;
+                default:
+                        heap_insert(jq, j, k);
+                        break;
+        }
+}
+
+void jobq_load_by(jobq* const jq,
+                  job** const jobs,
+                  size_t const n,
+                  JOB_INT (*func)(job* const)) {
+#ifndef JOBQ_PQUEUE
+        if (jq->kind == JOBQ_HEAP) {
+                heap_load(jq, jobs, n, func);
+                jq->count += n;
+                jq->peak = jq->count > jq->peak ? jq->count : jq->peak;
+                return;
+        }
+#endif
+        for (size_t i = 0; i < n; i++) {
+                jobq_insert_by(jq, jobs[i], func);
+        }
+}
+
+job* jobq_pop(jobq* const jq) {
+        job* j;
+        switch (jq->kind) {
+                case JOBQ_PERTASK:
+                        j = pertask_pop(jq);
+                        break;
+                case JOBQ_CALENDAR:
+                        j = calendar_pop(jq);
+                        break;
+                default:
+                        j = heap_pop(jq);
+                        break;
+        }
+        jq->count -= j != NULL;
+        return j;
+}
+
+job* jobq_peek(jobq* const jq) {
+        switch (jq->kind) {
+                case JOBQ_PERTASK:
+                        return pertask_peek(jq);
+                case JOBQ_CALENDAR:
+                        return calendar_peek(jq);
+                default:
+                        return heap_peek(jq);
+        }
+}
+
+void jobq_free(jobq* const jq) {
+        switch (jq->kind) {
+                case JOBQ_PERTASK:
+                        pertask_free(jq);
+                        break;
+                case JOBQ_CALENDAR:
+                        calendar_free(jq);
+                        break;
+                default:
+                        heap_free(jq);
+                        break;
+        }
+        free(jq);
+}
+
+size_t jobq_length(jobq const* const jq) {
+        return jq->count;
+}
+
+size_t jobq_peak(jobq const* const jq) {
+        return jq->peak;
+}
+
+int jobq_dump(jobq const* const jq, void*** dst) {
+        switch (jq->kind) {
+                case JOBQ_PERTASK:
+                        return pertask_dump(jq, dst);
+                case JOBQ_CALENDAR:
+                        return calendar_dump(jq, dst);
+                default:
+                        return heap_dump(jq, dst);
+        }
+}
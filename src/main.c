@@ -15,14 +15,19 @@ this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
  */
 
 #include <assert.h>
+#include <inttypes.h>
 #include <signal.h>  // TODO: switch to sigaction for portability
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include "eventloop.h"
 #include "job.h"
 #include "parg.h"
+#include "replicate.h"
+#include "serve.h"
+#include "trace.h"
 
 #define STATE_PREFIXBUFLEN 128
 #define FILENAMEMAXLEN 255
@@ -35,35 +40,139 @@ struct state {
         eventloop* evl;
         FILE* tasksystem;
         FILE* resume;
+        FILE* record;  // job trace output
+        FILE* replay;  // job trace input
+        FILE* csv;     // measured job trace input
+        trace_writer* tw;
+        trace* tr;
+        trace_csv* tc;
         int randomseed_jobtrace;
+        bool seedrange;  // replicate seeds seedfirst to seedlast
+        uint32_t seedfirst;
+        uint32_t seedlast;
+        int threads;
+        bool serve;          // answer requests instead of a single simulation
+        char const* socket;  // of the server, stdin and stdout if NULL
         char prefix[STATE_PREFIXBUFLEN];
         JOB_INT breaktime;
         JOB_INT speed;
         bool overrunbreak;
         bool allow_first_overrun;
+        jobq_kind readyq;
+        jobgen_queue arrivalq;
+        jobgen_rng rng;
+        bool json;  // dump format
 };
 
 static struct state* state_reference;
 
-static void catch_signals(__attribute__((unused)) int signo) {
+static void write_dump(struct state const* const s, char const* suffix) {
         char fname[FILENAMEMAXLEN] = {0};
-        strncpy(fname, state_reference->prefix, STATE_PREFIXBUFLEN);
-        strcat(fname, "_signal_dump.json");
-        FILE* stream = fopen(fname, "w");
+        strncpy(fname, s->prefix, STATE_PREFIXBUFLEN);
+        strcat(fname, suffix);
+        strcat(fname, s->json ? ".json" : ".bin");
+        FILE* stream = fopen(fname, s->json ? "w" : "wb");
         if (stream) {
-                eventloop_dump(state_reference->evl, stream);
+                if (s->json) {
+                        eventloop_dump(s->evl, stream);
+                } else {
+                        eventloop_dump_bin(s->evl, stream);
+                }
                 fclose(stream);
         } else {
                 fprintf(stderr, "state dump io error\n");
                 exit(EXIT_FAILURE);
         }
+}
+
+/* Attach job trace recording and replay to the job generator */
+static void attach_traces(struct state* s) {
+        if (s->replay) {
+                s->tr = trace_init(s->replay, s->tsy);
+                fclose(s->replay);
+                s->replay = NULL;
+                jobgen_replay(s->jg, s->tr);
+        }
+        if (s->csv) {
+                s->tc = trace_csv_init(s->csv, s->tsy);
+                jobgen_replay_csv(s->jg, s->tc);
+        }
+        if (s->record) {
+                s->tw = trace_writer_init(s->record, s->tsy,
+                                          jobgen_get_released(s->jg));
+                jobgen_record(s->jg, s->tw);
+        }
+}
+
+static void print_outcome(replicate_outcome const* o,
+                          __attribute__((unused)) void* arg) {
+        static char const* const results[] = {"ok", "deadlinemiss", "pass",
+                                              "overrun"};
+        printf("%" PRIu32 ",%s,%" PRId64 ",%" PRId64 ",%" PRId64 "\n", o->seed,
+               results[o->result], (int64_t)o->now, (int64_t)o->events,
+               (int64_t)o->jobsdone);
+        fflush(stdout);
+}
+
+/* Simulate the seed range on a thread pool and report in order of seeds */
+static void replicate(struct state* s) {
+        if (s->resume || s->record || s->replay || s->csv) {
+                fprintf(stderr,
+                        "seed ranges do not resume, record, or replay\n");
+                exit(EXIT_FAILURE);
+        }
+        replicate_config c;
+        c.tsy = s->tsy;
+        c.breaktime = s->breaktime;
+        c.speed = s->speed;
+        c.overrunbreak = s->overrunbreak;
+        c.allow_first_overrun = s->allow_first_overrun;
+        c.readyq = s->readyq;
+        c.arrivalq = s->arrivalq;
+        c.rng = s->rng;
+        printf("seed,result,now,events,jobsdone\n");
+        replicate_run(&c, s->seedfirst, s->seedlast, s->threads, print_outcome,
+                      NULL);
+}
+
+/* Answer simulation requests until the end of input */
+static void serve(struct state* s) {
+        thready_options o;
+        o.readyq = (thready_readyq)s->readyq;
+        o.arrivalq = (thready_arrivalq)s->arrivalq;
+        o.rng = (thready_rng)s->rng;
+        o.threads = s->threads;
+        if (s->socket) {
+                serve_socket(s->socket, &o);
+        } else {
+                serve_stream(stdin, STDOUT_FILENO, &o);
+        }
+        ts_free(s->tsy);
+        free(s);
+        exit(EXIT_SUCCESS);
+}
+
+static void catch_signals(__attribute__((unused)) int signo) {
+        write_dump(state_reference, "_signal_dump");
         exit(EXIT_SUCCESS);
 }
 
 static void atexit_cleanup(void) {
         eventloop_free(state_reference->evl);
         jobgen_free(state_reference->jg);
+        if (state_reference->tw) {
+                trace_writer_free(state_reference->tw);
+                fclose(state_reference->record);
+        }
+        if (state_reference->tr) {
+                trace_free(state_reference->tr);
+        }
+        if (state_reference->tc) {
+                trace_csv_free(state_reference->tc);
+                fclose(state_reference->csv);
+        }
         ts_free(state_reference->tsy);
+        job_pool_free();
         // free(state_reference->p);
         free(state_reference);
         state_reference = (void*)0;
@@ -82,17 +191,26 @@ int main(int argc, char* argv[]) {
         s->speed = 1;
         s->overrunbreak = false;
         s->allow_first_overrun = false;
+        s->readyq = JOBQ_HEAP;
+        s->arrivalq = JOBGEN_ARRAY;
+        s->rng = JOBGEN_RNG_SHARED;
+        s->json = false;
+        s->threads = replicate_threads();
 
         int prefixlen = 0;
 
         s->tsy = ts_init();
 
         struct parg_state ps;
+        struct parg_option const longopts[] = {
+            {"serve", PARG_OPTARG, NULL, 'S'}, {NULL, 0, NULL, 0}};
         int c;
         parg_init(&ps);
         // abcdefghijklmnopqrstuvwxyz ABCDEFGHIJKLMNOPQRSTUVWXYZ
-        //  x     x x   x   x x xx  x
-        while ((c = parg_getopt(&ps, argc, argv, "abhz:t:vj:r:n:w:")) != -1) {
+        // xxx  xxx x  xxxxxxxx xx  x                   x
+        while ((c = parg_getopt_long(&ps, argc, argv,
+                                     "abhz:t:vj:r:n:w:q:g:s:f:o:p:c:m:",
+                                     longopts, NULL)) != -1) {
                 switch (c) {
                         case 1:
                                 printf("nonoption '%s'\n", ps.optarg);
@@ -100,13 +218,26 @@ int main(int argc, char* argv[]) {
                         case 'h':
                                 printf(
                                     "Usage: thready [-h] [-v] "
-                                    "[-r <statedump.json>] "
-                                    "[-z jobtracerandomseed] "
+                                    "[-r <statedump.bin|statedump.json>] "
+                                    "[-z jobtracerandomseed|first:last] "
+                                    "[-m threads] "
                                     "[-b] [-a] "
                                     "-n dumpprefix "
                                     "-t breaktime "
                                     "-w work/timestep "
-                                    "-j <tasksystemfile.json>\n");
+                                    "[-q heap|pertask|calendar] "
+                                    "[-g array|heap|calendar] "
+                                    "[-s shared|batch|counter] "
+                                    "[-f bin|json] "
+                                    "[-o recordedtrace.bin] "
+                                    "[-p replayedtrace.bin] "
+                                    "[-c measuredtrace.csv] "
+                                    "-j <tasksystemfile.json>\n"
+                                    "       thready --serve[=socket] "
+                                    "[-m threads] "
+                                    "[-q heap|pertask|calendar] "
+                                    "[-g array|heap|calendar] "
+                                    "[-s shared|batch|counter]\n");
                                 exit(EXIT_SUCCESS);
                                 break;
                         case 'v':
@@ -117,9 +248,35 @@ int main(int argc, char* argv[]) {
                         case 'j':  // reading task system from JSON
                                 s->tasksystem = fopen(ps.optarg, "r");
                                 break;
-                        case 'r':  // resume from JSON state dump
+                        case 'r':  // resume from checkpoint or JSON state dump
                                 s->resume = fopen(ps.optarg, "r");
                                 break;
+                        case 'o':  // record job trace
+                                s->record = fopen(ps.optarg, "wb");
+                                if (!s->record) {
+                                        fprintf(stderr,
+                                                "job trace io error\n");
+                                        exit(EXIT_FAILURE);
+                                }
+                                break;
+                        case 'p':  // replay job trace
+                                s->replay = fopen(ps.optarg, "rb");
+                                if (!s->replay) {
+                                        fprintf(stderr,
+                                                "job trace io error\n");
+                                        exit(EXIT_FAILURE);
+                                }
+                                break;
+                        case 'c':  // replay measured job trace
+                                s->csv = strcmp(ps.optarg, "-")
+                                             ? fopen(ps.optarg, "r")
+                                             : stdin;
+                                if (!s->csv) {
+                                        fprintf(stderr,
+                                                "job trace io error\n");
+                                        exit(EXIT_FAILURE);
+                                }
+                                break;
                         case 'n':
                                 prefixlen = strlen(ps.optarg);
                                 if (prefixlen <= STATE_PREFIXBUFLEN - 1) {
@@ -139,8 +296,33 @@ int main(int argc, char* argv[]) {
                         case 'a':
                                 s->allow_first_overrun = true;
                                 break;
-                        case 'z':
-                                s->randomseed_jobtrace = atoi(ps.optarg);
+                        case 'z':  // seed or range of seeds first:last
+                                if (strchr(ps.optarg, ':')) {
+                                        char* end;
+                                        s->seedrange = true;
+                                        s->seedfirst =
+                                            strtoul(ps.optarg, &end, 10);
+                                        s->seedlast =
+                                            strtoul(end + 1, &end, 10);
+                                        if (*end ||
+                                            s->seedlast < s->seedfirst) {
+                                                fprintf(stderr,
+                                                        "invalid seed range "
+                                                        "'%s'\n",
+                                                        ps.optarg);
+                                                exit(EXIT_FAILURE);
+                                        }
+                                } else {
+                                        s->randomseed_jobtrace =
+                                            atoi(ps.optarg);
+                                }
+                                break;
+                        case 'S':  // resident server on stdin or a socket
+                                s->serve = true;
+                                s->socket = ps.optarg;
+                                break;
+                        case 'm':  // threads simulating a seed range
+                                s->threads = atoi(ps.optarg);
                                 break;
                         case 't':
                                 s->breaktime = atoll(ps.optarg);
@@ -148,10 +330,68 @@ int main(int argc, char* argv[]) {
                         case 'w':  // Processor speed; work done per timestep
                                 s->speed = atoll(ps.optarg);
                                 break;
+                        case 'q':  // Data structure of scheduler queue
+                                if (!strcmp(ps.optarg, "heap")) {
+                                        s->readyq = JOBQ_HEAP;
+                                } else if (!strcmp(ps.optarg, "pertask")) {
+                                        s->readyq = JOBQ_PERTASK;
+                                } else if (!strcmp(ps.optarg, "calendar")) {
+                                        s->readyq = JOBQ_CALENDAR;
+                                } else {
+                                        fprintf(stderr,
+                                                "unknown queue '%s'\n",
+                                                ps.optarg);
+                                        exit(EXIT_FAILURE);
+                                }
+                                break;
+                        case 'g':  // Data structure of job generator queue
+                                if (!strcmp(ps.optarg, "array")) {
+                                        s->arrivalq = JOBGEN_ARRAY;
+                                } else if (!strcmp(ps.optarg, "heap")) {
+                                        s->arrivalq = JOBGEN_HEAP;
+                                } else if (!strcmp(ps.optarg, "calendar")) {
+                                        s->arrivalq = JOBGEN_CALENDAR;
+                                } else {
+                                        fprintf(stderr,
+                                                "unknown queue '%s'\n",
+                                                ps.optarg);
+                                        exit(EXIT_FAILURE);
+                                }
+                                break;
+                        case 's':  // Random streams of job generator
+                                if (!strcmp(ps.optarg, "shared")) {
+                                        s->rng = JOBGEN_RNG_SHARED;
+                                } else if (!strcmp(ps.optarg, "batch")) {
+                                        s->rng = JOBGEN_RNG_BATCH;
+                                } else if (!strcmp(ps.optarg, "counter")) {
+                                        s->rng = JOBGEN_RNG_COUNTER;
+                                } else {
+                                        fprintf(stderr,
+                                                "unknown random stream '%s'\n",
+                                                ps.optarg);
+                                        exit(EXIT_FAILURE);
+                                }
+                                break;
+                        case 'f':  // Format of state dump
+                                if (!strcmp(ps.optarg, "bin")) {
+                                        s->json = false;
+                                } else if (!strcmp(ps.optarg, "json")) {
+                                        s->json = true;
+                                } else {
+                                        fprintf(stderr,
+                                                "unknown dump format '%s'\n",
+                                                ps.optarg);
+                                        exit(EXIT_FAILURE);
+                                }
+                                break;
                         case '?':
                                 if ((ps.optopt == 't') || (ps.optopt == 'j') ||
                                     (ps.optopt == 'z') || (ps.optopt == 'r') ||
-                                    (ps.optopt == 'n') || (ps.optopt == 'w')) {
+                                    (ps.optopt == 'n') || (ps.optopt == 'w') ||
+                                    (ps.optopt == 'q') || (ps.optopt == 'g') ||
+                                    (ps.optopt == 's') || (ps.optopt == 'f') ||
+                                    (ps.optopt == 'o') || (ps.optopt == 'p') ||
+                                    (ps.optopt == 'c') || (ps.optopt == 'm')) {
                                         printf(
                                             "option -%c requires an argument\n",
                                             ps.optopt);
@@ -168,7 +408,10 @@ int main(int argc, char* argv[]) {
                 }
         }
 
-        if (!prefixlen) {
+        if (s->serve) {
+                serve(s);
+        }
+        if (!prefixlen && !s->seedrange) {
                 fprintf(stderr, "no dump prefix specified\n");
                 exit(EXIT_FAILURE);
         }
@@ -181,20 +424,31 @@ int main(int argc, char* argv[]) {
                 fprintf(stderr, "no tasksystem json file specified\n");
                 exit(EXIT_FAILURE);
         }
-        if (s->resume) {
+        if (s->seedrange) {
+                replicate(s);
+                ts_free(s->tsy);
+                free(s);
+                exit(EXIT_SUCCESS);
+        }
+        if (s->resume || s->replay || s->csv) {
                 // Do not refill jobgenerator with jobs starting at zero if
-                // we resume from a state dump.
-                // The random generator state is not restored from the state
-                // dump!
-                s->jg = jobgen_init(s->tsy, s->randomseed_jobtrace, false);
+                // we resume from a state dump, which restores the random
+                // generator state as well, or replay a job trace.
+                s->jg = jobgen_init(s->tsy, s->randomseed_jobtrace, false,
+                                    s->arrivalq, s->rng);
         } else {
-                s->jg = jobgen_init(s->tsy, s->randomseed_jobtrace, true);
+                s->jg = jobgen_init(s->tsy, s->randomseed_jobtrace, true,
+                                    s->arrivalq, s->rng);
         }
         if (s->resume) {
-                s->evl = eventloop_init(s->jg, false, s->allow_first_overrun);
-                eventloop_read_json(s->evl, s->resume);
+                s->evl = eventloop_init(s->jg, false, s->allow_first_overrun,
+                                        s->readyq);
+                eventloop_read(s->evl, s->resume);
+                attach_traces(s);
         } else {
-                s->evl = eventloop_init(s->jg, true, s->allow_first_overrun);
+                attach_traces(s);
+                s->evl = eventloop_init(s->jg, true, s->allow_first_overrun,
+                                        s->readyq);
         }
 
         // Install handlers to free memory on exit and to state dump on signals
@@ -219,17 +473,7 @@ int main(int argc, char* argv[]) {
             eventloop_run(s->evl, s->breaktime, s->speed, s->overrunbreak);
 
         // Dump results
-        char fname[FILENAMEMAXLEN] = {0};
-        strncpy(fname, s->prefix, STATE_PREFIXBUFLEN);
-        strcat(fname, "_dump.json");
-        FILE* stream = fopen(fname, "w");
-        if (stream) {
-                eventloop_dump(s->evl, stream);
-                fclose(stream);
-        } else {
-                fprintf(stderr, "state dump io error\n");
-                exit(EXIT_FAILURE);
-        }
+        write_dump(s, "_dump");
 
         eventloop_print_result(s->evl, r);
         exit(EXIT_SUCCESS);
@@ -0,0 +1,136 @@
+/*
+thready - A lightweight and fast scheduling simulator
+Written in 2019 by Robert Schmidt <rschmidt@uni-bremen.de>
+To the extent possible under law, the author(s) have dedicated all copyright and
+related and neighboring rights to this software to the public domain worldwide.
+This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with
+this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+#include "out.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define OUT_INTLEN 20  // digits and sign of the longest int64_t
+
+struct out {
+        FILE* stream;
+        size_t len;
+        char buf[OUT_BUFLEN];
+};
+
+static char const digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+out* out_init(FILE* stream) {
+        out* o = malloc(sizeof(out));
+        if (!o) {  // GCOVR_EXCL_START
+                fprintf(stderr, "error allocating memory for output: %s\n",
+                        strerror(errno));
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        o->stream = stream;
+        o->len = 0;
+        return o;
+}
+
+void out_flush(out* o) {
+        if (o->len && fwrite(o->buf, o->len, 1, o->stream) != 1) {
+                // GCOVR_EXCL_START
+                fprintf(stderr, "output io error\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        o->len = 0;
+}
+
+void out_free(out* o) {
+        out_flush(o);
+        free(o);
+}
+
+static inline void reserve(out* o, size_t const n) {
+        if (o->len + n > OUT_BUFLEN) {
+                out_flush(o);
+        }
+}
+
+void out_char(out* o, char const c) {
+        reserve(o, 1);
+        o->buf[o->len++] = c;
+}
+
+void out_mem(out* o, void const* p, size_t const n) {
+        if (n > OUT_BUFLEN) {
+                out_flush(o);
+                if (fwrite(p, n, 1, o->stream) != 1) {  // GCOVR_EXCL_START
+                        fprintf(stderr, "output io error\n");
+                        exit(EXIT_FAILURE);
+                }  // GCOVR_EXCL_STOP
+                return;
+        }
+        reserve(o, n);
+        memcpy(o->buf + o->len, p, n);
+        o->len += n;
+}
+
+void out_str(out* o, char const* s) {
+        out_mem(o, s, strlen(s));
+}
+
+void out_int(out* o, int64_t const v) {
+        reserve(o, OUT_INTLEN);
+        char tmp[OUT_INTLEN];
+        char* p = tmp + OUT_INTLEN;
+        uint64_t u = v < 0 ? -(uint64_t)v : (uint64_t)v;
+        while (u >= 100) {
+                char const* d = digit_pairs + 2 * (u % 100);
+                u /= 100;
+                *--p = d[1];
+                *--p = d[0];
+        }
+        if (u >= 10) {
+                *--p = digit_pairs[2 * u + 1];
+                *--p = digit_pairs[2 * u];
+        } else {
+                *--p = '0' + (char)u;
+        }
+        if (v < 0) {
+                *--p = '-';
+        }
+        size_t n = tmp + OUT_INTLEN - p;
+        memcpy(o->buf + o->len, p, n);
+        o->len += n;
+}
+
+static void job_fields(out* o, job* const j) {
+        out_int(o, job_get_taskid(j));
+        out_char(o, ',');
+        out_int(o, job_get_starttime(j));
+        out_char(o, ',');
+        out_int(o, job_get_overruntime(j));
+        out_char(o, ',');
+        out_int(o, job_get_deadline(j));
+        out_char(o, ',');
+        out_int(o, job_get_computation(j));
+}
+
+void out_job_json(out* o, job* const j) {
+        out_char(o, '[');
+        job_fields(o, j);
+        out_char(o, ']');
+}
+
+void out_job_csv(out* o, job* const j) {
+        job_fields(o, j);
+        out_char(o, '\n');
+}
@@ -0,0 +1,123 @@
+/*
+thready - A lightweight and fast scheduling simulator
+Written in 2019 by Robert Schmidt <rschmidt@uni-bremen.de>
+To the extent possible under law, the author(s) have dedicated all copyright and
+related and neighboring rights to this software to the public domain worldwide.
+This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with
+this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+#define _POSIX_C_SOURCE 200112L  // pthread
+#include "replicate.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "job.h"
+
+/* Work shared by the threads, guarded by lock */
+typedef struct {
+        replicate_config const* c;
+        uint32_t first;
+        uint64_t n;
+        uint64_t next;      // index of the next seed to simulate
+        uint64_t reported;  // outcomes passed to report
+        replicate_outcome* outcomes;
+        bool* done;
+        replicate_report report;
+        void* arg;
+        pthread_mutex_t lock;
+} pool;
+
+replicate_outcome replicate_seed(replicate_config const* const c,
+                                 uint32_t const seed) {
+        jobgen* jg = jobgen_init(c->tsy, seed, true, c->arrivalq, c->rng);
+        eventloop* evl =
+            eventloop_init(jg, true, c->allow_first_overrun, c->readyq);
+        // Notices of concurrent runs would interleave with the outcomes
+        eventloop_set_quiet(evl, true);
+        replicate_outcome o;
+        o.seed = seed;
+        o.result = eventloop_run(evl, c->breaktime, c->speed, c->overrunbreak);
+        o.now = eventloop_get_now(evl);
+        o.events = eventloop_get_events(evl);
+        o.jobsdone = eventloop_get_jobsdone(evl);
+        eventloop_free(evl);
+        jobgen_free(jg);
+        return o;
+}
+
+static void* worker(void* arg) {
+        pool* p = arg;
+        for (;;) {
+                pthread_mutex_lock(&p->lock);
+                uint64_t i = p->next++;
+                pthread_mutex_unlock(&p->lock);
+                if (i >= p->n) {
+                        break;
+                }
+                replicate_outcome o = replicate_seed(p->c, p->first + i);
+
+                pthread_mutex_lock(&p->lock);
+                p->outcomes[i] = o;
+                p->done[i] = true;
+                // Report every outcome whose lower seeds are reported
+                while (p->reported < p->n && p->done[p->reported]) {
+                        p->report(p->outcomes + p->reported, p->arg);
+                        p->reported++;
+                }
+                pthread_mutex_unlock(&p->lock);
+        }
+        job_pool_free();
+        return NULL;
+}
+
+void replicate_run(replicate_config const* const c,
+                   uint32_t const first,
+                   uint32_t const last,
+                   int threads,
+                   replicate_report report,
+                   void* arg) {
+        if (last < first) {
+                return;
+        }
+        pool p = {0};
+        p.c = c;
+        p.first = first;
+        p.n = (uint64_t)last - first + 1;
+        p.report = report;
+        p.arg = arg;
+        p.outcomes = calloc(p.n, sizeof(replicate_outcome));
+        p.done = calloc(p.n, sizeof(bool));
+        if (threads < 1) {
+                threads = 1;
+        }
+        if ((uint64_t)threads > p.n) {
+                threads = p.n;
+        }
+        pthread_t* tids = calloc(threads, sizeof(pthread_t));
+        if (!p.outcomes || !p.done || !tids) {  // GCOVR_EXCL_START
+                fprintf(stderr, "error allocating memory for replications\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        pthread_mutex_init(&p.lock, NULL);
+        for (int t = 0; t < threads; t++) {
+                if (pthread_create(tids + t, NULL, worker, &p)) {
+                        // GCOVR_EXCL_START
+                        fprintf(stderr, "error starting replication thread\n");
+                        exit(EXIT_FAILURE);
+                }  // GCOVR_EXCL_STOP
+        }
+        for (int t = 0; t < threads; t++) {
+                pthread_join(tids[t], NULL);
+        }
+        pthread_mutex_destroy(&p.lock);
+        free(tids);
+        free(p.outcomes);
+        free(p.done);
+}
+
+int replicate_threads(void) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        return n > 0 ? (int)n : 1;
+}
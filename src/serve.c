@@ -0,0 +1,430 @@
+/*
+thready - A lightweight and fast scheduling simulator
+Written in 2019 by Robert Schmidt <rschmidt@uni-bremen.de>
+To the extent possible under law, the author(s) have dedicated all copyright and
+related and neighboring rights to this software to the public domain worldwide.
+This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with
+this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+#define _POSIX_C_SOURCE 200809L  // getline, pthread
+#include "serve.h"
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define SERVE_ANSWERLEN 256
+
+/* Connection, freed with its last reference held by its reader or a queued
+ * run */
+typedef struct {
+        FILE* in;
+        int out;
+        bool own;  // close in and out with the connection
+        int refs;
+        pthread_mutex_t lock;  // guards refs and serializes answers
+} conn;
+
+typedef struct item {
+        struct item* next;
+        conn* c;
+        thready_tasksystem const* tsy;
+        uint64_t id;
+        thready_run run;
+} item;
+
+typedef struct {
+        uint64_t id;
+        thready_tasksystem* tsy;  // NULL if the slot is empty
+} entry;
+
+typedef struct {
+        thready_options o;  // of a single run
+        pthread_t* tids;
+        int threads;
+        pthread_mutex_t lock;  // guards queue and cache
+        pthread_cond_t work;
+        pthread_cond_t room;
+        item* head;
+        item* tail;
+        size_t queued;
+        bool closed;
+        entry* cache;  // open addressing by id
+        size_t cachemask;
+        size_t cached;
+} server;
+
+typedef struct {
+        server* srv;
+        conn* c;
+} reader_arg;
+
+static char const* const results[] = {"ok", "deadlinemiss", "pass",
+                                      "overrun"};
+
+/* FNV-1a, 64 bit */
+static uint64_t hash_text(char const* const text, size_t const len) {
+        uint64_t h = UINT64_C(0xcbf29ce484222325);
+        for (size_t i = 0; i < len; i++) {
+                h = (h ^ (unsigned char)text[i]) * UINT64_C(0x100000001b3);
+        }
+        return h;
+}
+
+static conn* conn_init(FILE* in, int out, bool own) {
+        conn* c = calloc(1, sizeof(conn));
+        if (!c) {  // GCOVR_EXCL_START
+                fprintf(stderr, "error allocating memory for connection\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        c->in = in;
+        c->out = out;
+        c->own = own;
+        c->refs = 1;
+        pthread_mutex_init(&c->lock, NULL);
+        return c;
+}
+
+static void conn_release(conn* c) {
+        pthread_mutex_lock(&c->lock);
+        bool last = !--c->refs;
+        pthread_mutex_unlock(&c->lock);
+        if (last) {
+                if (c->own) {
+                        fclose(c->in);  // closes out as well
+                }
+                pthread_mutex_destroy(&c->lock);
+                free(c);
+        }
+}
+
+/* Answers of a vanished client are dropped */
+static void answer(conn* c, char const* text, size_t len) {
+        pthread_mutex_lock(&c->lock);
+        while (len) {
+                ssize_t n = write(c->out, text, len);
+                if (n < 0 && errno == EINTR) {
+                        continue;
+                }
+                if (n <= 0) {
+                        break;
+                }
+                text += n;
+                len -= n;
+        }
+        pthread_mutex_unlock(&c->lock);
+}
+
+static void answer_str(conn* c, char const* text) {
+        answer(c, text, strlen(text));
+}
+
+static thready_tasksystem const* cache_get(server const* srv, uint64_t id) {
+        if (!srv->cache) {
+                return NULL;
+        }
+        for (size_t i = id & srv->cachemask;; i = (i + 1) & srv->cachemask) {
+                if (!srv->cache[i].tsy || srv->cache[i].id == id) {
+                        return srv->cache[i].tsy;
+                }
+        }
+}
+
+static void cache_put(server* srv, uint64_t id, thready_tasksystem* tsy) {
+        if (2 * (srv->cached + 1) > srv->cachemask + 1 || !srv->cache) {
+                size_t size = srv->cache ? 2 * (srv->cachemask + 1) : 64;
+                entry* old = srv->cache;
+                size_t oldsize = old ? srv->cachemask + 1 : 0;
+                srv->cache = calloc(size, sizeof(entry));
+                if (!srv->cache) {  // GCOVR_EXCL_START
+                        fprintf(stderr, "error allocating memory for cache\n");
+                        exit(EXIT_FAILURE);
+                }  // GCOVR_EXCL_STOP
+                srv->cachemask = size - 1;
+                srv->cached = 0;
+                for (size_t i = 0; i < oldsize; i++) {
+                        if (old[i].tsy) {
+                                cache_put(srv, old[i].id, old[i].tsy);
+                        }
+                }
+                free(old);
+        }
+        size_t i = id & srv->cachemask;
+        while (srv->cache[i].tsy) {
+                i = (i + 1) & srv->cachemask;
+        }
+        srv->cache[i].id = id;
+        srv->cache[i].tsy = tsy;
+        srv->cached++;
+}
+
+static void* worker(void* arg) {
+        server* srv = arg;
+        char text[SERVE_ANSWERLEN];
+        for (;;) {
+                pthread_mutex_lock(&srv->lock);
+                while (!srv->head && !srv->closed) {
+                        pthread_cond_wait(&srv->work, &srv->lock);
+                }
+                item* it = srv->head;
+                if (it) {
+                        srv->head = it->next;
+                        srv->tail = srv->head ? srv->tail : NULL;
+                        srv->queued--;
+                        pthread_cond_signal(&srv->room);
+                }
+                pthread_mutex_unlock(&srv->lock);
+                if (!it) {
+                        break;
+                }
+
+                thready_run const* r = &it->run;
+                char const* flags = r->overrun == THREADY_OVERRUN_FIRST
+                                        ? "ba"
+                                        : r->overrun ? "b" : "-";
+                int len = snprintf(text, sizeof(text),
+                                   "run %016" PRIx64 " %" PRIu32 " %" PRId64
+                                   " %" PRId64 " %s ",
+                                   it->id, r->seed, r->breaktime, r->speed,
+                                   flags);
+                thready_outcome o;
+                thready_status s = thready_simulate(it->tsy, r, 1, &srv->o, &o);
+                if (s == THREADY_OK) {
+                        len += snprintf(text + len, sizeof(text) - len,
+                                        "%s %" PRId64 " %" PRId64 " %" PRId64
+                                        "\n",
+                                        results[o.result], o.now, o.events,
+                                        o.jobsdone);
+                } else {
+                        len += snprintf(text + len, sizeof(text) - len,
+                                        "error %s\n", thready_strerror(s));
+                }
+                answer(it->c, text, len);
+                conn_release(it->c);
+                free(it);
+        }
+        thready_thread_free();
+        return NULL;
+}
+
+static void request_ts(server* srv, conn* c, char const* json, size_t len) {
+        char text[SERVE_ANSWERLEN];
+        uint64_t id = hash_text(json, len);
+        pthread_mutex_lock(&srv->lock);
+        bool cached = cache_get(srv, id);
+        pthread_mutex_unlock(&srv->lock);
+        if (!cached) {
+                thready_tasksystem* tsy;
+                thready_status s = thready_tasksystem_parse(&tsy, json, len);
+                if (s != THREADY_OK) {
+                        int n = snprintf(text, sizeof(text), "ts error %s\n",
+                                         thready_strerror(s));
+                        answer(c, text, n);
+                        return;
+                }
+                // Another connection may have sent the same task system
+                pthread_mutex_lock(&srv->lock);
+                if (cache_get(srv, id)) {
+                        thready_tasksystem_free(tsy);
+                } else {
+                        cache_put(srv, id, tsy);
+                }
+                pthread_mutex_unlock(&srv->lock);
+        }
+        int n = snprintf(text, sizeof(text), "ts %016" PRIx64 "\n", id);
+        answer(c, text, n);
+}
+
+static void request_run(server* srv, conn* c, char const* args) {
+        item* it = calloc(1, sizeof(item));
+        if (!it) {  // GCOVR_EXCL_START
+                fprintf(stderr, "error allocating memory for request\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        thready_run* r = &it->run;
+        int end = 0;
+        bool ok = sscanf(args,
+                         "%" SCNx64 " %" SCNu32 " %" SCNd64 " %" SCNd64 "%n",
+                         &it->id, &r->seed, &r->breaktime, &r->speed,
+                         &end) == 4;
+        // Flags b and a of thready, or - for none
+        bool b = false;
+        bool a = false;
+        for (char const* f = args + end; ok && *f; f++) {
+                b = b || *f == 'b';
+                a = a || *f == 'a';
+                ok = strchr(" ab-", *f);
+        }
+        r->overrun = b ? (a ? THREADY_OVERRUN_FIRST : THREADY_OVERRUN_BREAK)
+                       : THREADY_OVERRUN_NONE;
+        if (!ok) {
+                free(it);
+                answer_str(c, "run error malformed request\n");
+                return;
+        }
+        pthread_mutex_lock(&srv->lock);
+        it->tsy = cache_get(srv, it->id);
+        pthread_mutex_unlock(&srv->lock);
+        if (!it->tsy) {
+                free(it);
+                answer_str(c, "run error unknown task system\n");
+                return;
+        }
+
+        it->c = c;
+        pthread_mutex_lock(&c->lock);
+        c->refs++;
+        pthread_mutex_unlock(&c->lock);
+        pthread_mutex_lock(&srv->lock);
+        while (srv->queued >= SERVE_QUEUELEN) {
+                pthread_cond_wait(&srv->room, &srv->lock);
+        }
+        if (srv->tail) {
+                srv->tail->next = it;
+        } else {
+                srv->head = it;
+        }
+        srv->tail = it;
+        srv->queued++;
+        pthread_cond_signal(&srv->work);
+        pthread_mutex_unlock(&srv->lock);
+}
+
+/* Answer the requests of a connection up to its end of input */
+static void read_requests(server* srv, conn* c) {
+        char* line = NULL;
+        size_t cap = 0;
+        ssize_t len;
+        while ((len = getline(&line, &cap, c->in)) >= 0) {
+                while (len && strchr("\r\n", line[len - 1])) {
+                        line[--len] = '\0';
+                }
+                if (!len) {
+                        continue;
+                }
+                if (!strncmp(line, "ts ", 3)) {
+                        request_ts(srv, c, line + 3, len - 3);
+                } else if (!strncmp(line, "run ", 4)) {
+                        request_run(srv, c, line + 4);
+                } else {
+                        answer_str(c, "error unknown request\n");
+                }
+        }
+        free(line);
+        conn_release(c);
+}
+
+static void server_init(server* srv, thready_options const* const o) {
+        memset(srv, 0, sizeof(server));
+        srv->o = *o;
+        srv->o.threads = 1;  // runs are distributed by the server
+        srv->threads = o->threads > 1 ? o->threads : 1;
+        srv->tids = calloc(srv->threads, sizeof(pthread_t));
+        if (!srv->tids) {  // GCOVR_EXCL_START
+                fprintf(stderr, "error allocating memory for server\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        pthread_mutex_init(&srv->lock, NULL);
+        pthread_cond_init(&srv->work, NULL);
+        pthread_cond_init(&srv->room, NULL);
+        for (int t = 0; t < srv->threads; t++) {
+                if (pthread_create(srv->tids + t, NULL, worker, srv)) {
+                        // GCOVR_EXCL_START
+                        fprintf(stderr, "error starting server thread\n");
+                        exit(EXIT_FAILURE);
+                }  // GCOVR_EXCL_STOP
+        }
+}
+
+/* Answer the queued runs and stop the workers */
+static void server_free(server* srv) {
+        pthread_mutex_lock(&srv->lock);
+        srv->closed = true;
+        pthread_cond_broadcast(&srv->work);
+        pthread_mutex_unlock(&srv->lock);
+        for (int t = 0; t < srv->threads; t++) {
+                pthread_join(srv->tids[t], NULL);
+        }
+        for (size_t i = 0; srv->cache && i <= srv->cachemask; i++) {
+                thready_tasksystem_free(srv->cache[i].tsy);
+        }
+        free(srv->cache);
+        free(srv->tids);
+        pthread_cond_destroy(&srv->room);
+        pthread_cond_destroy(&srv->work);
+        pthread_mutex_destroy(&srv->lock);
+}
+
+void serve_stream(FILE* in, int out, thready_options const* const o) {
+        server srv;
+        server_init(&srv, o);
+        read_requests(&srv, conn_init(in, out, false));
+        server_free(&srv);
+}
+
+static void* reader(void* arg) {
+        reader_arg r = *(reader_arg*)arg;
+        free(arg);
+        read_requests(r.srv, r.c);
+        return NULL;
+}
+
+// GCOVR_EXCL_START
+void serve_socket(char const* path, thready_options const* const o) {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (strlen(path) >= sizeof(addr.sun_path)) {
+                fprintf(stderr, "socket path too long\n");
+                exit(EXIT_FAILURE);
+        }
+        strcpy(addr.sun_path, path);
+        struct stat st;
+        if (!stat(path, &st) && S_ISSOCK(st.st_mode)) {
+                unlink(path);
+        }
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || bind(fd, (struct sockaddr*)&addr, sizeof(addr)) ||
+            listen(fd, SOMAXCONN)) {
+                fprintf(stderr, "socket error: %s\n", strerror(errno));
+                exit(EXIT_FAILURE);
+        }
+        // Answers to vanished clients fail instead of ending the server
+        signal(SIGPIPE, SIG_IGN);
+
+        server srv;
+        server_init(&srv, o);
+        for (;;) {
+                int client = accept(fd, NULL, NULL);
+                if (client < 0) {
+                        if (errno == EINTR || errno == ECONNABORTED) {
+                                continue;
+                        }
+                        fprintf(stderr, "socket error: %s\n", strerror(errno));
+                        exit(EXIT_FAILURE);
+                }
+                FILE* in = fdopen(client, "r");
+                reader_arg* r = malloc(sizeof(reader_arg));
+                pthread_t tid;
+                if (!in || !r) {
+                        fprintf(stderr, "error allocating memory for client\n");
+                        exit(EXIT_FAILURE);
+                }
+                r->srv = &srv;
+                r->c = conn_init(in, client, true);
+                if (pthread_create(&tid, NULL, reader, r)) {
+                        fprintf(stderr, "error starting reader thread\n");
+                        exit(EXIT_FAILURE);
+                }
+                pthread_detach(tid);
+        }
+}
+// GCOVR_EXCL_STOP
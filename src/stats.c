@@ -18,3 +18,155 @@ float exponential(rnd_pcg_t** pcg, float beta) {
         float x = uniformf(pcg, 0.0f, 1.0f);
         return -logf(1.0f - x) * beta;
 }
+
+static uint64_t avalanche64(uint64_t h) {
+        h ^= h >> 33;
+        h *= UINT64_C(0xff51afd7ed558ccd);
+        h ^= h >> 33;
+        h *= UINT64_C(0xc4ceb9fe1a85ec53);
+        h ^= h >> 33;
+        return h;
+}
+
+void stats_seed_stream(rnd_pcg_t* pcg, uint32_t seed, uint64_t stream) {
+        // Like rnd_pcg_seed, but the increment selects one of 2^63 streams
+        uint64_t value = avalanche64((((uint64_t)seed) << 1) | 1);
+        pcg->state[0] = 0;
+        pcg->state[1] = (avalanche64(stream ^ value) << 1) | 1;
+        rnd_pcg_next(pcg);
+        pcg->state[0] += value;
+        rnd_pcg_next(pcg);
+}
+
+void stats_pcg_advance(rnd_pcg_t* pcg, uint64_t delta) {
+        // Jump ahead in O(log delta) steps by composing the affine update
+        uint64_t mult = UINT64_C(0x5851f42d4c957f2d);
+        uint64_t plus = pcg->state[1];
+        uint64_t accmult = 1;
+        uint64_t accplus = 0;
+        while (delta) {
+                if (delta & 1) {
+                        accmult *= mult;
+                        accplus = accplus * mult + plus;
+                }
+                plus = (mult + 1) * plus;
+                mult *= mult;
+                delta >>= 1;
+        }
+        pcg->state[0] = accmult * pcg->state[0] + accplus;
+}
+
+void stats_philox(uint32_t ctr[4], uint32_t const key[2]) {
+        uint32_t k0 = key[0];
+        uint32_t k1 = key[1];
+        for (int r = 0; r < 10; r++) {
+                uint64_t p0 = (uint64_t)UINT32_C(0xD2511F53) * ctr[0];
+                uint64_t p1 = (uint64_t)UINT32_C(0xCD9E8D57) * ctr[2];
+                uint32_t c1 = ctr[1];
+                uint32_t c3 = ctr[3];
+                ctr[0] = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+                ctr[1] = (uint32_t)p1;
+                ctr[2] = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+                ctr[3] = (uint32_t)p0;
+                k0 += UINT32_C(0x9E3779B9);
+                k1 += UINT32_C(0xBB67AE85);
+        }
+}
+
+static inline float float_from_bits(uint32_t const bits) {
+        // Same conversion as rnd_pcg_nextf
+        union {
+                uint32_t u;
+                float f;
+        } v = {.u = (UINT32_C(127) << 23) | (bits >> 9)};
+        return v.f - 1.0f;
+}
+
+void philox_fill(uint32_t const key[2],
+                 uint64_t const stream,
+                 uint64_t const counter,
+                 float* const dst,
+                 int const n) {
+        for (int i = 0; i < n; i++) {
+                uint64_t c = counter + i;
+                uint32_t ctr[4] = {(uint32_t)c, (uint32_t)(c >> 32),
+                                   (uint32_t)stream, (uint32_t)(stream >> 32)};
+                stats_philox(ctr, key);
+                dst[i] = float_from_bits(ctr[0]);
+                dst[n + i] = float_from_bits(ctr[1]);
+                dst[2 * n + i] = float_from_bits(ctr[2]);
+        }
+}
+
+#define STATS_CHUNK 64
+
+void uniformf_fill(rnd_pcg_t** pcg, float* const dst, int const n) {
+        uint32_t bits[STATS_CHUNK];
+        for (int c = 0; c < n; c += STATS_CHUNK) {
+                int len = n - c < STATS_CHUNK ? n - c : STATS_CHUNK;
+                for (int i = 0; i < len; i++) {
+                        bits[i] = rnd_pcg_next(*pcg);
+                }
+                for (int i = 0; i < len; i++) {
+                        dst[c + i] = float_from_bits(bits[i]);
+                }
+        }
+}
+
+/* Natural logarithm of x > 0 as in Cephes logf, without branches to
+ * vectorize. Accurate to about one ulp for normal x. */
+static inline float stats_logf(float const x) {
+        union {
+                float f;
+                int32_t i;
+        } v = {.f = x};
+        int32_t e = ((v.i >> 23) & 0xff) - 126;
+        v.i = (v.i & 0x007fffff) | 0x3f000000;  // mantissa m in [0.5, 1)
+        float m = v.f;
+        int32_t small = m < 0.707106781186547524f;
+        e -= small;
+        m = (small ? m + m : m) - 1.0f;
+        float fe = (float)e;
+        float z = m * m;
+        float y = 7.0376836292e-2f;
+        y = y * m - 1.1514610310e-1f;
+        y = y * m + 1.1676998740e-1f;
+        y = y * m - 1.2420140846e-1f;
+        y = y * m + 1.4249322787e-1f;
+        y = y * m - 1.6668057665e-1f;
+        y = y * m + 2.0000714765e-1f;
+        y = y * m - 2.4999993993e-1f;
+        y = y * m + 3.3333331174e-1f;
+        y = y * m * z;
+        y += -2.12194440e-4f * fe;
+        y += -0.5f * z;
+        return m + y + 0.693359375f * fe;
+}
+
+void exponential_fill(float const* const u,
+                      float const beta,
+                      float* const dst,
+                      int const n) {
+        for (int i = 0; i < n; i++) {
+                dst[i] = -stats_logf(1.0f - u[i]) * beta;
+        }
+}
+
+void uniform3_fill(float const* const y,
+                   float const* const u,
+                   float const p0,
+                   float const p1,
+                   float const* const bounds,
+                   float* const dst,
+                   int const n) {
+        float const p01 = p0 + p1;
+        float const b0 = bounds[0], b1 = bounds[1], b2 = bounds[2],
+                    b3 = bounds[3], b4 = bounds[4], b5 = bounds[5];
+        for (int i = 0; i < n; i++) {
+                float low = y[i] > p0 ? b2 : b0;
+                float high = y[i] > p0 ? b3 : b1;
+                low = y[i] > p01 ? b4 : low;
+                high = y[i] > p01 ? b5 : high;
+                dst[i] = u[i] * (high - low) + low;
+        }
+}
@@ -0,0 +1,186 @@
+/*
+thready - A lightweight and fast scheduling simulator
+Written in 2019 by Robert Schmidt <rschmidt@uni-bremen.de>
+To the extent possible under law, the author(s) have dedicated all copyright and
+related and neighboring rights to this software to the public domain worldwide.
+This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with
+this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+#define _POSIX_C_SOURCE 200112L  // pthread
+#include "sweep.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "job.h"
+#include "replicate.h"
+
+/* Runs lo to hi (exclusive) left to a thread, taken from the front by the
+ * thread and stolen from the back by others */
+typedef struct {
+        pthread_mutex_t lock;
+        uint64_t lo;
+        uint64_t hi;
+} range;
+
+typedef struct {
+        sweep_grid const* g;
+        int threads;
+        range* ranges;
+        sweep_report report;
+        void* arg;
+        pthread_mutex_t lock;  // serializes report
+} pool;
+
+typedef struct {
+        pool* p;
+        int id;
+} worker_arg;
+
+uint64_t sweep_size(sweep_grid const* const g) {
+        return (uint64_t)g->ntsys * ((uint64_t)g->seedlast - g->seedfirst + 1) *
+               g->nspeeds * g->nbreaktimes * g->noverruns;
+}
+
+sweep_record sweep_point(sweep_grid const* const g, uint64_t const run) {
+        sweep_record r = {0};
+        uint64_t i = run;
+        r.run = run;
+        r.overrun = g->overruns[i % g->noverruns];
+        i /= g->noverruns;
+        r.breaktime = g->breaktimes[i % g->nbreaktimes];
+        i /= g->nbreaktimes;
+        r.speed = g->speeds[i % g->nspeeds];
+        i /= g->nspeeds;
+        uint64_t seeds = (uint64_t)g->seedlast - g->seedfirst + 1;
+        r.seed = g->seedfirst + i % seeds;
+        r.tsy = i / seeds;
+        return r;
+}
+
+sweep_record sweep_simulate(sweep_grid const* const g, uint64_t const run) {
+        sweep_record r = sweep_point(g, run);
+        replicate_config c;
+        c.tsy = g->tsys[r.tsy];
+        c.breaktime = r.breaktime;
+        c.speed = r.speed;
+        c.overrunbreak = r.overrun != SWEEP_OVERRUN_NONE;
+        c.allow_first_overrun = r.overrun == SWEEP_OVERRUN_FIRST;
+        c.readyq = g->readyq;
+        c.arrivalq = g->arrivalq;
+        c.rng = g->rng;
+        replicate_outcome o = replicate_seed(&c, r.seed);
+        r.now = o.now;
+        r.events = o.events;
+        r.jobsdone = o.jobsdone;
+        r.result = o.result;
+        return r;
+}
+
+/* Take the next run of range q, returns false if it is empty */
+static bool take(range* q, uint64_t* run) {
+        pthread_mutex_lock(&q->lock);
+        bool ok = q->lo < q->hi;
+        if (ok) {
+                *run = q->lo++;
+        }
+        pthread_mutex_unlock(&q->lock);
+        return ok;
+}
+
+/* Move the upper half of the runs of another thread to the range of thread
+ * id, returns false if all other ranges are empty */
+static bool steal(pool* p, int const id) {
+        for (int k = 1; k < p->threads; k++) {
+                range* victim = p->ranges + (id + k) % p->threads;
+                pthread_mutex_lock(&victim->lock);
+                uint64_t left = victim->hi - victim->lo;
+                uint64_t hi = victim->hi;
+                uint64_t lo = hi - (left + 1) / 2;
+                victim->hi = lo;
+                pthread_mutex_unlock(&victim->lock);
+                if (left) {
+                        range* own = p->ranges + id;
+                        pthread_mutex_lock(&own->lock);
+                        own->lo = lo;
+                        own->hi = hi;
+                        pthread_mutex_unlock(&own->lock);
+                        return true;
+                }
+        }
+        return false;
+}
+
+static void* worker(void* arg) {
+        pool* p = ((worker_arg*)arg)->p;
+        int id = ((worker_arg*)arg)->id;
+        uint64_t run;
+        for (;;) {
+                if (!take(p->ranges + id, &run)) {
+                        if (steal(p, id)) {
+                                continue;
+                        }
+                        break;
+                }
+                sweep_record r = sweep_simulate(p->g, run);
+                pthread_mutex_lock(&p->lock);
+                p->report(&r, p->arg);
+                pthread_mutex_unlock(&p->lock);
+        }
+        job_pool_free();
+        return NULL;
+}
+
+void sweep_run(sweep_grid const* const g,
+               int threads,
+               sweep_report report,
+               void* arg) {
+        uint64_t n = sweep_size(g);
+        if (!n) {
+                return;
+        }
+        if (threads < 1) {
+                threads = 1;
+        }
+        if ((uint64_t)threads > n) {
+                threads = n;
+        }
+        pool p;
+        p.g = g;
+        p.threads = threads;
+        p.report = report;
+        p.arg = arg;
+        p.ranges = calloc(threads, sizeof(range));
+        pthread_t* tids = calloc(threads, sizeof(pthread_t));
+        worker_arg* args = calloc(threads, sizeof(worker_arg));
+        if (!p.ranges || !tids || !args) {  // GCOVR_EXCL_START
+                fprintf(stderr, "error allocating memory for sweep\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        pthread_mutex_init(&p.lock, NULL);
+        // Start with equal shares of consecutive runs
+        for (int t = 0; t < threads; t++) {
+                pthread_mutex_init(&p.ranges[t].lock, NULL);
+                p.ranges[t].lo = n * t / threads;
+                p.ranges[t].hi = n * (t + 1) / threads;
+        }
+        for (int t = 0; t < threads; t++) {
+                args[t] = (worker_arg){&p, t};
+                if (pthread_create(tids + t, NULL, worker, args + t)) {
+                        // GCOVR_EXCL_START
+                        fprintf(stderr, "error starting sweep thread\n");
+                        exit(EXIT_FAILURE);
+                }  // GCOVR_EXCL_STOP
+        }
+        for (int t = 0; t < threads; t++) {
+                pthread_join(tids[t], NULL);
+        }
+        for (int t = 0; t < threads; t++) {
+                pthread_mutex_destroy(&p.ranges[t].lock);
+        }
+        pthread_mutex_destroy(&p.lock);
+        free(p.ranges);
+        free(tids);
+        free(args);
+}
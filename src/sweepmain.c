@@ -0,0 +1,372 @@
+/*
+thready - A lightweight and fast scheduling simulator
+Written in 2019 by Robert Schmidt <rschmidt@uni-bremen.de>
+To the extent possible under law, the author(s) have dedicated all copyright and
+related and neighboring rights to this software to the public domain worldwide.
+This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with
+this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+/**
+ * @file sweepmain.c
+ * @author Robert Schmidt
+ * @brief Command line parsing and result output of thready-sweep.
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "dump.h"
+#include "job.h"
+#include "out.h"
+#include "parg.h"
+#include "replicate.h"
+#include "sweep.h"
+#include "ts.h"
+
+#define STATE_PREFIXBUFLEN 128
+#define FILENAMEMAXLEN 255
+#define SWEEP_MAXLIST 1024
+
+struct state {
+        char const* files[SWEEP_MAXLIST];
+        ts const* tsys[SWEEP_MAXLIST];
+        JOB_INT speeds[SWEEP_MAXLIST];
+        JOB_INT breaktimes[SWEEP_MAXLIST];
+        sweep_overrun overruns[SWEEP_MAXLIST];
+        sweep_grid g;
+        char prefix[STATE_PREFIXBUFLEN];
+        bool bin;
+        int threads;
+        out* o;
+        time_t flushed;  // last time output was flushed
+};
+
+static char const* const results[] = {"ok", "deadlinemiss", "pass",
+                                      "overrun"};
+static char const* const overruns[] = {"none", "break", "first"};
+
+/* Parse comma separated numbers of arg into list, returns their count */
+static int parse_list(char const* arg, JOB_INT* list, char const* name) {
+        int n = 0;
+        char const* c = arg;
+        for (;;) {
+                char* end;
+                if (n == SWEEP_MAXLIST) {
+                        break;
+                }
+                list[n++] = strtoll(c, &end, 10);
+                if (end == c || (*end && *end != ',')) {
+                        break;
+                }
+                if (!*end) {
+                        return n;
+                }
+                c = end + 1;
+        }
+        fprintf(stderr, "invalid %s list '%s'\n", name, arg);
+        exit(EXIT_FAILURE);
+}
+
+static int parse_overruns(char const* arg, sweep_overrun* list) {
+        int n = 0;
+        char const* c = arg;
+        while (n < SWEEP_MAXLIST) {
+                size_t len = strcspn(c, ",");
+                int mode = -1;
+                for (int m = 0; m < 3; m++) {
+                        if (strlen(overruns[m]) == len &&
+                            !strncmp(c, overruns[m], len)) {
+                                mode = m;
+                        }
+                }
+                if (mode < 0) {
+                        break;
+                }
+                list[n++] = mode;
+                if (!c[len]) {
+                        return n;
+                }
+                c += len + 1;
+        }
+        fprintf(stderr, "invalid overrun list '%s'\n", arg);
+        exit(EXIT_FAILURE);
+}
+
+static void report(sweep_record const* r, void* arg) {
+        struct state* s = arg;
+        if (s->bin) {
+                out_mem(s->o, r, sizeof(*r));
+        } else {
+                out_str(s->o, s->files[r->tsy]);
+                out_char(s->o, ',');
+                out_int(s->o, (int64_t)r->run);
+                out_char(s->o, ',');
+                out_int(s->o, r->seed);
+                out_char(s->o, ',');
+                out_int(s->o, r->speed);
+                out_char(s->o, ',');
+                out_int(s->o, r->breaktime);
+                out_char(s->o, ',');
+                out_str(s->o, overruns[r->overrun]);
+                out_char(s->o, ',');
+                out_str(s->o, results[r->result]);
+                out_char(s->o, ',');
+                out_int(s->o, r->now);
+                out_char(s->o, ',');
+                out_int(s->o, r->events);
+                out_char(s->o, ',');
+                out_int(s->o, r->jobsdone);
+                out_char(s->o, '\n');
+        }
+        // Stream results of long runs at least once a second
+        time_t now = time(NULL);
+        if (now != s->flushed) {
+                out_flush(s->o);
+                s->flushed = now;
+        }
+}
+
+int main(int argc, char* argv[]) {
+        struct state* s = calloc(1, sizeof(struct state));
+        if (!s) {
+                fprintf(stderr, "error allocating memory\n");
+                exit(EXIT_FAILURE);
+        }
+
+        // Setting default values
+        s->g.tsys = s->tsys;
+        s->g.speeds = s->speeds;
+        s->g.breaktimes = s->breaktimes;
+        s->g.overruns = s->overruns;
+        s->g.nspeeds = 1;
+        s->speeds[0] = 1;
+        s->g.nbreaktimes = 1;
+        s->breaktimes[0] = 60000;
+        s->g.noverruns = 1;
+        s->overruns[0] = SWEEP_OVERRUN_NONE;
+        s->g.readyq = JOBQ_HEAP;
+        s->g.arrivalq = JOBGEN_ARRAY;
+        s->g.rng = JOBGEN_RNG_SHARED;
+        s->threads = replicate_threads();
+
+        int prefixlen = 0;
+
+        struct parg_state ps;
+        int c;
+        parg_init(&ps);
+        // abcdefghijklmnopqrstuvwxyz ABCDEFGHIJKLMNOPQRSTUVWXYZ
+        //      xxx x  xxx x xx xx  x
+        while ((c = parg_getopt(&ps, argc, argv,
+                                "hvj:z:w:t:o:q:g:s:m:f:n:")) != -1) {
+                switch (c) {
+                        case 1:
+                                printf("nonoption '%s'\n", ps.optarg);
+                                break;
+                        case 'h':
+                                printf(
+                                    "Usage: thready-sweep [-h] [-v] "
+                                    "-j <tasksystemfile.json> "
+                                    "[-j <tasksystemfile.json> ...] "
+                                    "[-z jobtracerandomseed|first:last] "
+                                    "[-w work/timestep,...] "
+                                    "[-t breaktime,...] "
+                                    "[-o none|break|first,...] "
+                                    "[-q heap|pertask|calendar] "
+                                    "[-g array|heap|calendar] "
+                                    "[-s shared|batch|counter] "
+                                    "[-m threads] "
+                                    "[-f csv|bin] "
+                                    "-n resultprefix\n");
+                                exit(EXIT_SUCCESS);
+                                break;
+                        case 'v':
+                                printf("thready-sweep %s\n", VERSION);
+                                return EXIT_SUCCESS;
+                                break;
+                        case 'j':
+                                if (s->g.ntsys == SWEEP_MAXLIST) {
+                                        fprintf(stderr,
+                                                "more than %d task systems\n",
+                                                SWEEP_MAXLIST);
+                                        exit(EXIT_FAILURE);
+                                }
+                                s->files[s->g.ntsys++] = ps.optarg;
+                                break;
+                        case 'z': {  // seed or range of seeds first:last
+                                char* end;
+                                s->g.seedfirst = strtoul(ps.optarg, &end, 10);
+                                s->g.seedlast = s->g.seedfirst;
+                                if (*end == ':') {
+                                        s->g.seedlast =
+                                            strtoul(end + 1, &end, 10);
+                                }
+                                if (*end || s->g.seedlast < s->g.seedfirst) {
+                                        fprintf(stderr,
+                                                "invalid seed range '%s'\n",
+                                                ps.optarg);
+                                        exit(EXIT_FAILURE);
+                                }
+                                break;
+                        }
+                        case 'w':  // Processor speeds
+                                s->g.nspeeds =
+                                    parse_list(ps.optarg, s->speeds, "speed");
+                                break;
+                        case 't':
+                                s->g.nbreaktimes = parse_list(
+                                    ps.optarg, s->breaktimes, "breaktime");
+                                break;
+                        case 'o':  // Overrun modes
+                                s->g.noverruns =
+                                    parse_overruns(ps.optarg, s->overruns);
+                                break;
+                        case 'q':  // Data structure of scheduler queue
+                                if (!strcmp(ps.optarg, "heap")) {
+                                        s->g.readyq = JOBQ_HEAP;
+                                } else if (!strcmp(ps.optarg, "pertask")) {
+                                        s->g.readyq = JOBQ_PERTASK;
+                                } else if (!strcmp(ps.optarg, "calendar")) {
+                                        s->g.readyq = JOBQ_CALENDAR;
+                                } else {
+                                        fprintf(stderr,
+                                                "unknown queue '%s'\n",
+                                                ps.optarg);
+                                        exit(EXIT_FAILURE);
+                                }
+                                break;
+                        case 'g':  // Data structure of job generator queue
+                                if (!strcmp(ps.optarg, "array")) {
+                                        s->g.arrivalq = JOBGEN_ARRAY;
+                                } else if (!strcmp(ps.optarg, "heap")) {
+                                        s->g.arrivalq = JOBGEN_HEAP;
+                                } else if (!strcmp(ps.optarg, "calendar")) {
+                                        s->g.arrivalq = JOBGEN_CALENDAR;
+                                } else {
+                                        fprintf(stderr,
+                                                "unknown queue '%s'\n",
+                                                ps.optarg);
+                                        exit(EXIT_FAILURE);
+                                }
+                                break;
+                        case 's':  // Random streams of job generator
+                                if (!strcmp(ps.optarg, "shared")) {
+                                        s->g.rng = JOBGEN_RNG_SHARED;
+                                } else if (!strcmp(ps.optarg, "batch")) {
+                                        s->g.rng = JOBGEN_RNG_BATCH;
+                                } else if (!strcmp(ps.optarg, "counter")) {
+                                        s->g.rng = JOBGEN_RNG_COUNTER;
+                                } else {
+                                        fprintf(stderr,
+                                                "unknown random stream '%s'\n",
+                                                ps.optarg);
+                                        exit(EXIT_FAILURE);
+                                }
+                                break;
+                        case 'm':  // Worker threads
+                                s->threads = atoi(ps.optarg);
+                                break;
+                        case 'f':  // Format of results
+                                if (!strcmp(ps.optarg, "csv")) {
+                                        s->bin = false;
+                                } else if (!strcmp(ps.optarg, "bin")) {
+                                        s->bin = true;
+                                } else {
+                                        fprintf(stderr,
+                                                "unknown result format '%s'\n",
+                                                ps.optarg);
+                                        exit(EXIT_FAILURE);
+                                }
+                                break;
+                        case 'n':
+                                prefixlen = strlen(ps.optarg);
+                                if (prefixlen <= STATE_PREFIXBUFLEN - 1) {
+                                        strncpy(s->prefix, ps.optarg,
+                                                STATE_PREFIXBUFLEN);
+                                } else {
+                                        fprintf(stderr,
+                                                "prefix too long > %d\n",
+                                                STATE_PREFIXBUFLEN);
+                                        exit(EXIT_FAILURE);
+                                }
+                                break;
+                        case '?':
+                                if (strchr("jzwtoqgsmfn", ps.optopt)) {
+                                        printf(
+                                            "option -%c requires an argument\n",
+                                            ps.optopt);
+                                } else {
+                                        printf("unknown option -%c\n",
+                                               ps.optopt);
+                                }
+                                exit(EXIT_FAILURE);
+                                break;
+                        default:
+                                printf("error: unhandled option -%c\n", c);
+                                exit(EXIT_FAILURE);
+                                break;
+                }
+        }
+
+        if (!prefixlen) {
+                fprintf(stderr, "no result prefix specified\n");
+                exit(EXIT_FAILURE);
+        }
+        if (!s->g.ntsys) {
+                fprintf(stderr, "no tasksystem json file specified\n");
+                exit(EXIT_FAILURE);
+        }
+
+        // Read all task systems once, shared by all runs
+        for (int i = 0; i < s->g.ntsys; i++) {
+                FILE* stream = fopen(s->files[i], "r");
+                if (!stream) {
+                        fprintf(stderr, "can't open task system '%s'\n",
+                                s->files[i]);
+                        exit(EXIT_FAILURE);
+                }
+                ts* tsy = ts_init();
+                ts_read_json(tsy, stream);
+                fclose(stream);
+                s->tsys[i] = tsy;
+        }
+
+        char fname[FILENAMEMAXLEN] = {0};
+        strncpy(fname, s->prefix, STATE_PREFIXBUFLEN);
+        strcat(fname, s->bin ? "_sweep.bin" : "_sweep.csv");
+        FILE* stream = fopen(fname, s->bin ? "wb" : "w");
+        if (!stream) {
+                fprintf(stderr, "result io error\n");
+                exit(EXIT_FAILURE);
+        }
+        s->o = out_init(stream);
+        if (s->bin) {
+                sweep_header h = {{0}, SWEEP_VERSION, DUMP_BYTEORDER,
+                                  sweep_size(&s->g)};
+                memcpy(h.magic, SWEEP_MAGIC, sizeof(SWEEP_MAGIC));
+                out_mem(s->o, &h, sizeof(h));
+        } else {
+                out_str(s->o,
+                        "tasksystem,run,seed,speed,breaktime,overrun,result,"
+                        "now,events,jobsdone\n");
+        }
+        s->flushed = time(NULL);
+
+        sweep_run(&s->g, s->threads, report, s);
+
+        out_free(s->o);
+        if (fclose(stream)) {
+                fprintf(stderr, "result io error\n");
+                exit(EXIT_FAILURE);
+        }
+        for (int i = 0; i < s->g.ntsys; i++) {
+                ts_free((ts*)s->tsys[i]);
+        }
+        job_pool_free();
+        free(s);
+        return EXIT_SUCCESS;
+}
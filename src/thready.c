@@ -0,0 +1,272 @@
+/*
+thready - A lightweight and fast scheduling simulator
+Written in 2019 by Robert Schmidt <rschmidt@uni-bremen.de>
+To the extent possible under law, the author(s) have dedicated all copyright and
+related and neighboring rights to this software to the public domain worldwide.
+This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with
+this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+#define _POSIX_C_SOURCE 200112L  // pthread
+#include "thready.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "eventloop.h"
+#include "job.h"
+#include "jobgen.h"
+#include "jobq.h"
+#include "task.h"
+#include "ts.h"
+
+#ifndef VERSION
+#define VERSION "unknown"
+#endif
+
+/* The public enums list the values of jobq_kind, jobgen_queue, jobgen_rng and
+ * eventloop_result in the same order, so they convert by cast. */
+
+struct thready_tasksystem {
+        ts* tsy;
+};
+
+/* Runs shared by the threads, next guarded by lock */
+typedef struct {
+        ts const* tsy;
+        thready_run const* runs;
+        size_t n;
+        size_t next;
+        thready_options const* o;
+        thready_outcome* outcomes;
+        pthread_mutex_t lock;
+} batch;
+
+static thready_status finish(thready_tasksystem** tsy, ts* t) {
+        if (ts_check(t)) {
+                ts_free(t);
+                return THREADY_ETASKSYSTEM;
+        }
+        *tsy = malloc(sizeof(thready_tasksystem));
+        if (!*tsy) {  // GCOVR_EXCL_START
+                ts_free(t);
+                return THREADY_ENOMEM;
+        }  // GCOVR_EXCL_STOP
+        (*tsy)->tsy = t;
+        return THREADY_OK;
+}
+
+thready_status thready_tasksystem_init(thready_tasksystem** tsy,
+                                       thready_task const* tasks,
+                                       int n) {
+        if (!tsy) {
+                return THREADY_EINVAL;
+        }
+        *tsy = NULL;
+        if (n < 0 || (n && !tasks)) {
+                return THREADY_EINVAL;
+        }
+        // Columns of the parameters as read by ts_read_params
+        TASK_INT* ints = calloc((3 + TASK_NUM_COMP) * (size_t)n + 1,
+                                sizeof(TASK_INT));
+        float* floats = calloc((1 + TASK_NUM_PROB) * (size_t)n + 1,
+                               sizeof(float));
+        if (!ints || !floats) {  // GCOVR_EXCL_START
+                free(ints);
+                free(floats);
+                return THREADY_ENOMEM;
+        }  // GCOVR_EXCL_STOP
+        ts_params p;
+        p.n = n;
+        p.ids = ints;
+        p.periods = ints + n;
+        p.reldeads = ints + 2 * n;
+        for (int j = 0; j < TASK_NUM_COMP; j++) {
+                p.comp[j] = ints + (3 + j) * n;
+        }
+        for (int j = 0; j < TASK_NUM_PROB; j++) {
+                p.prob[j] = floats + j * n;
+        }
+        p.beta = floats + TASK_NUM_PROB * n;
+        for (int k = 0; k < n; k++) {
+                thready_task const* t = tasks + k;
+                p.ids[k] = t->id;
+                p.periods[k] = t->period;
+                p.reldeads[k] = t->reldead;
+                for (int j = 0; j < TASK_NUM_COMP; j++) {
+                        p.comp[j][k] = t->comp[j];
+                }
+                for (int j = 0; j < TASK_NUM_PROB; j++) {
+                        p.prob[j][k] = t->prob[j];
+                }
+                p.beta[k] = t->beta;
+        }
+        ts* t = ts_init();
+        ts_read_params(t, &p);
+        free(ints);
+        free(floats);
+        return finish(tsy, t);
+}
+
+thready_status thready_tasksystem_parse(thready_tasksystem** tsy,
+                                        char const* json,
+                                        size_t len) {
+        if (!tsy) {
+                return THREADY_EINVAL;
+        }
+        *tsy = NULL;
+        if (!json) {
+                if (len) {
+                        return THREADY_EINVAL;
+                }
+                json = "";
+        }
+        ts* t = ts_init();
+        if (ts_parse_json(t, json, len)) {
+                ts_free(t);
+                return THREADY_EPARSE;
+        }
+        return finish(tsy, t);
+}
+
+void thready_tasksystem_free(thready_tasksystem* tsy) {
+        if (tsy) {
+                ts_free(tsy->tsy);
+                free(tsy);
+        }
+}
+
+int thready_tasksystem_length(thready_tasksystem const* tsy) {
+        return ts_length(tsy->tsy);
+}
+
+void thready_options_default(thready_options* o) {
+        o->readyq = THREADY_READYQ_HEAP;
+        o->arrivalq = THREADY_ARRIVALQ_ARRAY;
+        o->rng = THREADY_RNG_SHARED;
+        o->threads = 1;
+}
+
+static thready_outcome simulate(ts const* const tsy,
+                                thready_run const* const r,
+                                thready_options const* const o) {
+        jobgen* jg = jobgen_init(tsy, r->seed, true, (jobgen_queue)o->arrivalq,
+                                 (jobgen_rng)o->rng);
+        eventloop* evl = eventloop_init(jg, true,
+                                        r->overrun == THREADY_OVERRUN_FIRST,
+                                        (jobq_kind)o->readyq);
+        eventloop_set_quiet(evl, true);
+        thready_outcome out;
+        out.result = (thready_result)eventloop_run(
+            evl, r->breaktime, r->speed, r->overrun != THREADY_OVERRUN_NONE);
+        out.now = eventloop_get_now(evl);
+        out.events = eventloop_get_events(evl);
+        out.jobsdone = eventloop_get_jobsdone(evl);
+        eventloop_free(evl);
+        jobgen_free(jg);
+        return out;
+}
+
+static void simulate_batch(batch* b) {
+        for (;;) {
+                pthread_mutex_lock(&b->lock);
+                size_t i = b->next++;
+                pthread_mutex_unlock(&b->lock);
+                if (i >= b->n) {
+                        break;
+                }
+                b->outcomes[i] = simulate(b->tsy, b->runs + i, b->o);
+        }
+}
+
+static void* worker(void* arg) {
+        simulate_batch(arg);
+        job_pool_free();
+        return NULL;
+}
+
+static bool valid_options(thready_options const* const o) {
+        return o->readyq >= THREADY_READYQ_HEAP &&
+               o->readyq <= THREADY_READYQ_CALENDAR &&
+               o->arrivalq >= THREADY_ARRIVALQ_ARRAY &&
+               o->arrivalq <= THREADY_ARRIVALQ_CALENDAR &&
+               o->rng >= THREADY_RNG_SHARED && o->rng <= THREADY_RNG_COUNTER;
+}
+
+static bool valid_run(thready_run const* const r) {
+        return r->breaktime >= 0 && r->speed >= 1 &&
+               r->overrun >= THREADY_OVERRUN_NONE &&
+               r->overrun <= THREADY_OVERRUN_FIRST;
+}
+
+thready_status thready_simulate(thready_tasksystem const* tsy,
+                                thready_run const* runs,
+                                size_t n,
+                                thready_options const* o,
+                                thready_outcome* outcomes) {
+        thready_options defaults;
+        if (!o) {
+                thready_options_default(&defaults);
+                o = &defaults;
+        }
+        if (!tsy || (n && (!runs || !outcomes)) || !valid_options(o)) {
+                return THREADY_EINVAL;
+        }
+        for (size_t i = 0; i < n; i++) {
+                if (!valid_run(runs + i)) {
+                        return THREADY_EINVAL;
+                }
+        }
+        batch b;
+        b.tsy = tsy->tsy;
+        b.runs = runs;
+        b.n = n;
+        b.next = 0;
+        b.o = o;
+        b.outcomes = outcomes;
+        pthread_mutex_init(&b.lock, NULL);
+        // The calling thread simulates as well, so a thread which can't be
+        // started only slows the batch down
+        size_t threads = o->threads > 1 ? (size_t)o->threads : 1;
+        threads = threads < n ? threads : (n ? n : 1);
+        pthread_t* tids = calloc(threads, sizeof(pthread_t));
+        size_t started = 0;
+        if (tids) {
+                while (started < threads - 1 &&
+                       !pthread_create(tids + started, NULL, worker, &b)) {
+                        started++;
+                }
+        }
+        simulate_batch(&b);
+        for (size_t t = 0; t < started; t++) {
+                pthread_join(tids[t], NULL);
+        }
+        free(tids);
+        pthread_mutex_destroy(&b.lock);
+        return THREADY_OK;
+}
+
+void thready_thread_free(void) {
+        job_pool_free();
+}
+
+char const* thready_strerror(thready_status s) {
+        switch (s) {
+                case THREADY_OK:
+                        return "success";
+                case THREADY_EINVAL:
+                        return "invalid argument";
+                case THREADY_EPARSE:
+                        return "malformed task system";
+                case THREADY_ETASKSYSTEM:
+                        return "jobs can't be generated from task system";
+                case THREADY_ENOMEM:
+                        return "out of memory";
+                default:  // GCOVR_EXCL_START
+                        return "unknown status";
+                        // GCOVR_EXCL_STOP
+        }
+}
+
+char const* thready_version(void) {
+        return VERSION;
+}
@@ -0,0 +1,107 @@
+/*
+thready - A lightweight and fast scheduling simulator
+Written in 2019 by Robert Schmidt <rschmidt@uni-bremen.de>
+To the extent possible under law, the author(s) have dedicated all copyright and
+related and neighboring rights to this software to the public domain worldwide.
+This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with
+this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+#include "tourn.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TOURN_EMPTY UINT64_MAX
+
+/* Internal node i holds the winning slot of its subtree, the leaf of slot s
+ * is the implicit node size + s. */
+struct tourn {
+        int size;  // number of leaves, power of two
+        int* win;
+        JOB_INT* pri;
+        uint64_t* seq;  // TOURN_EMPTY marks an empty slot
+};
+
+tourn* tourn_init(int const n) {
+        tourn* tt = calloc(1, sizeof(tourn));
+        if (!tt) {  // GCOVR_EXCL_START
+                fprintf(stderr, "error allocating memory for tournament: %s\n",
+                        strerror(errno));
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        tt->size = 1;
+        while (tt->size < n) {
+                tt->size *= 2;
+        }
+        tt->win = calloc(tt->size, sizeof(int));
+        tt->pri = calloc(tt->size, sizeof(JOB_INT));
+        tt->seq = calloc(tt->size, sizeof(uint64_t));
+        if (!tt->win || !tt->pri || !tt->seq) {  // GCOVR_EXCL_START
+                fprintf(stderr, "error allocating memory for tournament: %s\n",
+                        strerror(errno));
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        for (int s = 0; s < tt->size; s++) {
+                tt->seq[s] = TOURN_EMPTY;
+        }
+        // All slots are empty, let the leftmost leaf win every match
+        for (int i = tt->size - 1; i > 0; i--) {
+                int node = i;
+                while (node < tt->size) {
+                        node *= 2;
+                }
+                tt->win[i] = node - tt->size;
+        }
+        return tt;
+}
+
+void tourn_free(tourn* tt) {
+        free(tt->win);
+        free(tt->pri);
+        free(tt->seq);
+        free(tt);
+}
+
+static inline int winner_of(tourn const* const tt, int const node) {
+        return node < tt->size ? tt->win[node] : node - tt->size;
+}
+
+static inline int before(tourn const* const tt, int const a, int const b) {
+        if (tt->seq[b] == TOURN_EMPTY) {
+                return 1;
+        }
+        if (tt->seq[a] == TOURN_EMPTY) {
+                return 0;
+        }
+        return (tt->pri[a] < tt->pri[b]) ||
+               ((tt->pri[a] == tt->pri[b]) && (tt->seq[a] < tt->seq[b]));
+}
+
+static void replay(tourn* const tt, int const slot) {
+        for (int node = (tt->size + slot) / 2; node > 0; node /= 2) {
+                int l = winner_of(tt, 2 * node);
+                int r = winner_of(tt, 2 * node + 1);
+                tt->win[node] = before(tt, r, l) ? r : l;
+        }
+}
+
+void tourn_update(tourn* const tt,
+                  int const slot,
+                  JOB_INT const pri,
+                  uint64_t const seq) {
+        tt->pri[slot] = pri;
+        tt->seq[slot] = seq;
+        replay(tt, slot);
+}
+
+void tourn_clear(tourn* const tt, int const slot) {
+        tt->seq[slot] = TOURN_EMPTY;
+        replay(tt, slot);
+}
+
+int tourn_winner(tourn const* const tt) {
+        int w = winner_of(tt, 1);
+        return tt->seq[w] == TOURN_EMPTY ? -1 : w;
+}
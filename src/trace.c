@@ -0,0 +1,476 @@
+/*
+thready - A lightweight and fast scheduling simulator
+Written in 2019 by Robert Schmidt <rschmidt@uni-bremen.de>
+To the extent possible under law, the author(s) have dedicated all copyright and
+related and neighboring rights to this software to the public domain worldwide.
+This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with
+this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+#define _POSIX_C_SOURCE 200112L  // fileno
+#include "trace.h"
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "dump.h"
+#include "out.h"
+
+#define TRACE_VARINTLEN 10  // bytes of the longest uint64_t varint
+#define TRACE_FIELDS 5
+
+struct trace_writer {
+        out* o;
+        uint64_t offset;  // bytes written
+        uint64_t records;
+        int64_t prev;  // arrival of the former record
+        trace_entry* index;
+        size_t entries;
+        size_t cap;
+};
+
+struct trace {
+        uint8_t const* base;
+        size_t len;
+        trace_header const* h;
+        trace_entry const* index;
+        uint64_t entries;
+        uint64_t records;
+        uint8_t const* end;  // end of the records
+        uint8_t const* pos;
+        uint64_t record;  // number of the record at pos
+        int64_t prev;
+        ts_params const* p;
+};
+
+struct trace_csv {
+        FILE* stream;
+        ts const* tsy;
+        ts_params const* p;
+        char* buf;  // TRACE_READLEN and a terminating newline
+        size_t pos;
+        size_t len;
+        bool eof;
+        uint64_t line;  // number of the line returned last
+        int64_t prev;
+};
+
+/* Decoded record */
+typedef struct {
+        uint64_t taskpos;
+        int64_t starttime;
+        int64_t deadline;
+        int64_t computation;
+        int64_t overruntime;
+} trace_rec;
+
+static uint64_t zigzag(int64_t const v) {
+        return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static int64_t unzigzag(uint64_t const u) {
+        return (int64_t)(u >> 1) ^ -(int64_t)(u & 1);
+}
+
+static size_t put_varint(uint8_t* p, uint64_t v) {
+        size_t n = 0;
+        while (v >= 0x80) {
+                p[n++] = (uint8_t)v | 0x80;
+                v >>= 7;
+        }
+        p[n++] = (uint8_t)v;
+        return n;
+}
+
+trace_writer* trace_writer_init(FILE* stream,
+                                ts const* const tsy,
+                                uint64_t const first) {
+        trace_writer* tw = calloc(1, sizeof(trace_writer));
+        if (!tw) {  // GCOVR_EXCL_START
+                fprintf(stderr, "error allocating memory for job trace\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        tw->o = out_init(stream);
+
+        trace_header h = {0};
+        memcpy(h.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+        h.version = TRACE_VERSION;
+        h.byteorder = DUMP_BYTEORDER;
+        h.tshash = ts_hash(tsy);
+        h.first = first;
+        h.interval = TRACE_INTERVAL;
+        h.ntasks = ts_length(tsy);
+        out_mem(tw->o, &h, sizeof(h));
+        tw->offset = sizeof(h);
+        return tw;
+}
+
+void trace_write(trace_writer* tw, job* const j) {
+        JOB_INT starttime = job_get_starttime(j);
+        if (tw->records % TRACE_INTERVAL == 0) {
+                if (tw->entries == tw->cap) {
+                        tw->cap = tw->cap ? 2 * tw->cap : 64;
+                        tw->index =
+                            realloc(tw->index, tw->cap * sizeof(trace_entry));
+                        if (!tw->index) {  // GCOVR_EXCL_START
+                                fprintf(stderr,
+                                        "error allocating memory for job "
+                                        "trace\n");
+                                exit(EXIT_FAILURE);
+                        }  // GCOVR_EXCL_STOP
+                }
+                tw->index[tw->entries++] =
+                    (trace_entry){tw->offset, starttime};
+                tw->prev = 0;  // arrival in full
+        }
+        if (starttime < tw->prev) {  // GCOVR_EXCL_START
+                fprintf(stderr, "job trace out of arrival order\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+
+        uint8_t buf[TRACE_FIELDS * TRACE_VARINTLEN];
+        size_t n = put_varint(buf, job_get_taskpos(j));
+        n += put_varint(buf + n, starttime - tw->prev);
+        n += put_varint(buf + n, zigzag(job_get_deadline(j) - starttime));
+        n += put_varint(buf + n, zigzag(job_get_computation(j)));
+        n += put_varint(buf + n, zigzag(job_get_overruntime(j)));
+        out_mem(tw->o, buf, n);
+        tw->offset += n;
+        tw->prev = starttime;
+        tw->records++;
+}
+
+void trace_writer_free(trace_writer* tw) {
+        // Align the index to be read in place
+        uint8_t pad[sizeof(uint64_t)] = {0};
+        size_t n = -tw->offset % sizeof(uint64_t);
+        out_mem(tw->o, pad, n);
+        trace_footer f = {tw->records, tw->offset + n, tw->entries, {0}};
+        memcpy(f.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+        out_mem(tw->o, tw->index, tw->entries * sizeof(trace_entry));
+        out_mem(tw->o, &f, sizeof(f));
+        out_free(tw->o);
+        free(tw->index);
+        free(tw);
+}
+
+static void truncated(void) {  // GCOVR_EXCL_START
+        fprintf(stderr, "job trace truncated\n");
+        exit(EXIT_FAILURE);
+}  // GCOVR_EXCL_STOP
+
+static uint64_t get_varint(trace* tr) {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+                if (tr->pos == tr->end) {
+                        truncated();  // GCOVR_EXCL_LINE
+                }
+                uint8_t b = *tr->pos++;
+                v |= (uint64_t)(b & 0x7f) << shift;
+                if (!(b & 0x80)) {
+                        return v;
+                }
+        }
+        truncated();  // GCOVR_EXCL_LINE
+        return v;     // GCOVR_EXCL_LINE
+}
+
+/* Decode the record at the current position and advance */
+static bool decode(trace* tr, trace_rec* r) {
+        if (tr->record == tr->h->first + tr->records) {
+                return false;
+        }
+        if ((tr->record - tr->h->first) % tr->h->interval == 0) {
+                tr->prev = 0;
+        }
+        r->taskpos = get_varint(tr);
+        r->starttime = tr->prev + (int64_t)get_varint(tr);
+        r->deadline = r->starttime + unzigzag(get_varint(tr));
+        r->computation = unzigzag(get_varint(tr));
+        r->overruntime = unzigzag(get_varint(tr));
+        if (r->taskpos >= (uint64_t)tr->p->n) {  // GCOVR_EXCL_START
+                fprintf(stderr, "job trace holds job of unknown task\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        tr->prev = r->starttime;
+        tr->record++;
+        return true;
+}
+
+trace* trace_init(FILE* stream, ts const* const tsy) {
+        struct stat st;
+        int fd = fileno(stream);
+        if (fd < 0 || fstat(fd, &st) ||
+            (size_t)st.st_size <
+                sizeof(trace_header) + sizeof(trace_footer)) {
+                truncated();  // GCOVR_EXCL_LINE
+        }
+        size_t len = st.st_size;
+        void* mem = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mem == MAP_FAILED) {  // GCOVR_EXCL_START
+                fprintf(stderr, "error mapping job trace\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        trace* tr = calloc(1, sizeof(trace));
+        if (!tr) {  // GCOVR_EXCL_START
+                fprintf(stderr, "error allocating memory for job trace\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        tr->base = mem;
+        tr->len = len;
+        tr->h = mem;
+        tr->p = ts_get_params(tsy);
+
+        trace_footer f;
+        memcpy(&f, tr->base + len - sizeof(f), sizeof(f));
+        if (memcmp(tr->h->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) ||
+            memcmp(f.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) ||
+            tr->h->version != TRACE_VERSION ||
+            tr->h->byteorder != DUMP_BYTEORDER ||
+            !tr->h->interval) {  // GCOVR_EXCL_START
+                fprintf(stderr, "unsupported job trace format\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        if (tr->h->ntasks != (uint64_t)ts_length(tsy) ||
+            tr->h->tshash != ts_hash(tsy)) {  // GCOVR_EXCL_START
+                fprintf(stderr, "job trace of another task system\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        if (f.index < sizeof(trace_header) || f.index % sizeof(uint64_t) ||
+            f.index + f.entries * sizeof(trace_entry) + sizeof(f) != len ||
+            f.entries != (f.records + tr->h->interval - 1) /
+                             tr->h->interval) {
+                truncated();  // GCOVR_EXCL_LINE
+        }
+        tr->index = (trace_entry const*)(tr->base + f.index);
+        tr->entries = f.entries;
+        tr->records = f.records;
+        tr->end = tr->base + f.index;
+        tr->pos = tr->base + sizeof(trace_header);
+        tr->record = tr->h->first;
+        return tr;
+}
+
+void trace_free(trace* tr) {
+        munmap((void*)tr->base, tr->len);
+        free(tr);
+}
+
+job* trace_next(trace* tr) {
+        trace_rec r;
+        if (!decode(tr, &r)) {
+                return NULL;
+        }
+        job* j = job_init(tr->p->ids[r.taskpos], r.starttime, r.overruntime,
+                          r.deadline, r.computation);
+        job_set_taskpos(j, (int)r.taskpos);
+        return j;
+}
+
+/* Position at index entry i */
+static void seek_entry(trace* tr, uint64_t const i) {
+        tr->pos = tr->base + tr->index[i].offset;
+        tr->record = tr->h->first + i * tr->h->interval;
+}
+
+void trace_seek(trace* tr, uint64_t const record) {
+        uint64_t first = tr->h->first;
+        if (record < first || record > first + tr->records) {
+                // GCOVR_EXCL_START
+                fprintf(stderr,
+                        "job trace holds records %" PRIu64 " to %" PRIu64
+                        ", not %" PRIu64 "\n",
+                        first, first + tr->records, record);
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        if (record == first + tr->records) {
+                tr->pos = tr->end;
+                tr->record = record;
+                return;
+        }
+        seek_entry(tr, (record - first) / tr->h->interval);
+        trace_rec r;
+        while (tr->record < record) {
+                decode(tr, &r);
+        }
+}
+
+void trace_seek_time(trace* tr, JOB_INT const time) {
+        if (!tr->entries) {
+                return;
+        }
+        // Last index entry arriving before time
+        uint64_t lo = 0;
+        uint64_t hi = tr->entries;
+        while (lo + 1 < hi) {
+                uint64_t mid = lo + (hi - lo) / 2;
+                if (tr->index[mid].time < time) {
+                        lo = mid;
+                } else {
+                        hi = mid;
+                }
+        }
+        seek_entry(tr, lo);
+        trace_rec r;
+        for (;;) {
+                trace saved = *tr;
+                if (!decode(tr, &r)) {
+                        return;
+                }
+                if (r.starttime >= time) {
+                        *tr = saved;
+                        return;
+                }
+        }
+}
+
+uint64_t trace_tell(trace const* const tr) {
+        return tr->record;
+}
+
+void trace_range(trace const* const tr, uint64_t* first, uint64_t* end) {
+        *first = tr->h->first;
+        *end = tr->h->first + tr->records;
+}
+
+trace_csv* trace_csv_init(FILE* stream, ts const* const tsy) {
+        trace_csv* tc = calloc(1, sizeof(trace_csv));
+        char* buf = malloc(TRACE_READLEN + 1);
+        if (!tc || !buf) {  // GCOVR_EXCL_START
+                fprintf(stderr, "error allocating memory for job trace\n");
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        tc->stream = stream;
+        tc->tsy = tsy;
+        tc->p = ts_get_params(tsy);
+        tc->buf = buf;
+        tc->prev = INT64_MIN;
+        return tc;
+}
+
+void trace_csv_free(trace_csv* tc) {
+        free(tc->buf);
+        free(tc);
+}
+
+/* Returns the next line terminated by a newline, or NULL at the end */
+static char* csv_line(trace_csv* tc) {
+        for (;;) {
+                char* begin = tc->buf + tc->pos;
+                char* nl = memchr(begin, '\n', tc->len - tc->pos);
+                if (nl) {
+                        tc->pos = nl - tc->buf + 1;
+                        return begin;
+                }
+                if (tc->eof) {
+                        if (tc->pos == tc->len) {
+                                return NULL;
+                        }
+                        // Last line without newline
+                        tc->buf[tc->len++] = '\n';
+                        continue;
+                }
+                // Move the partial line to the front and read ahead
+                size_t rest = tc->len - tc->pos;
+                if (rest == TRACE_READLEN) {  // GCOVR_EXCL_START
+                        fprintf(stderr,
+                                "job trace line %" PRIu64 " too long\n",
+                                tc->line);
+                        exit(EXIT_FAILURE);
+                }  // GCOVR_EXCL_STOP
+                memmove(tc->buf, begin, rest);
+                tc->pos = 0;
+                tc->len = rest + fread(tc->buf + rest, 1,
+                                       TRACE_READLEN - rest, tc->stream);
+                if (tc->len < TRACE_READLEN) {
+                        tc->eof = feof(tc->stream) || ferror(tc->stream);
+                }
+        }
+}
+
+static void csv_malformed(trace_csv const* const tc) {  // GCOVR_EXCL_START
+        fprintf(stderr, "job trace line %" PRIu64 " malformed\n", tc->line);
+        exit(EXIT_FAILURE);
+}  // GCOVR_EXCL_STOP
+
+/* Parse the field at *s into v, returns false for an empty field */
+static bool csv_field(trace_csv const* const tc, char** s, int64_t* v) {
+        char* c = *s;
+        while (*c == ' ' || *c == '\t') {
+                c++;
+        }
+        bool neg = *c == '-';
+        c += neg;
+        bool digits = isdigit((unsigned char)*c);
+        uint64_t u = 0;
+        while (isdigit((unsigned char)*c)) {
+                u = 10 * u + (uint64_t)(*c++ - '0');
+        }
+        while (*c == ' ' || *c == '\t' || *c == '\r') {
+                c++;
+        }
+        if ((neg && !digits) || (*c != ',' && *c != '\n')) {
+                csv_malformed(tc);  // GCOVR_EXCL_LINE
+        }
+        *v = neg ? -(int64_t)u : (int64_t)u;
+        *s = c + (*c == ',');
+        return digits;
+}
+
+/* Returns the next line which is neither empty nor the header */
+static char* csv_record(trace_csv* tc) {
+        char* s;
+        while ((s = csv_line(tc))) {
+                tc->line++;
+                char* c = s;
+                while (*c == ' ' || *c == '\t' || *c == '\r') {
+                        c++;
+                }
+                bool header = tc->line == 1 && *c != '-' &&
+                              !isdigit((unsigned char)*c);
+                if (*c != '\n' && !header) {
+                        return s;
+                }
+        }
+        return NULL;
+}
+
+job* trace_csv_next(trace_csv* tc) {
+        char* s = csv_record(tc);
+        if (!s) {
+                return NULL;
+        }
+        int64_t v[TRACE_FIELDS];
+        bool given[TRACE_FIELDS];
+        for (int i = 0; i < TRACE_FIELDS; i++) {
+                given[i] = csv_field(tc, &s, v + i);
+        }
+        int k = given[0] ? ts_get_pos_by_id(tc->tsy, v[0]) : -1;
+        if (*s != '\n' || k < 0 || !given[1] || !given[4] || v[4] <= 0 ||
+            v[1] < tc->prev) {
+                csv_malformed(tc);  // GCOVR_EXCL_LINE
+        }
+        tc->prev = v[1];
+        if (!given[2]) {
+                v[2] = v[4] + 1;
+        }
+        if (!given[3]) {
+                v[3] = v[1] + tc->p->reldeads[k];
+        }
+        job* j = job_init(v[0], v[1], v[2], v[3], v[4]);
+        job_set_taskpos(j, k);
+        return j;
+}
+
+void trace_csv_skip(trace_csv* tc, uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+                job* j = trace_csv_next(tc);
+                if (!j) {
+                        return;
+                }
+                job_free(j);
+        }
+}
@@ -7,23 +7,43 @@ This software is distributed without any warranty.
 You should have received a copy of the CC0 Public Domain Dedication along with
 this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
 */
+#define _POSIX_C_SOURCE 200112L  // posix_memalign
 #include "ts.h"
 #include <assert.h>
 #include <errno.h>
+#include <float.h>
 #include <inttypes.h>
 #include <stdlib.h>
 #include <string.h>
 #include "dump.h"
-#include "json.h"
 #include "rnd.h"
 #include "selist.h"
 #include "stats.h"
 #include "task.h"
 
+/*
+ * Tasks are kept in a list in order of definition and, once read, in an array
+ * indexed by position. Task ids map to positions by a direct table if the ids
+ * are dense enough, otherwise by an open addressing hash table.
+ */
 struct ts {
         struct selist* l;
+        task** tasks;
+        int n;
+
+        TASK_INT idmin;
+        int* direct;  // position of id idmin + i or -1
+        size_t range;
+
+        TASK_INT* hkeys;
+        int* hpos;  // position of id hkeys[i] or -1 if slot is empty
+        size_t hmask;
+
+        ts_params params;
 };
 
+#define TS_CACHELINE 64
+
 ts* ts_init() {
         ts* tsy = calloc(1, sizeof(ts));
         if (tsy) {
@@ -35,24 +55,178 @@ ts* ts_init() {
         }  // GCOVR_EXCL_STOP
 }
 
+static inline size_t hash_id(TASK_INT const id, size_t const mask) {
+        // Fibonacci hashing, the upper bits are mixed best
+        return (size_t)(((uint64_t)id * UINT64_C(0x9E3779B97F4A7C15)) >> 32) &
+               mask;
+}
+
+static int index_lookup(ts const* const tsy, TASK_INT const id) {
+        if (tsy->direct) {
+                // Unsigned difference is out of range for ids below idmin
+                size_t i = (uint64_t)id - (uint64_t)tsy->idmin;
+                return i < tsy->range ? tsy->direct[i] : -1;
+        }
+        if (!tsy->hpos) {
+                return -1;
+        }
+        for (size_t i = hash_id(id, tsy->hmask);; i = (i + 1) & tsy->hmask) {
+                if (tsy->hpos[i] < 0 || tsy->hkeys[i] == id) {
+                        return tsy->hpos[i];
+                }
+        }
+}
+
+static void index_free(ts* const tsy) {
+        free(tsy->tasks);
+        free(tsy->direct);
+        free(tsy->hkeys);
+        free(tsy->hpos);
+        tsy->tasks = NULL;
+        tsy->direct = NULL;
+        tsy->hkeys = NULL;
+        tsy->hpos = NULL;
+}
+
+static void index_build(ts* const tsy) {
+        index_free(tsy);
+        int n = tsy->n = selist_length(tsy->l);
+        tsy->tasks = calloc(n ? n : 1, sizeof(task*));
+        if (!tsy->tasks) {  // GCOVR_EXCL_START
+                fprintf(stderr, "error allocating memory for tasksystem: %s\n",
+                        strerror(errno));
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        TASK_INT idmin = 0;
+        TASK_INT idmax = 0;
+        struct selist* it = tsy->l;
+        int i = 0;
+        for (int k = 0; k < n; k++, selist_advance(&it, &i, 1)) {
+                task* t = tsy->tasks[k] = selist_get(it, i);
+                TASK_INT id = task_get_id(t);
+                idmin = (!k || id < idmin) ? id : idmin;
+                idmax = (!k || id > idmax) ? id : idmax;
+        }
+
+        uint64_t range = (uint64_t)idmax - (uint64_t)idmin + 1;
+        if (n && range <= (uint64_t)TS_INDEX_DIRECT_FACTOR * n) {
+                tsy->idmin = idmin;
+                tsy->range = range;
+                tsy->direct = malloc(range * sizeof(int));
+                if (!tsy->direct) {  // GCOVR_EXCL_START
+                        fprintf(stderr,
+                                "error allocating memory for tasksystem: %s\n",
+                                strerror(errno));
+                        exit(EXIT_FAILURE);
+                }  // GCOVR_EXCL_STOP
+                for (size_t i = 0; i < range; i++) {
+                        tsy->direct[i] = -1;
+                }
+                for (int k = n - 1; k >= 0; k--) {  // first definition wins
+                        TASK_INT id = task_get_id(tsy->tasks[k]);
+                        tsy->direct[(uint64_t)id - (uint64_t)idmin] = k;
+                }
+                return;
+        }
+
+        size_t size = 2;  // keep load factor at most 1/2
+        while (size < 2 * (size_t)n) {
+                size *= 2;
+        }
+        tsy->hmask = size - 1;
+        tsy->hkeys = calloc(size, sizeof(TASK_INT));
+        tsy->hpos = malloc(size * sizeof(int));
+        if (!tsy->hkeys || !tsy->hpos) {  // GCOVR_EXCL_START
+                fprintf(stderr, "error allocating memory for tasksystem: %s\n",
+                        strerror(errno));
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        for (size_t i = 0; i < size; i++) {
+                tsy->hpos[i] = -1;
+        }
+        for (int k = 0; k < n; k++) {
+                TASK_INT id = task_get_id(tsy->tasks[k]);
+                size_t i = hash_id(id, tsy->hmask);
+                while (tsy->hpos[i] >= 0 && tsy->hkeys[i] != id) {
+                        i = (i + 1) & tsy->hmask;
+                }
+                if (tsy->hpos[i] < 0) {  // first definition wins
+                        tsy->hkeys[i] = id;
+                        tsy->hpos[i] = k;
+                }
+        }
+}
+
+static void* params_column(int const n, size_t const size) {
+        void* col = NULL;
+        // Columns are never empty to tell allocation failure from no tasks
+        if (posix_memalign(&col, TS_CACHELINE, (n ? n : 1) * size)) {
+                // GCOVR_EXCL_START
+                fprintf(stderr, "error allocating memory for tasksystem: %s\n",
+                        strerror(errno));
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        return col;
+}
+
+static void params_free(ts_params* const p) {
+        free(p->ids);
+        free(p->periods);
+        free(p->reldeads);
+        for (int i = 0; i < TASK_NUM_COMP; i++) {
+                free(p->comp[i]);
+        }
+        for (int i = 0; i < TASK_NUM_PROB; i++) {
+                free(p->prob[i]);
+        }
+        free(p->beta);
+        *p = (ts_params){0};
+}
+
+static void params_build(ts* const tsy) {
+        ts_params* p = &tsy->params;
+        params_free(p);
+        int n = p->n = tsy->n;
+        p->ids = params_column(n, sizeof(TASK_INT));
+        p->periods = params_column(n, sizeof(TASK_INT));
+        p->reldeads = params_column(n, sizeof(TASK_INT));
+        for (int i = 0; i < TASK_NUM_COMP; i++) {
+                p->comp[i] = params_column(n, sizeof(TASK_INT));
+        }
+        for (int i = 0; i < TASK_NUM_PROB; i++) {
+                p->prob[i] = params_column(n, sizeof(float));
+        }
+        p->beta = params_column(n, sizeof(float));
+        for (int k = 0; k < n; k++) {
+                task* t = tsy->tasks[k];
+                p->ids[k] = task_get_id(t);
+                p->periods[k] = task_get_period(t);
+                p->reldeads[k] = task_get_reldead(t);
+                for (int i = 0; i < TASK_NUM_COMP; i++) {
+                        p->comp[i][k] = task_get_comp(t, i);
+                }
+                for (int i = 0; i < TASK_NUM_PROB; i++) {
+                        p->prob[i][k] = task_get_prob(t, i);
+                }
+                p->beta[k] = task_get_beta(t);
+        }
+}
+
+static void free_task(void* t) {
+        task_free(t);
+}
+
 void ts_free(ts* tsy) {
-        struct selist** l = &(tsy->l);
-        do {
-                task* t = selist_pop(l);
-                if (t) {
-                        task_free(t);
-                        t = NULL;
-                }
-        } while (!selist_empty(*l));
-        selist_free(*l);
+        selist_foreach(tsy->l, free_task);
+        selist_free(tsy->l);
+        index_free(tsy);
+        params_free(&tsy->params);
         free(tsy);
 }
 
 task* ts_get_by_pos(ts const* const tsy, int const pos) {
-        struct selist* l = tsy->l;
-        task* t = selist_get(l, pos);
-        if (t) {
-                return t;
+        if (pos >= 0 && pos < tsy->n) {
+                return tsy->tasks[pos];
         } else {  // GCOVR_EXCL_START
                 fprintf(stderr, "tasksystem pos. error: task %d not found\n",
                         pos);
@@ -61,17 +235,9 @@ task* ts_get_by_pos(ts const* const tsy, int const pos) {
 }
 
 task* ts_get_by_id(ts const* const tsy, TASK_INT const id) {
-        struct selist* l = tsy->l;
-        int n = selist_length(l);
-
-        task* t;
-        for (int k = 0; k < n; k++) {
-                t = selist_get(l, k);
-                if (t) {
-                        if (task_get_id(t) == id) {
-                                return t;
-                        }
-                }
+        int k = index_lookup(tsy, id);
+        if (k >= 0) {
+                return tsy->tasks[k];
         }
         // GCOVR_EXCL_START
         fprintf(stderr, "tasksystem key error\n");
@@ -80,18 +246,8 @@ task* ts_get_by_id(ts const* const tsy, TASK_INT const id) {
 }
 
 int ts_get_pos_by_id(ts const* const tsy, TASK_INT const taskid) {
-        task* t;
-        int k = 0;
-        // Without the (redundant?) assignment to t gcc complaints about maybe
-        // unitialized on -O2
-        t = ts_get_by_pos(tsy, k);
-        for (k = 0; k < ts_length(tsy); k++) {
-                t = ts_get_by_pos(tsy, k);
-                if (task_get_id(t) == taskid) {
-                        break;
-                }
-        }
-        if (taskid != task_get_id(t)) {  // GCOVR_EXCL_START
+        int k = index_lookup(tsy, taskid);
+        if (k < 0) {  // GCOVR_EXCL_START
                 fprintf(stderr, "task id not found\n");
                 exit(EXIT_FAILURE);
         }  // GCOVR_EXCL_STOP
@@ -99,56 +255,175 @@ int ts_get_pos_by_id(ts const* const tsy, TASK_INT const taskid) {
 }
 
 int ts_length(ts const* const tsy) {
-        struct selist* l = tsy->l;
-        return selist_length(l);
+        return tsy->n;
 }
 
-static void selist_to_ts(ts* tsy, struct selist** l) {
-        /* At least some sanity checking... */
-        int len = selist_length(*l);
-        if (len % TASK_NUM_PARAM) {  // GCOVR_EXCL_START
-                fprintf(stderr,
-                        "task system ill defined: json contains %d values\n",
-                        len);
-                exit(EXIT_FAILURE);
-        }  // GCOVR_EXCL_STOP
-        int i = 0;
-        while (i < selist_length(*l)) {
-                intmax_t* id = selist_get(*l, i++);
-                intmax_t* period = selist_get(*l, i++);
-                intmax_t* reldead = selist_get(*l, i++);
+ts_params const* ts_get_params(ts const* const tsy) {
+        return &tsy->params;
+}
 
-                task* t = task_init();
-                task_set_period(t, *period);
-                task_set_reldead(t, *reldead);
-                task_set_id(t, *id);
+/* FNV-1a, 64 bit */
+static uint64_t hash_bytes(uint64_t h, void const* const data, size_t len) {
+        unsigned char const* b = data;
+        for (size_t i = 0; i < len; i++) {
+                h = (h ^ b[i]) * UINT64_C(0x100000001b3);
+        }
+        return h;
+}
+
+uint64_t ts_hash(ts const* const tsy) {
+        ts_params const* p = &tsy->params;
+        size_t ints = p->n * sizeof(TASK_INT);
+        size_t floats = p->n * sizeof(float);
+        uint64_t h = UINT64_C(0xcbf29ce484222325);
+        h = hash_bytes(h, p->ids, ints);
+        h = hash_bytes(h, p->periods, ints);
+        h = hash_bytes(h, p->reldeads, ints);
+        for (int i = 0; i < TASK_NUM_COMP; i++) {
+                h = hash_bytes(h, p->comp[i], ints);
+        }
+        for (int i = 0; i < TASK_NUM_PROB; i++) {
+                h = hash_bytes(h, p->prob[i], floats);
+        }
+        return hash_bytes(h, p->beta, floats);
+}
+
+/* Append a task to the list, returns the new last node */
+static struct selist* push_task(ts* tsy,
+                                struct selist* tail,
+                                TASK_INT const id,
+                                TASK_INT const period,
+                                TASK_INT const reldead,
+                                TASK_INT const* const comp,
+                                float const* const prob,
+                                float const beta) {
+        task* t = task_init();
+        task_set_period(t, period);
+        task_set_reldead(t, reldead);
+        task_set_id(t, id);
+        for (int j = 0; j < TASK_NUM_COMP; j++) {
+                task_set_comp(t, comp[j], j);
+        }
+        for (int j = 0; j < TASK_NUM_PROB; j++) {
+                task_set_prob(t, prob[j], j);
+        }
+        task_set_beta(t, beta);
+        return selist_push(tail ? &tail : &(tsy->l), t);
+}
 
+/* Read tasks up to the end of input, false with the id of the first task
+ * missing parameters in @p bad */
+static bool read_tasks(ts* tsy, dump_reader* r, intmax_t* bad) {
+        // Push to the last node of the list instead of walking the list
+        struct selist* tail = tsy->l;
+        intmax_t id;
+        while (dump_reader_int(r, &id)) {
+                intmax_t period;
+                intmax_t reldead;
+                intmax_t comp[TASK_NUM_COMP];
+                TASK_INT c[TASK_NUM_COMP];
+                float prob[TASK_NUM_PROB];
+                float beta;
+                bool ok = dump_reader_int(r, &period) &&
+                          dump_reader_int(r, &reldead);
                 for (int j = 0; j < TASK_NUM_COMP; j++) {
-                        task_set_comp(t, *(intmax_t*)selist_get(*l, i++), j);
+                        ok = ok && dump_reader_int(r, comp + j);
+                        c[j] = comp[j];
                 }
-
                 for (int j = 0; j < TASK_NUM_PROB; j++) {
-                        task_set_prob(t, *(float*)selist_get(*l, i++), j);
+                        ok = ok && dump_reader_float(r, prob + j);
                 }
-
-                task_set_beta(t, *(float*)selist_get(*l, i++));
-
-                selist_push(&(tsy->l), t);
+                ok = ok && dump_reader_float(r, &beta);
+                /* At least some sanity checking... */
+                if (!ok) {
+                        *bad = id;
+                        return false;
+                }
+                tail = push_task(tsy, tail, id, period, reldead, c, prob, beta);
         }
+        return true;
 }
 
 void ts_read_json(ts* tsy, FILE* stream) {
-        struct selist* l = (void*)0;
+        dump_reader r;
+        intmax_t bad;
+        dump_reader_init(&r, stream);
+        if (!read_tasks(tsy, &r, &bad)) {  // GCOVR_EXCL_START
+                fprintf(stderr,
+                        "task system ill defined: task %" PRIdMAX
+                        " misses parameters\n",
+                        bad);
+                exit(EXIT_FAILURE);
+        }  // GCOVR_EXCL_STOP
+        dump_reader_free(&r);
 
-        json_parser* parser = dump_read_json_init(&l);
-        dump_read_json_parse(parser, stream);
-        dump_read_json_free(parser);
+        index_build(tsy);
+        params_build(tsy);
+}
+
+char const* ts_parse_json(ts* tsy, char const* json, size_t len) {
+        dump_reader r;
+        intmax_t bad;
+        dump_reader_init_mem(&r, json, len);
+        bool ok = read_tasks(tsy, &r, &bad);
+        char const* error = dump_reader_error(&r);
+        dump_reader_free(&r);
 
-        selist_to_ts(tsy, &l);
+        index_build(tsy);
+        params_build(tsy);
+        if (error) {
+                return error;
+        }
+        return ok ? NULL : "task misses parameters";
+}
 
-        while (!selist_empty(l)) {
-                intmax_t* val = selist_pop(&l);
-                free(val);
+void ts_read_params(ts* tsy, ts_params const* p) {
+        struct selist* tail = tsy->l;
+        for (int k = 0; k < p->n; k++) {
+                TASK_INT comp[TASK_NUM_COMP];
+                float prob[TASK_NUM_PROB];
+                for (int j = 0; j < TASK_NUM_COMP; j++) {
+                        comp[j] = p->comp[j][k];
+                }
+                for (int j = 0; j < TASK_NUM_PROB; j++) {
+                        prob[j] = p->prob[j][k];
+                }
+                tail = push_task(tsy, tail, p->ids[k], p->periods[k],
+                                 p->reldeads[k], comp, prob, p->beta[k]);
+        }
+
+        index_build(tsy);
+        params_build(tsy);
+}
+
+char const* ts_check(ts const* const tsy) {
+        ts_params const* p = &tsy->params;
+        for (int k = 0; k < p->n; k++) {
+                float p0 = p->prob[0][k];
+                float p1 = p->prob[1][k];
+                if (p->periods[k] <= 0) {
+                        return "period not positive";
+                }
+                if (p->reldeads[k] <= 0) {
+                        return "relative deadline not positive";
+                }
+                if (!(p0 >= 0.0f && p1 >= 0.0f &&
+                      p0 + p1 <= 1.0f + FLT_EPSILON)) {
+                        return "probabilities out of range";
+                }
+                if (!(p->beta[k] >= 0.0f)) {
+                        return "interarrival factor negative";
+                }
+                // Computation times are drawn from segments of nonzero
+                // probability, the last one taking the remaining probability
+                float segprob[3] = {p0, p1, 1.0f - p0 - p1};
+                for (int s = 0; s < 3; s++) {
+                        TASK_INT clow = p->comp[2 * s][k];
+                        TASK_INT chigh = p->comp[2 * s + 1][k];
+                        if (segprob[s] > 0.0f && (clow < 1 || chigh < clow)) {
+                                return "computation times out of range";
+                        }
+                }
         }
-        selist_free(l);
+        return NULL;
 }
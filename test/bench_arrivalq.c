@@ -0,0 +1,79 @@
+/*
+thready - A lightweight and fast scheduling simulator
+Written in 2019 by Robert Schmidt <rschmidt@uni-bremen.de>
+To the extent possible under law, the author(s) have dedicated all copyright and
+related and neighboring rights to this software to the public domain worldwide.
+This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with
+this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+/**
+ * @file bench_arrivalq.c
+ * @author Robert Schmidt
+ * @brief Microbenchmark of job queues holding the pending job arrivals.
+ *
+ * Each of n tasks has exactly one pending job. The earliest job is removed and
+ * replaced by the next job of its task arriving a period plus a random
+ * interarrival time later, like in the job generator. Prints one CSV line per
+ * queue and task count.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "job.h"
+#include "jobq.h"
+#include "rnd.h"
+#include "stats.h"
+
+#define OPERATIONS 4000000
+
+static double hold(jobq_kind const kind, int const tasks) {
+        rnd_pcg_t pcg;
+        rnd_pcg_t* pcgp = &pcg;
+        rnd_pcg_seed(pcgp, 1);
+        JOB_INT* period = bench_calloc(tasks, sizeof(JOB_INT));
+        jobq* jq = jobq_init_as(kind, NULL);
+        for (int i = 0; i < tasks; i++) {
+                // Log-uniform periods between 10 and 10000
+                period[i] = expf(uniformf(&pcgp, logf(10), logf(10000)));
+                jobq_insert_by(jq, job_init(i, 0, 0, 0, 0), job_get_starttime);
+        }
+
+        double start = bench_seconds();
+        for (int k = 0; k < OPERATIONS; k++) {
+                job* j = jobq_pop(jq);
+                JOB_INT i = job_get_taskid(j);
+                JOB_INT rho = exponential(&pcgp, 0.25f) * period[i];
+                JOB_INT next = job_get_starttime(j) + period[i] + rho;
+                job_free(j);
+                jobq_insert_by(jq, job_init(i, next, 0, 0, 0),
+                               job_get_starttime);
+        }
+        double elapsed = bench_seconds() - start;
+
+        jobq_free(jq);
+        free(period);
+        return elapsed;
+}
+
+int main(void) {
+        int const tasks[] = {3, 10, 100, 1000, 10000, 100000};
+        struct {
+                char const* name;
+                jobq_kind kind;
+        } const queues[] = {{"heap", JOBQ_HEAP}, {"calendar", JOBQ_CALENDAR}};
+
+        printf("queue,tasks,operations,seconds,operations_per_second\n");
+        for (size_t q = 0; q < sizeof(queues) / sizeof(*queues); q++) {
+                for (size_t t = 0; t < sizeof(tasks) / sizeof(*tasks); t++) {
+                        double s = hold(queues[q].kind, tasks[t]);
+                        printf("%s,%d,%d,%f,%f\n", queues[q].name, tasks[t],
+                               OPERATIONS, s, OPERATIONS / s);
+                }
+        }
+        job_pool_free();
+        return EXIT_SUCCESS;
+}
@@ -0,0 +1,119 @@
+/*
+thready - A lightweight and fast scheduling simulator
+Written in 2019 by Robert Schmidt <rschmidt@uni-bremen.de>
+To the extent possible under law, the author(s) have dedicated all copyright and
+related and neighboring rights to this software to the public domain worldwide.
+This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with
+this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+/**
+ * @file bench_jobgen.c
+ * @author Robert Schmidt
+ * @brief Microbenchmark of the job generator.
+ *
+ * Generates the job arrivals of task systems of n sporadic tasks by
+ * @c jobgen_rise, for each queue of pending arrivals and source of random
+ * numbers. Prints one CSV line per queue, random numbers and task count.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "job.h"
+#include "jobgen.h"
+#include "rnd.h"
+#include "stats.h"
+#include "ts.h"
+
+#define RISES 4000000
+
+/* Task system of n tasks with log-uniform periods between 10 and 10000,
+ * execution times of up to a tenth of the period and interarrival times */
+static ts* tasksystem(int const tasks) {
+        rnd_pcg_t pcg;
+        rnd_pcg_t* pcgp = &pcg;
+        rnd_pcg_seed(pcgp, 1);
+        TASK_INT* ints = bench_calloc((3 + TASK_NUM_COMP) * (size_t)tasks,
+                                      sizeof(TASK_INT));
+        float* floats = bench_calloc((1 + TASK_NUM_PROB) * (size_t)tasks,
+                                     sizeof(float));
+        ts_params p;
+        p.n = tasks;
+        p.ids = ints;
+        p.periods = ints + tasks;
+        p.reldeads = ints + 2 * tasks;
+        for (int j = 0; j < TASK_NUM_COMP; j++) {
+                p.comp[j] = ints + (3 + j) * tasks;
+        }
+        for (int j = 0; j < TASK_NUM_PROB; j++) {
+                p.prob[j] = floats + j * tasks;
+        }
+        p.beta = floats + TASK_NUM_PROB * tasks;
+        for (int i = 0; i < tasks; i++) {
+                p.ids[i] = i;
+                p.periods[i] = expf(uniformf(&pcgp, logf(10), logf(10000)));
+                p.reldeads[i] = p.periods[i];
+                p.comp[0][i] = 1;
+                p.comp[1][i] = 1 + p.periods[i] / 20;
+                p.comp[2][i] = 1 + p.periods[i] / 20;
+                p.comp[3][i] = 1 + p.periods[i] / 10;
+                p.prob[0][i] = 0.9f;
+                p.prob[1][i] = 0.1f;
+                p.beta[i] = 0.25f;
+        }
+        ts* tsy = ts_init();
+        ts_read_params(tsy, &p);
+        free(ints);
+        free(floats);
+        return tsy;
+}
+
+static double rise(ts const* const tsy,
+                   jobgen_queue const queue,
+                   jobgen_rng const rng) {
+        jobgen* jg = jobgen_init(tsy, 1, true, queue, rng);
+        double start = bench_seconds();
+        for (int k = 0; k < RISES; k++) {
+                job_free(jobgen_rise(jg));
+        }
+        double elapsed = bench_seconds() - start;
+        jobgen_free(jg);
+        return elapsed;
+}
+
+int main(void) {
+        int const tasks[] = {10, 100, 1000, 10000, 100000};
+        struct {
+                char const* name;
+                jobgen_queue queue;
+        } const queues[] = {{"array", JOBGEN_ARRAY},
+                            {"heap", JOBGEN_HEAP},
+                            {"calendar", JOBGEN_CALENDAR}};
+        struct {
+                char const* name;
+                jobgen_rng rng;
+        } const rngs[] = {{"shared", JOBGEN_RNG_SHARED},
+                          {"batch", JOBGEN_RNG_BATCH},
+                          {"counter", JOBGEN_RNG_COUNTER}};
+
+        printf("queue,rng,tasks,jobs,seconds,jobs_per_second\n");
+        for (size_t t = 0; t < sizeof(tasks) / sizeof(*tasks); t++) {
+                ts* tsy = tasksystem(tasks[t]);
+                for (size_t q = 0; q < sizeof(queues) / sizeof(*queues); q++) {
+                        for (size_t r = 0; r < sizeof(rngs) / sizeof(*rngs);
+                             r++) {
+                                double s =
+                                    rise(tsy, queues[q].queue, rngs[r].rng);
+                                printf("%s,%s,%d,%d,%f,%f\n", queues[q].name,
+                                       rngs[r].name, tasks[t], RISES, s,
+                                       RISES / s);
+                        }
+                }
+                ts_free(tsy);
+        }
+        job_pool_free();
+        return EXIT_SUCCESS;
+}
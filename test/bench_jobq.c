@@ -0,0 +1,151 @@
+/*
+thready - A lightweight and fast scheduling simulator
+Written in 2019 by Robert Schmidt <rschmidt@uni-bremen.de>
+To the extent possible under law, the author(s) have dedicated all copyright and
+related and neighboring rights to this software to the public domain worldwide.
+This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with
+this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+/**
+ * @file bench_jobq.c
+ * @author Robert Schmidt
+ * @brief Microbenchmark of job queues holding the released jobs.
+ *
+ * Jobs of n tasks are queued by deadline, and the deadlines of the jobs of a
+ * task grow by its period plus a random delay, like in the scheduler queue.
+ * In the steady pattern each task has one queued job, and the job with the
+ * earliest deadline is popped and replaced by the next job of its task. In
+ * the growing pattern two jobs are inserted per job popped, like the backlog
+ * of an overloaded processor. Prints one CSV line per queue, pattern and task
+ * count. Built with @c -DJOBQ_PQUEUE as @c bench_jobq_pqueue, the heap is the
+ * reference queue on top of pqueue.
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "job.h"
+#include "jobq.h"
+#include "rnd.h"
+#include "stats.h"
+#include "ts.h"
+
+#define OPERATIONS 4000000
+
+#ifdef JOBQ_PQUEUE
+#define HEAP "pqueue"
+#else
+#define HEAP "heap"
+#endif
+
+/* Task system of n tasks with log-uniform periods between 10 and 10000 */
+static ts* tasksystem(int const tasks, rnd_pcg_t** pcg) {
+        TASK_INT* ints = bench_calloc((3 + TASK_NUM_COMP) * (size_t)tasks,
+                                      sizeof(TASK_INT));
+        float* floats = bench_calloc((1 + TASK_NUM_PROB) * (size_t)tasks,
+                                     sizeof(float));
+        ts_params p;
+        p.n = tasks;
+        p.ids = ints;
+        p.periods = ints + tasks;
+        p.reldeads = ints + 2 * tasks;
+        for (int j = 0; j < TASK_NUM_COMP; j++) {
+                p.comp[j] = ints + (3 + j) * tasks;
+        }
+        for (int j = 0; j < TASK_NUM_PROB; j++) {
+                p.prob[j] = floats + j * tasks;
+        }
+        p.beta = floats + TASK_NUM_PROB * tasks;
+        for (int i = 0; i < tasks; i++) {
+                p.ids[i] = i;
+                p.periods[i] = expf(uniformf(pcg, logf(10), logf(10000)));
+                p.reldeads[i] = p.periods[i];
+                p.comp[0][i] = 1;
+                p.comp[1][i] = 1;
+                p.prob[0][i] = 1.0f;
+        }
+        ts* tsy = ts_init();
+        ts_read_params(tsy, &p);
+        free(ints);
+        free(floats);
+        return tsy;
+}
+
+/* Queue the next job of task i, whose last deadline is kept in deadline */
+static void next(jobq* jq,
+                 ts const* tsy,
+                 JOB_INT* deadline,
+                 int const i,
+                 rnd_pcg_t** pcg) {
+        JOB_INT const period = ts_get_params(tsy)->periods[i];
+        deadline[i] += period + exponential(pcg, 0.25f) * period;
+        jobq_insert_by(jq, job_init(i, 0, 0, deadline[i], 1),
+                       job_get_deadline);
+}
+
+static double run(jobq_kind const kind,
+                  bool const growing,
+                  int const tasks,
+                  long* const operations) {
+        rnd_pcg_t pcg;
+        rnd_pcg_t* pcgp = &pcg;
+        rnd_pcg_seed(pcgp, 1);
+        ts* tsy = tasksystem(tasks, &pcgp);
+        JOB_INT* deadline = bench_calloc(tasks, sizeof(JOB_INT));
+        jobq* jq = jobq_init_as(kind, tsy);
+        for (int i = 0; i < tasks; i++) {
+                next(jq, tsy, deadline, i, &pcgp);
+        }
+
+        int rr = 0;  // Task of the additional job when growing
+        double start = bench_seconds();
+        for (int k = 0; k < OPERATIONS / 2; k++) {
+                job* j = jobq_pop(jq);
+                int const i = job_get_taskid(j);
+                job_free(j);
+                next(jq, tsy, deadline, i, &pcgp);
+                if (growing) {
+                        next(jq, tsy, deadline, rr, &pcgp);
+                        rr = rr + 1 < tasks ? rr + 1 : 0;
+                }
+        }
+        double elapsed = bench_seconds() - start;
+        *operations = (OPERATIONS / 2) * (growing ? 3L : 2L);
+
+        jobq_free(jq);
+        free(deadline);
+        ts_free(tsy);
+        return elapsed;
+}
+
+int main(void) {
+        int const tasks[] = {10, 100, 1000, 10000, 100000};
+        struct {
+                char const* name;
+                jobq_kind kind;
+        } const queues[] = {{HEAP, JOBQ_HEAP},
+                            {"pertask", JOBQ_PERTASK},
+                            {"calendar", JOBQ_CALENDAR}};
+
+        printf(
+            "queue,pattern,tasks,operations,seconds,operations_per_second\n");
+        for (size_t q = 0; q < sizeof(queues) / sizeof(*queues); q++) {
+                for (int growing = 0; growing < 2; growing++) {
+                        for (size_t t = 0; t < sizeof(tasks) / sizeof(*tasks);
+                             t++) {
+                                long ops;
+                                double s = run(queues[q].kind, growing,
+                                               tasks[t], &ops);
+                                printf("%s,%s,%d,%ld,%f,%f\n", queues[q].name,
+                                       growing ? "growing" : "steady", tasks[t],
+                                       ops, s, ops / s);
+                        }
+                }
+        }
+        job_pool_free();
+        return EXIT_SUCCESS;
+}
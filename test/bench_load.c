@@ -0,0 +1,197 @@
+/*
+thready - A lightweight and fast scheduling simulator
+Written in 2019 by Robert Schmidt <rschmidt@uni-bremen.de>
+To the extent possible under law, the author(s) have dedicated all copyright and
+related and neighboring rights to this software to the public domain worldwide.
+This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with
+this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+/**
+ * @file bench_load.c
+ * @author Robert Schmidt
+ * @brief Benchmark of loading large task systems and state dumps.
+ *
+ * Writes task systems of n tasks and the state of a simulation of these task
+ * systems as JSON state dump and binary checkpoint to temporary files, and
+ * measures writing and reading them back. The task system is read by the
+ * streaming loader and, for reference, by the former loader collecting all
+ * numbers in a list through the libjson callbacks. Prints one CSV line per
+ * file, loader, and task count.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "dump.h"
+#include "eventloop.h"
+#include "job.h"
+#include "jobgen.h"
+#include "json.h"
+#include "selist.h"
+#include "ts.h"
+
+#define LIST_MAXTASKS 10000  // the list loader is quadratic in the tasks
+
+static FILE* tmp(void) {
+        FILE* stream = tmpfile();
+        if (!stream) {
+                fprintf(stderr, "error creating file for benchmark\n");
+                exit(EXIT_FAILURE);
+        }
+        return stream;
+}
+
+static long bytes(FILE* stream) {
+        fseek(stream, 0, SEEK_END);
+        long len = ftell(stream);
+        rewind(stream);
+        return len;
+}
+
+/* Task system of n tasks with a utilization of about one half */
+static FILE* write_ts(int const tasks) {
+        FILE* stream = tmp();
+        fprintf(stream, "[\n");
+        for (int i = 0; i < tasks; i++) {
+                int period = 10 * tasks + 7 * i;
+                fprintf(stream,
+                        "[%d,%d,%d, 1,2, 0,0, 0,0, 1.0, 0.0, 0.25]%s\n", i,
+                        period, period, i + 1 < tasks ? "," : "");
+        }
+        fprintf(stream, "]\n");
+        fflush(stream);
+        rewind(stream);
+        return stream;
+}
+
+/* Append each number as value of its own allocation */
+static int callback_append(void* userdata,
+                           int type,
+                           const char* data,
+                           __attribute__((unused)) uint32_t length) {
+        struct selist** l = userdata;
+        errno = 0;
+        if (type == JSON_FLOAT) {
+                float* valf = bench_calloc(1, sizeof(float));
+                *valf = strtof(data, NULL);
+                selist_push(l, valf);
+        } else if (type == JSON_INT) {
+                intmax_t* vali = bench_calloc(1, sizeof(intmax_t));
+                *vali = strtoimax(data, NULL, 10);
+                selist_push(l, vali);
+        }
+        if (errno == ERANGE) {
+                fprintf(stderr, "error converting number for benchmark\n");
+                exit(EXIT_FAILURE);
+        }
+        return 0;
+}
+
+/* Former loader collecting all numbers in a list */
+static void read_ts_list(FILE* stream) {
+        struct selist* l = (void*)0;
+        json_parser parser;
+        json_config cfg = {0};
+        cfg.allow_yaml_comments = 1;
+        if (json_parser_init(&parser, &cfg, callback_append, &l)) {
+                fprintf(stderr, "error initializing json parser\n");
+                exit(EXIT_FAILURE);
+        }
+        char block[1024];
+        size_t len;
+        while ((len = fread(block, sizeof(char), sizeof(block), stream))) {
+                if (json_parser_string(&parser, block, len, NULL)) {
+                        fprintf(stderr, "error parsing json for benchmark\n");
+                        exit(EXIT_FAILURE);
+                }
+        }
+        json_parser_free(&parser);
+        while (!selist_empty(l)) {
+                free(selist_pop(&l));
+        }
+        selist_free(l);
+}
+
+static void report(char const* file,
+                   char const* loader,
+                   int const tasks,
+                   long const len,
+                   double const s) {
+        printf("%s,%s,%d,%ld,%f,%f\n", file, loader, tasks, len, s,
+               len / s / 1e6);
+}
+
+static void bench(int const tasks) {
+        FILE* stream = write_ts(tasks);
+        long len = bytes(stream);
+
+        double start;
+        if (tasks <= LIST_MAXTASKS) {
+                start = bench_seconds();
+                read_ts_list(stream);
+                report("tasksystem", "list", tasks, len,
+                       bench_seconds() - start);
+                rewind(stream);
+        }
+
+        ts* tsy = ts_init();
+        start = bench_seconds();
+        ts_read_json(tsy, stream);
+        report("tasksystem", "stream", tasks, len, bench_seconds() - start);
+        fclose(stream);
+
+        // State after all tasks released some jobs
+        jobgen* jg = jobgen_init(tsy, 1, true, JOBGEN_ARRAY, JOBGEN_RNG_SHARED);
+        eventloop* evl = eventloop_init(jg, true, false, JOBQ_HEAP);
+        eventloop_run(evl, 20 * tasks, 1, false);
+        FILE* json = tmp();
+        FILE* bin = tmp();
+        start = bench_seconds();
+        eventloop_dump(evl, json);
+        fflush(json);
+        double s = bench_seconds() - start;
+        report("dump", "json_write", tasks, bytes(json), s);
+        start = bench_seconds();
+        eventloop_dump_bin(evl, bin);
+        fflush(bin);
+        s = bench_seconds() - start;
+        report("dump", "bin_write", tasks, bytes(bin), s);
+        eventloop_free(evl);
+        jobgen_free(jg);
+
+        struct {
+                char const* name;
+                FILE* stream;
+                void (*read)(eventloop*, FILE*);
+        } const dumps[] = {{"json", json, eventloop_read_json},
+                           {"bin", bin, eventloop_read_bin}};
+        for (size_t d = 0; d < sizeof(dumps) / sizeof(*dumps); d++) {
+                len = bytes(dumps[d].stream);
+                jg = jobgen_init(tsy, 1, false, JOBGEN_ARRAY,
+                                 JOBGEN_RNG_SHARED);
+                evl = eventloop_init(jg, false, false, JOBQ_HEAP);
+                start = bench_seconds();
+                dumps[d].read(evl, dumps[d].stream);
+                report("dump", dumps[d].name, tasks, len,
+                       bench_seconds() - start);
+                eventloop_free(evl);
+                jobgen_free(jg);
+                fclose(dumps[d].stream);
+        }
+        ts_free(tsy);
+}
+
+int main(void) {
+        int const tasks[] = {1000, 10000, 100000};
+
+        printf("file,loader,tasks,bytes,seconds,megabytes_per_second\n");
+        for (size_t t = 0; t < sizeof(tasks) / sizeof(*tasks); t++) {
+                bench(tasks[t]);
+        }
+        job_pool_free();
+        return EXIT_SUCCESS;
+}
@@ -0,0 +1,162 @@
+/*
+thready - A lightweight and fast scheduling simulator
+Written in 2019 by Robert Schmidt <rschmidt@uni-bremen.de>
+To the extent possible under law, the author(s) have dedicated all copyright and
+related and neighboring rights to this software to the public domain worldwide.
+This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with
+this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+/**
+ * @file bench_scaling.c
+ * @author Robert Schmidt
+ * @brief Benchmark of the event loop by task count, utilization and
+ * interarrival parameter.
+ *
+ * Simulates task systems written by the generator of @c thready-gen for a
+ * matrix of task counts, total utilizations including overload, and
+ * interarrival parameters, once with the default queues and once with the
+ * queues meant for many tasks and large backlogs. Periods grow with the task
+ * count, such that budgets stay long enough for the utilization. Overloaded
+ * task systems get deadlines far beyond their periods, so the backlog grows
+ * instead of the simulation ending with the first deadline miss.
+ *
+ * Each task system is simulated until some million events in a process of its
+ * own, which prints one CSV line with the events per second, the greatest
+ * number of released jobs at once, and the peak resident set size in KiB.
+ */
+
+#define _POSIX_C_SOURCE 200809L  // fork
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "bench.h"
+#include "eventloop.h"
+#include "gen.h"
+#include "jobgen.h"
+#include "jobq.h"
+#include "ts.h"
+
+#define EVENTS 2000000
+#define OVERLOAD_DEADLINE 10000.0  // relative deadline over period
+
+typedef struct {
+        char const* name;
+        jobq_kind readyq;
+        jobgen_queue arrivalq;
+} setup;
+
+static ts* tasksystem(gen_config const* const c, double* const utilization) {
+        FILE* stream = tmpfile();
+        if (!stream) {
+                fprintf(stderr, "error creating file for benchmark\n");
+                exit(EXIT_FAILURE);
+        }
+        *utilization = gen_write_json(c, stream);
+        rewind(stream);
+        ts* tsy = ts_init();
+        ts_read_json(tsy, stream);
+        fclose(stream);
+        return tsy;
+}
+
+static void run(int const tasks,
+                double const utilization,
+                float const beta,
+                setup const* const s) {
+        gen_config c;
+        gen_config_default(&c);
+        c.n = tasks;
+        c.utilization = utilization;
+        c.method = GEN_RANDFIXEDSUM;
+        c.pmin = 100 * (TASK_INT)tasks;
+        c.pmax = 1000 * c.pmin;
+        c.beta = beta;
+        c.seed = 1;
+        if (utilization > 1.0) {
+                c.dmin = OVERLOAD_DEADLINE;
+                c.dmax = OVERLOAD_DEADLINE;
+        }
+        double achieved;
+        ts* tsy = tasksystem(&c, &achieved);
+        jobgen* jg =
+            jobgen_init(tsy, 1, true, s->arrivalq, JOBGEN_RNG_SHARED);
+        eventloop* evl = eventloop_init(jg, true, false, s->readyq);
+        eventloop_set_quiet(evl, true);
+
+        // Double the simulated time until enough events
+        eventloop_result r = EVL_OK;
+        JOB_INT breaktime = c.pmin;
+        double elapsed = 0.0;
+        while (r != EVL_DEADLINEMISS && eventloop_get_events(evl) < EVENTS) {
+                double const start = bench_seconds();
+                r = eventloop_run(evl, breaktime, 1, false);
+                elapsed += bench_seconds() - start;
+                breaktime *= 2;
+        }
+        EVL_INT const events = eventloop_get_events(evl);
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        printf("%d,%.2f,%.4f,%.2f,%s,%s,%" PRId64 ",%f,%f,%f,%zu,%ld\n", tasks,
+               utilization, achieved, beta, s->name,
+               r == EVL_DEADLINEMISS ? "deadlinemiss" : "ok", events, elapsed,
+               events / elapsed, elapsed * 1e9 / events,
+               eventloop_get_maxready(evl), usage.ru_maxrss);
+
+        eventloop_free(evl);
+        jobgen_free(jg);
+        ts_free(tsy);
+        job_pool_free();
+}
+
+/* Run in a process of its own to measure its peak memory */
+static void run_forked(int const tasks,
+                       double const utilization,
+                       float const beta,
+                       setup const* const s) {
+        pid_t const pid = fork();
+        if (pid < 0) {
+                fprintf(stderr, "error forking benchmark\n");
+                exit(EXIT_FAILURE);
+        }
+        if (!pid) {
+                run(tasks, utilization, beta, s);
+                fflush(stdout);
+                _exit(EXIT_SUCCESS);
+        }
+        int status;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status)) {
+                fprintf(stderr, "benchmark of %d tasks failed\n", tasks);
+                exit(EXIT_FAILURE);
+        }
+}
+
+int main(void) {
+        int const tasks[] = {3, 10, 100, 1000, 10000, 100000};
+        double const utilizations[] = {0.3, 0.6, 0.9, 1.0, 1.1, 1.2};
+        float const betas[] = {0.0f, 0.1f, 1.0f};
+        setup const setups[] = {{"heap-array", JOBQ_HEAP, JOBGEN_ARRAY},
+                                {"pertask-calendar", JOBQ_PERTASK,
+                                 JOBGEN_CALENDAR}};
+        size_t const ntasks = sizeof(tasks) / sizeof(*tasks);
+        size_t const nutil = sizeof(utilizations) / sizeof(*utilizations);
+        size_t const nbeta = sizeof(betas) / sizeof(*betas);
+
+        printf(
+            "tasks,utilization,achieved,beta,queues,result,events,seconds,"
+            "events_per_second,ns_per_event,max_ready,peak_rss_kib\n");
+        fflush(stdout);  // before forking
+        for (size_t s = 0; s < sizeof(setups) / sizeof(*setups); s++) {
+                for (size_t i = 0; i < ntasks * nutil * nbeta; i++) {
+                        run_forked(tasks[i / (nutil * nbeta)],
+                                   utilizations[i / nbeta % nutil],
+                                   betas[i % nbeta], setups + s);
+                }
+        }
+        return EXIT_SUCCESS;
+}
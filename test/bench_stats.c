@@ -0,0 +1,93 @@
+/*
+thready - A lightweight and fast scheduling simulator
+Written in 2019 by Robert Schmidt <rschmidt@uni-bremen.de>
+To the extent possible under law, the author(s) have dedicated all copyright and
+related and neighboring rights to this software to the public domain worldwide.
+This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with
+this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+/**
+ * @file bench_stats.c
+ * @author Robert Schmidt
+ * @brief Microbenchmark of drawing random variates.
+ *
+ * Draws variates one by one, as the shared random stream of the job generator
+ * does, and in blocks by the vectorized kernels of the batch and counter
+ * based random streams. Prints one CSV line per kernel.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "rnd.h"
+#include "stats.h"
+
+#define VARIATES (3 << 22)  // whole blocks of all kernels
+#define BLOCK 1024
+
+/* Sum of the variates, printed so that they are not optimized away */
+static double sink;
+
+static void report(char const* kernel, double const s) {
+        printf("%s,%d,%f,%f\n", kernel, VARIATES, s, VARIATES / s);
+}
+
+int main(void) {
+        rnd_pcg_t pcg;
+        rnd_pcg_t* pcgp = &pcg;
+        rnd_pcg_seed(pcgp, 1);
+        uint32_t const key[2] = {1, 0};
+        float const bounds[6] = {1.0f, 2.0f, 2.0f, 5.0f, 5.0f, 10.0f};
+        float* u = bench_calloc(3 * BLOCK, sizeof(float));
+        float* dst = bench_calloc(BLOCK, sizeof(float));
+
+        printf("kernel,variates,seconds,variates_per_second\n");
+        double start = bench_seconds();
+        for (int k = 0; k < VARIATES; k++) {
+                sink += uniformf(&pcgp, 0.0f, 1.0f);
+        }
+        report("uniformf", bench_seconds() - start);
+
+        start = bench_seconds();
+        for (int k = 0; k < VARIATES; k++) {
+                sink += exponential(&pcgp, 0.25f);
+        }
+        report("exponential", bench_seconds() - start);
+
+        start = bench_seconds();
+        for (int k = 0; k < VARIATES; k += BLOCK) {
+                uniformf_fill(&pcgp, dst, BLOCK);
+                sink += dst[k % BLOCK];
+        }
+        report("uniformf_fill", bench_seconds() - start);
+
+        start = bench_seconds();
+        for (int k = 0; k < VARIATES; k += 3 * BLOCK) {
+                philox_fill(key, 0, k, u, BLOCK);
+                sink += u[k % BLOCK];
+        }
+        report("philox_fill", bench_seconds() - start);
+
+        uniformf_fill(&pcgp, u, 2 * BLOCK);
+        start = bench_seconds();
+        for (int k = 0; k < VARIATES; k += BLOCK) {
+                exponential_fill(u, 0.25f, dst, BLOCK);
+                sink += dst[k % BLOCK];
+        }
+        report("exponential_fill", bench_seconds() - start);
+
+        start = bench_seconds();
+        for (int k = 0; k < VARIATES; k += BLOCK) {
+                uniform3_fill(u, u + BLOCK, 0.5f, 0.3f, bounds, dst, BLOCK);
+                sink += dst[k % BLOCK];
+        }
+        report("uniform3_fill", bench_seconds() - start);
+
+        fprintf(stderr, "checksum %f\n", sink);
+        free(u);
+        free(dst);
+        return EXIT_SUCCESS;
+}
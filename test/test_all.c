@@ -7,6 +7,7 @@ This software is distributed without any warranty.
 You should have received a copy of the CC0 Public Domain Dedication along with
 this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
 */
+#define _POSIX_C_SOURCE 200112L  // pipe, fdopen
 #include <setjmp.h>
 #include <stdarg.h>
 #include <stddef.h>
@@ -15,15 +16,29 @@ this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
 #include <cmocka.h>
 
 #include <errno.h>
+#include <inttypes.h>
+#include <math.h>
 #include <stdbool.h>
+#include <string.h>
 
+#include "bench.h"
 #include "dump.h"
+#include "gen.h"
 #include "eventloop.h"
 #include "job.h"
 #include "jobgen.h"
 #include "jobq.h"
+#include "out.h"
+#include "replicate.h"
+#include "serve.h"
+#include "stats.h"
+#include "sweep.h"
 #include "task.h"
+#include "thready.h"
+#include "tourn.h"
+#include "trace.h"
 #include "ts.h"
+#include <unistd.h>
 
 extern int errno;
 
@@ -33,104 +48,105 @@ struct eventloopstate {
         eventloop* evl;
 };
 
-struct dumpstate {
-        void** src;
-        void** dst;
-        int n;
-};
-
-int setup_dumpstate(void** state) {
-        struct dumpstate* s = calloc(1, sizeof(struct dumpstate));
-        int n = 10;
-        s->n = n;
-        s->src = calloc(n, sizeof(void*));
-        s->dst = calloc(n, sizeof(void*));
-        if (s->src && s->dst) {
-                for (int i = 0; i < n; i++) {
-                        /* Set up two int* arrays, pointed data is i or 2*i */
-                        int* a = calloc(1, sizeof(int));
-                        int* b = calloc(1, sizeof(int));
-                        if (a && b) {
-                                *a = i;
-                                *b = 2 * i;
-                                *(s->src + i) = a;
-                                *(s->dst + i) = b;
-                        } else {
-                                return 1;
-                        }
-                }
-        } else {
-                return 1;
-        }
-        *state = s;
-        return 0;
-}
-
-int teardown_dumpstate(void** state) {
-        struct dumpstate* s = *state;
-        for (int i = 0; i < s->n; i++) {
-                free(*(s->src + i));
-                free(*(s->dst + i));
-        }
-        free(s->src);
-        free(s->dst);
-        free(s);
-        return 0;
+static char const reader_json[] =
+    "# comment\n"
+    "{\"a\": -3, \"s\\\"x\": \"q\\\"\",\n"
+    "\"b\" : [0.5, {\"c\": 7}, true, null],\n"
+    "\"long key exceeding the key length of the reader\": 12}";
+
+static void assert_reader_values(FILE* stream) {
+        dump_reader r;
+        dump_reader_init(&r, stream);
+        intmax_t i;
+        float f;
+        assert_string_equal("", dump_reader_key(&r));
+        assert_true(dump_reader_int(&r, &i));
+        assert_int_equal(-3, i);
+        assert_string_equal("a", dump_reader_key(&r));
+        assert_true(dump_reader_float(&r, &f));
+        assert_true(f == 0.5f);
+        assert_string_equal("b", dump_reader_key(&r));
+        assert_true(dump_reader_float(&r, &f));  // integers convert to float
+        assert_true(f == 7.0f);
+        assert_string_equal("b", dump_reader_key(&r));
+        assert_true(dump_reader_int(&r, &i));
+        assert_int_equal(12, i);
+        assert_int_equal(DUMP_KEYLEN - 1, strlen(dump_reader_key(&r)));
+        assert_false(dump_reader_int(&r, &i));
+        assert_false(dump_reader_float(&r, &f));
+        dump_reader_free(&r);
 }
 
-static void test_dump_merge_valid(void** state) {
-        struct dumpstate* s = *state;
-        void** m = merge(s->src, s->dst, s->n, s->n);
-        for (int i = 0; i < s->n * 2; i++) {
-                assert_non_null(*(m + i));
-                int* p = *(m + i);
-                int x = *p;
-                assert_in_range(x, 0, 2 * s->n);
-        }
-        free(m);
-}
+static void test_dump_reader() {
+        // Mapped file
+        FILE* stream = tmpfile();
+        assert_non_null(stream);
+        fputs(reader_json, stream);
+        fflush(stream);
+        rewind(stream);
+        assert_reader_values(stream);
+        fclose(stream);
 
-static void test_dump_uniq_valid(void** state) {
-        struct dumpstate* s = *state;
-        void** m = merge(s->src, s->src, s->n, s->n);
-        int len = s->n * 2;
-        void** u = calloc(len, sizeof(void*));
-        int lenuniq = uniq(m, u, len);
-        assert_int_equal(lenuniq, s->n);
-        free(m);
-        free(u);
+        // Pipes are read to a buffer
+        int fd[2];
+        assert_int_equal(0, pipe(fd));
+        assert_int_equal(sizeof(reader_json) - 1,
+                         write(fd[1], reader_json, sizeof(reader_json) - 1));
+        close(fd[1]);
+        stream = fdopen(fd[0], "r");
+        assert_non_null(stream);
+        assert_reader_values(stream);
+        fclose(stream);
 }
 
-static void test_dump_json_tostream(void** state) {
-        struct dumpstate* s = *state;
-
-        FILE* stream = fopen("test_dump_json_tostream.json", "w");
-        if (!stream) {
-                fail_msg("Could not open file for testing!\n");
-        }
-        json_printer* jp = dump_json_tostream_init(stream);
-        for (int i = 0; i < s->n; i++) {
-                int* p = (int*)*(s->src + i);
-                dump_json_tostream(jp, (int64_t)(*p));
+static void test_out() {
+        FILE* stream = tmpfile();
+        assert_non_null(stream);
+        out* o = out_init(stream);
+        int64_t const v[] = {0, 9, 10, 99, 100, -1, -10, INT64_MIN, INT64_MAX};
+        for (size_t i = 0; i < sizeof(v) / sizeof(*v); i++) {
+                out_int(o, v[i]);
+                out_char(o, ' ');
         }
-        dump_json_tostream_free(jp);
+        job* j = job_init(1, 23, 4, 567, -8);
+        out_job_json(o, j);
+        out_job_csv(o, j);
+        job_free(j);
+        out_free(o);
+        rewind(stream);
+        char expect[] =
+            "0 9 10 99 100 -1 -10 -9223372036854775808 9223372036854775807 "
+            "[1,23,4,567,-8]1,23,4,567,-8\n";
+        char got[sizeof(expect)] = {0};
+        assert_int_equal(sizeof(expect) - 1,
+                         fread(got, 1, sizeof(expect), stream));
+        assert_string_equal(expect, got);
+        fclose(stream);
 
-        stream = freopen(NULL, "r", stream);
-        if (!stream) {
-                fail_msg("Could not reopen file for testing!\n");
+        // Output exceeding the buffer is flushed in order
+        stream = tmpfile();
+        assert_non_null(stream);
+        o = out_init(stream);
+        char* big = malloc(OUT_BUFLEN + 2);
+        assert_non_null(big);
+        memset(big, 'x', OUT_BUFLEN + 1);
+        big[OUT_BUFLEN + 1] = '\0';
+        out_char(o, 'a');
+        out_str(o, big);
+        for (int i = 0; i < OUT_BUFLEN; i++) {
+                out_int(o, i % 10);
         }
-        char* buf = calloc(2 * s->n, sizeof(char));
-        if (!buf) {
-                fail_msg("Could not allocate buffer memory!\n");
+        out_free(o);
+        rewind(stream);
+        assert_int_equal('a', fgetc(stream));
+        for (int i = 0; i < OUT_BUFLEN + 1; i++) {
+                assert_int_equal('x', fgetc(stream));
         }
-        *(buf + 2 * s->n - 1) = 0;
-        char gld[] = "0,1,2,3,4,5,6,7,8,9";
-        size_t rb = fread(buf, sizeof(char), 2 * (s->n) - 1, stream);
-        if (!rb) {
-                fail_msg("Could not read file for testing!\n");
+        for (int i = 0; i < OUT_BUFLEN; i++) {
+                assert_int_equal('0' + i % 10, fgetc(stream));
         }
-        assert_string_equal(buf, gld);
-        free(buf);
+        assert_int_equal(EOF, fgetc(stream));
+        free(big);
         fclose(stream);
 }
 
@@ -148,8 +164,9 @@ int setup_eventloop_valid_edf(void** state) {
         ts_read_json(s->tsy, tasksystem);
         fclose(tasksystem);
 
-        s->jg = jobgen_init(s->tsy, 12312, true);
-        s->evl = eventloop_init(s->jg, true, false);
+        s->jg = jobgen_init(s->tsy, 12312, true, JOBGEN_ARRAY,
+                            JOBGEN_RNG_SHARED);
+        s->evl = eventloop_init(s->jg, true, false, JOBQ_HEAP);
 
         *state = s;
         return 0;
@@ -169,8 +186,9 @@ int setup_eventloop_invalid_edf(void** state) {
         ts_read_json(s->tsy, tasksystem);
         fclose(tasksystem);
 
-        s->jg = jobgen_init(s->tsy, 12312, true);
-        s->evl = eventloop_init(s->jg, true, false);
+        s->jg = jobgen_init(s->tsy, 12312, true, JOBGEN_ARRAY,
+                            JOBGEN_RNG_SHARED);
+        s->evl = eventloop_init(s->jg, true, false, JOBQ_HEAP);
 
         *state = s;
         return 0;
@@ -190,8 +208,9 @@ int setup_eventloop_deterministic_edf(void** state) {
         ts_read_json(s->tsy, tasksystem);
         fclose(tasksystem);
 
-        s->jg = jobgen_init(s->tsy, 12312, true);
-        s->evl = eventloop_init(s->jg, true, false);
+        s->jg = jobgen_init(s->tsy, 12312, true, JOBGEN_ARRAY,
+                            JOBGEN_RNG_SHARED);
+        s->evl = eventloop_init(s->jg, true, false, JOBQ_HEAP);
 
         *state = s;
         return 0;
@@ -211,8 +230,9 @@ int setup_eventloop_deterministic_edf_overrun(void** state) {
         ts_read_json(s->tsy, tasksystem);
         fclose(tasksystem);
 
-        s->jg = jobgen_init(s->tsy, 12312, true);
-        s->evl = eventloop_init(s->jg, true, false);
+        s->jg = jobgen_init(s->tsy, 12312, true, JOBGEN_ARRAY,
+                            JOBGEN_RNG_SHARED);
+        s->evl = eventloop_init(s->jg, true, false, JOBQ_HEAP);
 
         *state = s;
         return 0;
@@ -232,8 +252,9 @@ int setup_eventloop_deterministic_edf_overrun_first_allowed(void** state) {
         ts_read_json(s->tsy, tasksystem);
         fclose(tasksystem);
 
-        s->jg = jobgen_init(s->tsy, 12312, true);
-        s->evl = eventloop_init(s->jg, true, true);
+        s->jg = jobgen_init(s->tsy, 12312, true, JOBGEN_ARRAY,
+                            JOBGEN_RNG_SHARED);
+        s->evl = eventloop_init(s->jg, true, true, JOBQ_HEAP);
 
         *state = s;
         return 0;
@@ -334,7 +355,11 @@ static void test_eventloop_dump_valid(void** state) {
         if (stream) {
                 char block[1024];
                 char golden[] =
-                    "{\"now\":0,\"jobs\":[[19,14,4,21,3],[19,0,4,7,3]]}";
+                    "{\"now\":0,\"jobs\":[[19,0,4,7,3],[19,7,4,14,3],[19,14,4,"
+                    "21,3]],\"ready\":1,\"next\":1,\"events\":0,\"jobsdone\":0,"
+                    "\"overrun\":0,\"seed\":12312,\"rng\":0,\"pcg\":["
+                    "8750728872245072730,2982722932242307761],\"tasks\":[[19,"
+                    "21,3]]}";
                 int len;
                 len = fread(&block, sizeof(char), 1024, stream);
                 fclose(stream);
@@ -361,7 +386,11 @@ static void test_eventloop_read_json_continues(void** state) {
         // Assert that dumping twice results in same file content
         char block[1024];
         char golden[] =
-            "{\"now\":100,\"jobs\":[[19,112,4,119,3],[19,98,2,105,1]]}";
+            "{\"now\":100,\"jobs\":[[19,98,2,105,1],[19,105,4,112,3],[19,112,"
+            "4,119,3]],\"ready\":1,\"next\":1,\"events\":29,\"jobsdone\":14,"
+            "\"overrun\":0,\"seed\":12312,\"rng\":0,\"pcg\":["
+            "2035813929341276528,2982722932242307761],\"tasks\":[[19,119,"
+            "17]]}";
         int len;
 
         stream = fopen("test-eventloop-read.json", "r");
@@ -375,7 +404,7 @@ static void test_eventloop_read_json_continues(void** state) {
         assert_memory_equal(&block, &golden, len);
 
         eventloop_free(s->evl);
-        s->evl = eventloop_init(s->jg, false, false);
+        s->evl = eventloop_init(s->jg, false, false, JOBQ_HEAP);
 
         stream = fopen("test-eventloop-read.json", "r");
         assert_true(stream);
@@ -386,6 +415,1012 @@ static void test_eventloop_read_json_continues(void** state) {
         assert_int_equal(r, EVL_OK);
 }
 
+static void test_eventloop_read_json_legacy(void** state) {
+        struct eventloopstate* s = *state;
+
+        // Dump without generator state written by earlier versions
+        FILE* stream = tmpfile();
+        assert_non_null(stream);
+        fputs("{\"now\":100,\"jobs\":[[19,112,4,119,3],[19,98,2,105,1]]}",
+              stream);
+        rewind(stream);
+        eventloop_free(s->evl);
+        s->evl = eventloop_init(s->jg, false, false, JOBQ_HEAP);
+        eventloop_read_json(s->evl, stream);
+        fclose(stream);
+        assert_int_equal(eventloop_get_now(s->evl), 100);
+
+        eventloop_result r = eventloop_run(s->evl, 200, 1, false);
+        assert_int_equal(r, EVL_OK);
+}
+
+static void assert_streams_equal(FILE* a, FILE* b) {
+        rewind(a);
+        rewind(b);
+        int ch;
+        while ((ch = fgetc(a)) != EOF) {
+                assert_int_equal(ch, fgetc(b));
+        }
+        assert_int_equal(EOF, fgetc(b));
+}
+
+static void test_eventloop_resume_exact() {
+        ts* tsy = ts_init();
+        FILE* stream = fopen("test/ts-edfok.json", "r");
+        assert_non_null(stream);
+        ts_read_json(tsy, stream);
+        fclose(stream);
+
+        jobgen_rng const rngs[] = {JOBGEN_RNG_SHARED, JOBGEN_RNG_BATCH,
+                                   JOBGEN_RNG_COUNTER};
+        jobq_kind const kinds[] = {JOBQ_HEAP, JOBQ_PERTASK, JOBQ_CALENDAR};
+        for (int i = 0; i < 6; i++) {
+                // Split at an arrival from 3000 on, and right after it within
+                // the job then run, which no other arrival preempts
+                jobgen* jgp = jobgen_init(tsy, 7, true, JOBGEN_ARRAY,
+                                          rngs[i % 3]);
+                job* j = jobgen_rise(jgp);
+                job* n = jobgen_rise(jgp);
+                while (job_get_starttime(j) < 3000 ||
+                       job_get_starttime(n) <= job_get_starttime(j) + 1) {
+                        job_free(j);
+                        j = n;
+                        n = jobgen_rise(jgp);
+                }
+                JOB_INT const splits[] = {job_get_starttime(j),
+                                          job_get_starttime(j) + 1};
+                job_free(j);
+                job_free(n);
+                jobgen_free(jgp);
+
+                for (int k = 0; k < 6; k++) {
+                        int q = k % 3;
+                        bool bin = i >= 3;
+                        jobgen* jgu = jobgen_init(tsy, 7, true, JOBGEN_ARRAY,
+                                                  rngs[i % 3]);
+                        eventloop* u = eventloop_init(jgu, true, false,
+                                                      kinds[q]);
+                        jobgen* jga = jobgen_init(tsy, 7, true, JOBGEN_ARRAY,
+                                                  rngs[i % 3]);
+                        eventloop* a = eventloop_init(jga, true, false,
+                                                      kinds[q]);
+                        assert_int_equal(eventloop_run(a, splits[k / 3], 1,
+                                                       false),
+                                         EVL_OK);
+                        FILE* dump = tmpfile();
+                        if (bin) {
+                                eventloop_dump_bin(a, dump);
+                        } else {
+                                eventloop_dump(a, dump);
+                        }
+                        fflush(dump);
+                        rewind(dump);
+
+                        // Resume in a fresh generator with other queue kinds
+                        jobgen* jgb = jobgen_init(tsy, 0, false, JOBGEN_HEAP,
+                                                  rngs[i % 3]);
+                        eventloop* b = eventloop_init(jgb, false, false,
+                                                      kinds[(q + 1) % 3]);
+                        eventloop_read(b, dump);
+                        fclose(dump);
+
+                        eventloop_result r = eventloop_run(u, 9000, 1, false);
+                        assert_int_equal(r, eventloop_run(a, 9000, 1, false));
+                        assert_int_equal(r, eventloop_run(b, 9000, 1, false));
+                        FILE* da = tmpfile();
+                        FILE* db = tmpfile();
+                        eventloop_dump(a, da);
+                        eventloop_dump(b, db);
+                        assert_streams_equal(da, db);
+                        fclose(da);
+                        fclose(db);
+
+                        // Stopping within a job counts its preemption, the
+                        // only difference to the uninterrupted run
+                        assert_int_equal(eventloop_get_now(u),
+                                         eventloop_get_now(b));
+                        assert_int_equal(eventloop_get_jobsdone(u),
+                                         eventloop_get_jobsdone(b));
+                        assert_int_equal(eventloop_get_events(u) + k / 3,
+                                         eventloop_get_events(b));
+                        if (k < 3) {
+                                FILE* du = tmpfile();
+                                db = tmpfile();
+                                eventloop_dump(u, du);
+                                eventloop_dump(b, db);
+                                assert_streams_equal(du, db);
+                                fclose(du);
+                                fclose(db);
+                        }
+
+                        eventloop_free(u);
+                        eventloop_free(a);
+                        eventloop_free(b);
+                        jobgen_free(jgu);
+                        jobgen_free(jga);
+                        jobgen_free(jgb);
+                }
+        }
+        ts_free(tsy);
+}
+
+static void assert_job_equal(job* a, job* b) {
+        assert_int_equal(job_get_taskid(a), job_get_taskid(b));
+        assert_int_equal(job_get_taskpos(a), job_get_taskpos(b));
+        assert_int_equal(job_get_starttime(a), job_get_starttime(b));
+        assert_int_equal(job_get_deadline(a), job_get_deadline(b));
+        assert_int_equal(job_get_computation(a), job_get_computation(b));
+        assert_int_equal(job_get_overruntime(a), job_get_overruntime(b));
+}
+
+static void test_trace_replay() {
+        ts* tsy = ts_init();
+        FILE* stream = fopen("test/ts-edfok.json", "r");
+        assert_non_null(stream);
+        ts_read_json(tsy, stream);
+        fclose(stream);
+
+        // Record the jobs of a generator
+        int const n = 2 * TRACE_INTERVAL + 100;
+        job** jobs = calloc(n, sizeof(job*));
+        assert_non_null(jobs);
+        jobgen* jg = jobgen_init(tsy, 3, true, JOBGEN_ARRAY, JOBGEN_RNG_SHARED);
+        FILE* file = tmpfile();
+        assert_non_null(file);
+        trace_writer* tw =
+            trace_writer_init(file, tsy, jobgen_get_released(jg));
+        jobgen_record(jg, tw);
+        for (int i = 0; i < n; i++) {
+                jobs[i] = jobgen_rise(jg);
+        }
+        trace_writer_free(tw);
+        jobgen_free(jg);
+        fflush(file);
+
+        trace* tr = trace_init(file, tsy);
+        uint64_t first;
+        uint64_t end;
+        trace_range(tr, &first, &end);
+        assert_int_equal(0, first);
+        assert_int_equal(n, end);
+        for (int i = 0; i < n; i++) {
+                job* j = trace_next(tr);
+                assert_job_equal(jobs[i], j);
+                job_free(j);
+        }
+        assert_null(trace_next(tr));
+
+        // Seek by record and by time through the index
+        trace_seek(tr, TRACE_INTERVAL + 5);
+        job* j = trace_next(tr);
+        assert_job_equal(jobs[TRACE_INTERVAL + 5], j);
+        job_free(j);
+        JOB_INT t = job_get_starttime(jobs[TRACE_INTERVAL + 50]);
+        trace_seek_time(tr, t);
+        uint64_t r = trace_tell(tr);
+        assert_true(job_get_starttime(jobs[r]) >= t);
+        assert_true(job_get_starttime(jobs[r - 1]) < t);
+        j = trace_next(tr);
+        assert_job_equal(jobs[r], j);
+        job_free(j);
+
+        // Replay schedules as generating
+        JOB_INT breaktime = job_get_starttime(jobs[n / 2]);
+        jobgen* jga = jobgen_init(tsy, 3, true, JOBGEN_HEAP, JOBGEN_RNG_SHARED);
+        jobgen* jgb = jobgen_init(tsy, 0, false, JOBGEN_ARRAY,
+                                  JOBGEN_RNG_BATCH);
+        jobgen_replay(jgb, tr);
+        eventloop* a = eventloop_init(jga, true, false, JOBQ_HEAP);
+        eventloop* b = eventloop_init(jgb, true, false, JOBQ_HEAP);
+        assert_int_equal(eventloop_run(a, breaktime, 1, false),
+                         eventloop_run(b, breaktime, 1, false));
+        assert_int_equal(eventloop_get_now(a), eventloop_get_now(b));
+        assert_int_equal(jobgen_get_released(jga), jobgen_get_released(jgb));
+        eventloop_free(a);
+        eventloop_free(b);
+        jobgen_free(jga);
+        jobgen_free(jgb);
+
+        trace_free(tr);
+        fclose(file);
+        for (int i = 0; i < n; i++) {
+                job_free(jobs[i]);
+        }
+        free(jobs);
+        ts_free(tsy);
+}
+
+static void test_trace_csv() {
+        ts* tsy = ts_init();
+        FILE* stream = fopen("test/ts-edfok.json", "r");
+        assert_non_null(stream);
+        ts_read_json(tsy, stream);
+        fclose(stream);
+
+        // Header, empty line, defaults and last line without newline
+        stream = tmpfile();
+        assert_non_null(stream);
+        fputs("task,release,overrun,deadline,computation\n1,0,,,2\n\n"
+              " 3, 12 ,5,40,4\r\n4,12,,,1",
+              stream);
+        rewind(stream);
+        trace_csv* tc = trace_csv_init(stream, tsy);
+        JOB_INT const expect[][5] = {
+            {1, 0, 3, 10, 2}, {3, 12, 5, 40, 4}, {4, 12, 2, 22, 1}};
+        for (int i = 0; i < 3; i++) {
+                job* j = trace_csv_next(tc);
+                assert_non_null(j);
+                assert_int_equal(expect[i][0], job_get_taskid(j));
+                assert_int_equal(expect[i][1], job_get_starttime(j));
+                assert_int_equal(expect[i][2], job_get_overruntime(j));
+                assert_int_equal(expect[i][3], job_get_deadline(j));
+                assert_int_equal(expect[i][4], job_get_computation(j));
+                assert_int_equal(expect[i][0] - 1, job_get_taskpos(j));
+                job_free(j);
+        }
+        assert_null(trace_csv_next(tc));
+        trace_csv_free(tc);
+        fclose(stream);
+
+        // Jobs written by out_job_csv, spanning several read ahead buffers
+        int const n = 10000;
+        job** jobs = calloc(n, sizeof(job*));
+        assert_non_null(jobs);
+        jobgen* jg = jobgen_init(tsy, 5, true, JOBGEN_ARRAY, JOBGEN_RNG_BATCH);
+        stream = tmpfile();
+        assert_non_null(stream);
+        out* o = out_init(stream);
+        for (int i = 0; i < n; i++) {
+                jobs[i] = jobgen_rise(jg);
+                out_job_csv(o, jobs[i]);
+        }
+        out_free(o);
+        jobgen_free(jg);
+        assert_true(ftell(stream) > TRACE_READLEN);
+        rewind(stream);
+        tc = trace_csv_init(stream, tsy);
+        for (int i = 0; i < n; i++) {
+                job* j = trace_csv_next(tc);
+                assert_job_equal(jobs[i], j);
+                job_free(j);
+        }
+        assert_null(trace_csv_next(tc));
+        trace_csv_free(tc);
+
+        // Replay schedules as generating and ends without further arrivals
+        rewind(stream);
+        tc = trace_csv_init(stream, tsy);
+        JOB_INT breaktime = job_get_starttime(jobs[n / 2]);
+        jobgen* jga = jobgen_init(tsy, 5, true, JOBGEN_ARRAY, JOBGEN_RNG_BATCH);
+        jobgen* jgb = jobgen_init(tsy, 0, false, JOBGEN_CALENDAR,
+                                  JOBGEN_RNG_SHARED);
+        jobgen_replay_csv(jgb, tc);
+        eventloop* a = eventloop_init(jga, true, false, JOBQ_HEAP);
+        eventloop* b = eventloop_init(jgb, true, false, JOBQ_PERTASK);
+        assert_int_equal(eventloop_run(a, breaktime, 1, false),
+                         eventloop_run(b, breaktime, 1, false));
+        assert_int_equal(eventloop_get_now(a), eventloop_get_now(b));
+        JOB_INT end = job_get_starttime(jobs[n - 1]) + 1000;
+        assert_int_equal(EVL_OK, eventloop_run(b, end, 1, false));
+        assert_int_equal(end, eventloop_get_now(b));
+        eventloop_free(a);
+        eventloop_free(b);
+        jobgen_free(jga);
+        jobgen_free(jgb);
+        trace_csv_free(tc);
+        fclose(stream);
+
+        for (int i = 0; i < n; i++) {
+                job_free(jobs[i]);
+        }
+        free(jobs);
+        ts_free(tsy);
+}
+
+static void collect_outcome(replicate_outcome const* o, void* arg) {
+        replicate_outcome** next = arg;
+        *(*next)++ = *o;
+}
+
+static void test_replicate_run() {
+        ts* tsy = ts_init();
+        FILE* stream = fopen("test/ts-edfok.json", "r");
+        assert_non_null(stream);
+        ts_read_json(tsy, stream);
+        fclose(stream);
+
+        replicate_config c = {0};
+        c.tsy = tsy;
+        c.breaktime = 20000;
+        c.speed = 1;
+        c.overrunbreak = true;
+        c.readyq = JOBQ_HEAP;
+        c.arrivalq = JOBGEN_ARRAY;
+        c.rng = JOBGEN_RNG_SHARED;
+        int const n = 12;
+        replicate_outcome outcomes[12];
+        for (int threads = 1; threads <= 4; threads += 3) {
+                replicate_outcome* next = outcomes;
+                replicate_run(&c, 100, 100 + n - 1, threads, collect_outcome,
+                              &next);
+                assert_int_equal(n, next - outcomes);
+                for (int i = 0; i < n; i++) {
+                        replicate_outcome o = replicate_seed(&c, 100 + i);
+                        assert_int_equal(100 + i, outcomes[i].seed);
+                        assert_int_equal(o.result, outcomes[i].result);
+                        assert_int_equal(o.now, outcomes[i].now);
+                        assert_int_equal(o.events, outcomes[i].events);
+                        assert_int_equal(o.jobsdone, outcomes[i].jobsdone);
+                }
+        }
+        assert_true(replicate_threads() >= 1);
+        ts_free(tsy);
+}
+
+static void collect_record(sweep_record const* r, void* arg) {
+        sweep_record** next = arg;
+        *(*next)++ = *r;
+}
+
+static void test_sweep_run() {
+        char const* files[] = {"test/ts-edfok.json", "test/ts-edfnotok.json"};
+        ts const* tsys[2];
+        for (int i = 0; i < 2; i++) {
+                ts* tsy = ts_init();
+                FILE* stream = fopen(files[i], "r");
+                assert_non_null(stream);
+                ts_read_json(tsy, stream);
+                fclose(stream);
+                tsys[i] = tsy;
+        }
+        JOB_INT const speeds[] = {1, 2};
+        JOB_INT const breaktimes[] = {5000, 20000};
+        sweep_overrun const overruns[] = {SWEEP_OVERRUN_NONE,
+                                          SWEEP_OVERRUN_BREAK,
+                                          SWEEP_OVERRUN_FIRST};
+        sweep_grid g = {0};
+        g.tsys = tsys;
+        g.ntsys = 2;
+        g.seedfirst = 7;
+        g.seedlast = 9;
+        g.speeds = speeds;
+        g.nspeeds = 2;
+        g.breaktimes = breaktimes;
+        g.nbreaktimes = 2;
+        g.overruns = overruns;
+        g.noverruns = 3;
+        g.readyq = JOBQ_HEAP;
+        g.arrivalq = JOBGEN_ARRAY;
+        g.rng = JOBGEN_RNG_SHARED;
+        assert_int_equal(72, sweep_size(&g));
+
+        sweep_record p = sweep_point(&g, 71);
+        assert_int_equal(1, p.tsy);
+        assert_int_equal(9, p.seed);
+        assert_int_equal(2, p.speed);
+        assert_int_equal(20000, p.breaktime);
+        assert_int_equal(SWEEP_OVERRUN_FIRST, p.overrun);
+        p = sweep_point(&g, 13);
+        assert_int_equal(0, p.tsy);
+        assert_int_equal(8, p.seed);
+        assert_int_equal(1, p.speed);
+        assert_int_equal(5000, p.breaktime);
+        assert_int_equal(SWEEP_OVERRUN_BREAK, p.overrun);
+
+        sweep_record records[72];
+        for (int threads = 1; threads <= 3; threads += 2) {
+                sweep_record* next = records;
+                sweep_run(&g, threads, collect_record, &next);
+                assert_int_equal(72, next - records);
+                bool seen[72] = {false};
+                for (int i = 0; i < 72; i++) {
+                        sweep_record const* r = records + i;
+                        assert_true(r->run < 72);
+                        assert_false(seen[r->run]);
+                        seen[r->run] = true;
+
+                        sweep_record e = sweep_point(&g, r->run);
+                        replicate_config c;
+                        c.tsy = tsys[e.tsy];
+                        c.breaktime = e.breaktime;
+                        c.speed = e.speed;
+                        c.overrunbreak = e.overrun != SWEEP_OVERRUN_NONE;
+                        c.allow_first_overrun =
+                            e.overrun == SWEEP_OVERRUN_FIRST;
+                        c.readyq = JOBQ_HEAP;
+                        c.arrivalq = JOBGEN_ARRAY;
+                        c.rng = JOBGEN_RNG_SHARED;
+                        replicate_outcome o = replicate_seed(&c, e.seed);
+                        assert_int_equal(e.tsy, r->tsy);
+                        assert_int_equal(e.seed, r->seed);
+                        assert_int_equal(e.speed, r->speed);
+                        assert_int_equal(e.breaktime, r->breaktime);
+                        assert_int_equal(e.overrun, r->overrun);
+                        assert_int_equal(o.result, r->result);
+                        assert_int_equal(o.now, r->now);
+                        assert_int_equal(o.events, r->events);
+                        assert_int_equal(o.jobsdone, r->jobsdone);
+                }
+        }
+        assert_int_equal(64, sizeof(sweep_record));
+        for (int i = 0; i < 2; i++) {
+                ts_free((ts*)tsys[i]);
+        }
+}
+
+/* Workers of a sweep print nothing to stdout, also on overruns */
+static void test_sweep_quiet() {
+        ts* tsy = ts_init();
+        FILE* stream = fopen("test/p41-ts-nointerarrival-0.5hi.json", "r");
+        assert_non_null(stream);
+        ts_read_json(tsy, stream);
+        fclose(stream);
+        ts const* tsys[] = {tsy};
+        JOB_INT const speeds[] = {1};
+        JOB_INT const breaktimes[] = {100000};
+        sweep_overrun const overruns[] = {SWEEP_OVERRUN_BREAK,
+                                          SWEEP_OVERRUN_FIRST};
+        sweep_grid g = {0};
+        g.tsys = tsys;
+        g.ntsys = 1;
+        g.seedfirst = 0;
+        g.seedlast = 5;
+        g.speeds = speeds;
+        g.nspeeds = 1;
+        g.breaktimes = breaktimes;
+        g.nbreaktimes = 1;
+        g.overruns = overruns;
+        g.noverruns = 2;
+        g.readyq = JOBQ_HEAP;
+        g.arrivalq = JOBGEN_ARRAY;
+        g.rng = JOBGEN_RNG_SHARED;
+
+        FILE* out = tmpfile();
+        assert_non_null(out);
+        fflush(stdout);
+        int const saved = dup(STDOUT_FILENO);
+        assert_true(saved >= 0);
+        assert_true(dup2(fileno(out), STDOUT_FILENO) >= 0);
+        sweep_record records[12];
+        sweep_record* next = records;
+        sweep_run(&g, 3, collect_record, &next);
+        fflush(stdout);
+        assert_true(dup2(saved, STDOUT_FILENO) >= 0);
+        close(saved);
+
+        assert_int_equal(12, next - records);
+        int overrun = 0;
+        for (int i = 0; i < 12; i++) {
+                overrun += records[i].result == EVL_OVERRUN;
+        }
+        assert_true(overrun > 0);
+        fseek(out, 0, SEEK_END);
+        assert_int_equal(0, ftell(out));
+        fclose(out);
+        ts_free(tsy);
+}
+
+static void test_thready_simulate() {
+        char buf[4096];
+        FILE* stream = fopen("test/ts-edfok.json", "r");
+        assert_non_null(stream);
+        size_t len = fread(buf, 1, sizeof(buf), stream);
+        fclose(stream);
+        ts* tsy = ts_init();
+        stream = fopen("test/ts-edfok.json", "r");
+        ts_read_json(tsy, stream);
+        fclose(stream);
+
+        thready_tasksystem* parsed;
+        assert_int_equal(THREADY_OK,
+                         thready_tasksystem_parse(&parsed, buf, len));
+        assert_int_equal(ts_length(tsy), thready_tasksystem_length(parsed));
+        thready_task tasks[4];
+        ts_params const* p = ts_get_params(tsy);
+        for (int k = 0; k < 4; k++) {
+                tasks[k].id = p->ids[k];
+                tasks[k].period = p->periods[k];
+                tasks[k].reldead = p->reldeads[k];
+                for (int j = 0; j < TASK_NUM_COMP; j++) {
+                        tasks[k].comp[j] = p->comp[j][k];
+                }
+                for (int j = 0; j < TASK_NUM_PROB; j++) {
+                        tasks[k].prob[j] = p->prob[j][k];
+                }
+                tasks[k].beta = p->beta[k];
+        }
+        thready_tasksystem* built;
+        assert_int_equal(THREADY_OK, thready_tasksystem_init(&built, tasks, 4));
+
+        thready_run runs[9];
+        for (int i = 0; i < 9; i++) {
+                runs[i].seed = 40 + i;
+                runs[i].breaktime = 1000 * (i + 1);
+                runs[i].speed = 1 + i % 2;
+                runs[i].overrun = i % 3;
+        }
+        thready_options o;
+        thready_options_default(&o);
+        o.rng = THREADY_RNG_BATCH;
+        o.readyq = THREADY_READYQ_PERTASK;
+        thready_outcome outcomes[9];
+        for (o.threads = 1; o.threads <= 3; o.threads += 2) {
+                thready_tasksystem* t = o.threads == 1 ? parsed : built;
+                assert_int_equal(THREADY_OK,
+                                 thready_simulate(t, runs, 9, &o, outcomes));
+                for (int i = 0; i < 9; i++) {
+                        replicate_config c = {0};
+                        c.tsy = tsy;
+                        c.breaktime = runs[i].breaktime;
+                        c.speed = runs[i].speed;
+                        c.overrunbreak = runs[i].overrun != 0;
+                        c.allow_first_overrun = runs[i].overrun == 2;
+                        c.readyq = JOBQ_PERTASK;
+                        c.arrivalq = JOBGEN_ARRAY;
+                        c.rng = JOBGEN_RNG_BATCH;
+                        replicate_outcome r = replicate_seed(&c, 40 + i);
+                        assert_int_equal(r.result, outcomes[i].result);
+                        assert_int_equal(r.now, outcomes[i].now);
+                        assert_int_equal(r.events, outcomes[i].events);
+                        assert_int_equal(r.jobsdone, outcomes[i].jobsdone);
+                }
+        }
+        assert_int_equal(THREADY_OK,
+                         thready_simulate(parsed, runs, 1, NULL, outcomes));
+
+        // Invalid input is returned instead of exiting
+        runs[4].speed = 0;
+        assert_int_equal(THREADY_EINVAL,
+                         thready_simulate(parsed, runs, 9, &o, outcomes));
+        o.rng = 7;
+        assert_int_equal(THREADY_EINVAL,
+                         thready_simulate(parsed, runs, 1, &o, outcomes));
+        assert_int_equal(THREADY_EINVAL,
+                         thready_simulate(NULL, runs, 1, NULL, outcomes));
+        char longnum[DUMP_BUFLEN + 3] = "[";
+        memset(longnum + 1, '1', DUMP_BUFLEN);
+        strcat(longnum, "]");
+        char deep[DUMP_MAXDEPTH + 2] = "";
+        memset(deep, '[', DUMP_MAXDEPTH + 1);
+        char const* malformed[] = {"[[1,10,10,1,1,0,0,0,0,1.0,0.0,1.0],[2,10",
+                                   "[[1.5,10,10,1,1,0,0,0,0,1.0,0.0,1.0]]",
+                                   "[[1,10,10,1,1,0,0,0,0,1.0,0.0,1.0]",
+                                   "[[1,10,10,1,1,0,0,0,0,1.0,0.0,1.0,x]]",
+                                   "{\"unterminated",
+                                   "[99999999999999999999999]",
+                                   "[[0,10,10,1,1,0,0,0,0,1.0,0.0,0.0",
+                                   "[[0 10 10 1 1 0 0 0 0 1.0 0.0 0.0]] true",
+                                   "[[0,10,10,1,1,0,0,0,0,1.0,0.0,0.0]] nuts",
+                                   "[[0,10,10,1,1,0,0,0,0,1.0,0.0,0.0],]",
+                                   "[[0,10,10,1,1,0,0,0,0,1.0,0.0,+0.0]]",
+                                   "[[0,10,10,1,1,0,0,0,0,1.0,0.0,0-0]]",
+                                   "[[0,10,10,1,1,0,0,0,0,1.0,0.0,0.0}]",
+                                   "{\"a\" 1}",
+                                   "[nuts]",
+                                   "[[0,10,10,1,1,0,0,0,0,1.0,0.0,0.0]]]",
+                                   "[-]",
+                                   "[01]",
+                                   "[1.]",
+                                   "[1e+]",
+                                   "[1 \"x\"]",
+                                   "[1 []]",
+                                   longnum,
+                                   deep};
+        for (size_t i = 0; i < sizeof(malformed) / sizeof(*malformed); i++) {
+                thready_tasksystem* t = parsed;
+                assert_int_equal(THREADY_EPARSE,
+                                 thready_tasksystem_parse(
+                                     &t, malformed[i], strlen(malformed[i])));
+                assert_null(t);
+        }
+        char const* wellformed[] = {
+            "", " # comment\n",
+            "[[0,10,10,1,1,0,0,0,0,1.0,0.0,0.0,null,true,false,\"x\",{}]]",
+            "[[0,10,10,1,1,0,0,0,0,1e+0,0.0,-0E-1]]",
+            "{\"tasks\":[[0,10,10,1,1,0,0,0,0,10E-1,0.0,0.0]]}"};
+        for (size_t i = 0; i < sizeof(wellformed) / sizeof(*wellformed); i++) {
+                thready_tasksystem* t = NULL;
+                assert_int_equal(THREADY_OK,
+                                 thready_tasksystem_parse(
+                                     &t, wellformed[i], strlen(wellformed[i])));
+                thready_tasksystem_free(t);
+        }
+        tasks[2].period = 0;
+        thready_tasksystem* t = parsed;
+        assert_int_equal(THREADY_ETASKSYSTEM,
+                         thready_tasksystem_init(&t, tasks, 4));
+        assert_null(t);
+        tasks[2].period = 10;
+        tasks[1].comp[0] = 0;
+        assert_int_equal(THREADY_ETASKSYSTEM,
+                         thready_tasksystem_init(&t, tasks, 4));
+        tasks[1].comp[0] = 1;
+        tasks[3].prob[1] = 0.5f;
+        assert_int_equal(THREADY_ETASKSYSTEM,
+                         thready_tasksystem_init(&t, tasks, 4));
+        assert_int_equal(THREADY_EINVAL, thready_tasksystem_init(&t, NULL, 4));
+        assert_int_equal(THREADY_EINVAL, thready_tasksystem_parse(NULL, "", 0));
+        assert_string_equal("invalid argument",
+                            thready_strerror(THREADY_EINVAL));
+        for (int i = THREADY_OK; i <= THREADY_ENOMEM; i++) {
+                assert_non_null(thready_strerror(i));
+        }
+        assert_non_null(thready_version());
+
+        thready_tasksystem_free(parsed);
+        thready_tasksystem_free(built);
+        thready_thread_free();
+        ts_free(tsy);
+}
+
+static void test_serve_stream() {
+        char json[4096];
+        FILE* stream = fopen("test/ts-edfok.json", "r");
+        assert_non_null(stream);
+        size_t len = fread(json, 1, sizeof(json) - 1, stream);
+        fclose(stream);
+        json[len] = '\0';
+        for (char* c = json; *c; c++) {
+                *c = *c == '\n' ? ' ' : *c;
+        }
+        ts* tsy = ts_init();
+        stream = fopen("test/ts-edfok.json", "r");
+        ts_read_json(tsy, stream);
+        fclose(stream);
+
+        // The id of the task system is learned from a first session
+        FILE* in = tmpfile();
+        FILE* out = tmpfile();
+        fprintf(in, "ts %s\n", json);
+        rewind(in);
+        thready_options o;
+        thready_options_default(&o);
+        serve_stream(in, fileno(out), &o);
+        rewind(out);
+        uint64_t id;
+        assert_int_equal(1, fscanf(out, "ts %" SCNx64 "\n", &id));
+        fclose(in);
+        fclose(out);
+
+        in = tmpfile();
+        out = tmpfile();
+        fprintf(in, "ts %s\r\n\n", json);
+        for (int i = 0; i < 12; i++) {
+                fprintf(in, "run %" PRIx64 " %d %d %d %s\n", id, 30 + i,
+                        2000 * (i + 1), 1 + i % 2,
+                        i % 3 == 2 ? "ba" : i % 3 ? "b" : "");
+        }
+        fprintf(in, "run 1 1 1 1\nrun %" PRIx64 " 1 x\nrun %" PRIx64
+                    " 1 1 0 -\nbogus\nts [[1,2\n",
+                id, id);
+        rewind(in);
+        o.threads = 3;
+        o.readyq = THREADY_READYQ_CALENDAR;
+        serve_stream(in, fileno(out), &o);
+        rewind(out);
+
+        // Runs are answered in order of completion
+        char line[256];
+        int runs = 0;
+        int errors = 0;
+        while (fgets(line, sizeof(line), out)) {
+                uint64_t rid;
+                uint32_t seed;
+                int64_t breaktime;
+                int64_t speed;
+                char flags[4];
+                char result[16];
+                int64_t now;
+                int64_t events;
+                int64_t jobsdone;
+                if (strstr(line, "error")) {
+                        errors++;
+                        continue;
+                }
+                if (!strncmp(line, "ts ", 3)) {
+                        assert_int_equal(1, sscanf(line, "ts %" SCNx64, &rid));
+                        assert_true(rid == id);
+                        continue;
+                }
+                assert_int_equal(
+                    9, sscanf(line,
+                              "run %" SCNx64 " %" SCNu32 " %" SCNd64
+                              " %" SCNd64 " %3s %15s %" SCNd64 " %" SCNd64
+                              " %" SCNd64,
+                              &rid, &seed, &breaktime, &speed, flags, result,
+                              &now, &events, &jobsdone));
+                int i = seed - 30;
+                assert_true(rid == id);
+                assert_int_equal(2000 * (i + 1), breaktime);
+                assert_string_equal(i % 3 == 2 ? "ba" : i % 3 ? "b" : "-",
+                                    flags);
+                replicate_config c = {0};
+                c.tsy = tsy;
+                c.breaktime = breaktime;
+                c.speed = speed;
+                c.overrunbreak = i % 3;
+                c.allow_first_overrun = i % 3 == 2;
+                c.readyq = JOBQ_CALENDAR;
+                c.arrivalq = JOBGEN_ARRAY;
+                c.rng = JOBGEN_RNG_SHARED;
+                replicate_outcome r = replicate_seed(&c, seed);
+                char const* results[] = {"ok", "deadlinemiss", "pass",
+                                         "overrun"};
+                assert_string_equal(results[r.result], result);
+                assert_int_equal(r.now, now);
+                assert_int_equal(r.events, events);
+                assert_int_equal(r.jobsdone, jobsdone);
+                runs++;
+        }
+        assert_int_equal(12, runs);
+        assert_int_equal(5, errors);
+        fclose(in);
+        fclose(out);
+        ts_free(tsy);
+}
+
+static void test_bench() {
+        assert_null(bench_find("nonexistent"));
+        bench_workload const* w = bench_find("nohi-pertask");
+        assert_non_null(w);
+        assert_int_equal(JOBQ_PERTASK, w->readyq);
+
+        double const v[] = {4.0, 1.0, 3.0, 2.0};
+        assert_true(isnan(bench_quantile(v, 0, 0.5)));
+        assert_true(bench_quantile(v, 4, 0.5) == 2.5);
+        assert_true(fabs(bench_quantile(v, 4, 0.95) - 3.85) < 1e-12);
+        assert_true(bench_quantile(v, 4, 1.0) == 4.0);
+
+        double const a[] = {1, 2, 3, 4, 5};
+        double const b[] = {6, 7, 8, 9, 10};
+        double const same[] = {1, 1, 1};
+        double const p = bench_mannwhitney(a, 5, b, 5);
+        assert_true(fabs(p - 0.012186) < 1e-6);
+        assert_true(bench_mannwhitney(b, 5, a, 5) == p);
+        assert_true(bench_mannwhitney(same, 3, same, 3) == 1.0);
+        assert_true(bench_mannwhitney(a, 0, b, 5) == 1.0);
+
+        // Same seed, same events in every repetition
+        ts* tsy = ts_init();
+        FILE* stream = fopen(w->tasksystem, "r");
+        assert_non_null(stream);
+        ts_read_json(tsy, stream);
+        fclose(stream);
+        bench_result r[2];
+        bench_run(tsy, w, 3, 20000, 1, 3, r);
+        bench_run(tsy, bench_find("nohi"), 3, 20000, 0, 2, r + 1);
+        bench_result counted;
+        assert_true(bench_count(tsy, w, 3, 20000, &counted) ==
+                    bench_counter_available());
+        ts_free(tsy);
+        assert_int_equal(0, counted.n);
+        assert_int_equal(r[0].events, counted.events);
+        assert_int_equal(r[0].jobsdone, counted.jobsdone);
+        if (counted.counted) {
+                assert_true(counted.instructions.eventloop > 0.0);
+                assert_true(counted.instructions.jobgen > 0.0);
+                assert_true(counted.instructions.jobq > 0.0);
+        }
+        assert_string_equal("nohi-pertask", r[0].name);
+        assert_int_equal(3, r[0].n);
+        assert_false(r[0].counted);
+        assert_true(r[0].events > 0);
+        assert_int_equal(r[0].events, r[1].events);
+        assert_int_equal(r[0].jobsdone, r[1].jobsdone);
+        for (int i = 0; i < 3; i++) {
+                assert_true(r[0].nspe[i] > 0.0);
+        }
+        bench_summary s = bench_summarize(r);
+        assert_true(s.median <= s.p95);
+        assert_true(s.events_per_sec == 1e9 / s.median);
+        assert_true(s.jobs_per_sec ==
+                    s.events_per_sec * r[0].jobsdone / r[0].events);
+
+        // Results survive writing and reading
+        stream = tmpfile();
+        assert_non_null(stream);
+        bench_write_json(stream, r, 2, 3, 1);
+        rewind(stream);
+        bench_result* read;
+        assert_int_equal(2, bench_read_json(stream, &read));
+        fclose(stream);
+        for (int i = 0; i < 2; i++) {
+                assert_string_equal(r[i].name, read[i].name);
+                assert_int_equal(r[i].n, read[i].n);
+                assert_int_equal(r[i].events, read[i].events);
+                assert_int_equal(r[i].jobsdone, read[i].jobsdone);
+                for (int j = 0; j < r[i].n; j++) {
+                        assert_true(fabs(read[i].nspe[j] - r[i].nspe[j]) <
+                                    1e-4);
+                }
+        }
+        bench_comparison c = bench_compare(r, read);
+        assert_true(fabs(c.change) < 1e-4);
+        c = bench_compare(read, read);
+        assert_true(c.change == 0.0);
+        assert_true(c.p == 1.0);
+        for (int i = 0; i < 2; i++) {
+                bench_result_free(r + i);
+                bench_result_free(read + i);
+        }
+        free(read);
+
+        // Instructions are written without timings
+        counted.counted = true;
+        counted.instructions = (bench_instructions){412.25, 87.5, 60.0};
+        stream = tmpfile();
+        assert_non_null(stream);
+        bench_write_json(stream, &counted, 1, 3, 1);
+        rewind(stream);
+        assert_int_equal(1, bench_read_json(stream, &read));
+        fclose(stream);
+        assert_true(read->counted);
+        assert_int_equal(0, read->n);
+        assert_null(read->nspe);
+        assert_true(read->instructions.eventloop == 412.25);
+        assert_true(read->instructions.jobgen == 87.5);
+        assert_true(read->instructions.jobq == 60.0);
+        bench_result_free(read);
+        free(read);
+}
+
+static void test_gen() {
+        gen_config c;
+        gen_config_default(&c);
+        assert_null(gen_check(&c));
+        for (int i = 0; i < 9; i++) {
+                gen_config bad = c;
+                switch (i) {
+                        case 0:
+                                bad.n = 0;
+                                break;
+                        case 1:
+                                bad.utilization = 11.0;
+                                break;
+                        case 2:
+                                bad.pmax = 9;
+                                break;
+                        case 3:
+                                bad.dmax = 0.5;
+                                break;
+                        case 4:
+                                bad.cratio = 1.5;
+                                break;
+                        case 5:
+                                bad.hifraction = -0.1;
+                                break;
+                        case 6:
+                                bad.hifactor = 0.5;
+                                break;
+                        case 7:
+                                bad.hiprob = 2.0f;
+                                break;
+                        case 8:
+                                bad.beta = -1.0f;
+                                break;
+                }
+                assert_non_null(gen_check(&bad));
+        }
+
+        // Utilizations in [0, 1] with the requested sum
+        rnd_pcg_t pcg;
+        rnd_pcg_seed(&pcg, 5);
+        double u[50];
+        gen_method const methods[] = {GEN_UUNIFAST, GEN_RANDFIXEDSUM};
+        double const sums[] = {0.7, 1.9, 42.5};
+        for (int m = 0; m < 2; m++) {
+                // UUniFast mostly discards sums close to the number of tasks
+                for (int s = 0; s < (methods[m] == GEN_UUNIFAST ? 2 : 3);
+                     s++) {
+                        assert_true(gen_utilizations(&pcg, methods[m], 50,
+                                                     sums[s], u));
+                        double sum = 0.0;
+                        for (int i = 0; i < 50; i++) {
+                                assert_true(u[i] >= 0.0 && u[i] <= 1.0);
+                                sum += u[i];
+                        }
+                        assert_true(fabs(sum - sums[s]) < 1e-9);
+                }
+        }
+        // Only UUniFast gives up, almost surely for two tasks summing to two
+        assert_false(gen_utilizations(&pcg, GEN_UUNIFAST, 2, 2.0, u));
+        assert_true(gen_utilizations(&pcg, GEN_RANDFIXEDSUM, 2, 2.0, u));
+        assert_true(u[0] == 1.0 && u[1] == 1.0);
+
+        // Written task systems are read back and reproducible by seed
+        gen_config hi = c;
+        hi.n = 200;
+        hi.utilization = 0.9;
+        hi.method = GEN_RANDFIXEDSUM;
+        hi.periods = GEN_HARMONIC;
+        hi.pmin = 1000;
+        hi.pmax = 64000;
+        hi.dmin = 0.5;
+        hi.cratio = 0.5;
+        hi.hifraction = 0.5;
+        hi.hiprob = 0.1f;
+        hi.beta = 0.2f;
+        gen_config const* configs[] = {&c, &hi};
+        for (int k = 0; k < 2; k++) {
+                char* text[2];
+                for (int r = 0; r < 2; r++) {
+                        FILE* stream = tmpfile();
+                        assert_non_null(stream);
+                        double util = gen_write_json(configs[k], stream);
+                        assert_true(util > 0.0);
+                        long len = ftell(stream);
+                        rewind(stream);
+                        text[r] = calloc(len + 1, 1);
+                        assert_int_equal(len, fread(text[r], 1, len, stream));
+                        rewind(stream);
+                        ts* tsy = ts_init();
+                        ts_read_json(tsy, stream);
+                        fclose(stream);
+                        assert_int_equal(configs[k]->n, ts_length(tsy));
+                        assert_null(ts_check(tsy));
+                        ts_params const* p = ts_get_params(tsy);
+                        double sum = 0.0;
+                        for (int i = 0; i < p->n; i++) {
+                                assert_true(p->periods[i] >= configs[k]->pmin);
+                                assert_true(p->periods[i] <= configs[k]->pmax);
+                                assert_true(p->reldeads[i] <= p->periods[i]);
+                                sum += (double)p->comp[1][i] / p->periods[i];
+                        }
+                        assert_true(fabs(sum - util) < 1e-6);
+                        ts_free(tsy);
+                }
+                assert_string_equal(text[0], text[1]);
+                free(text[0]);
+                free(text[1]);
+        }
+        FILE* stream = tmpfile();
+        assert_true(fabs(gen_write_json(&hi, stream) - 0.9) < 0.01);
+        rewind(stream);
+
+        gen_config fail = c;
+        fail.n = 2;
+        fail.utilization = 2.0;
+        assert_true(gen_write_json(&fail, stream) < 0.0);
+        fclose(stream);
+}
+
+static void test_eventloop_pertask_equals_heap() {
+        ts* tsy = ts_init();
+        FILE* stream = fopen("test/ts-edfok.json", "r");
+        assert_non_null(stream);
+        ts_read_json(tsy, stream);
+        fclose(stream);
+
+        jobgen* jgh = jobgen_init(tsy, 42, true, JOBGEN_ARRAY,
+                                  JOBGEN_RNG_SHARED);
+        jobgen* jgp = jobgen_init(tsy, 42, true, JOBGEN_ARRAY,
+                                  JOBGEN_RNG_SHARED);
+        eventloop* heap = eventloop_init(jgh, true, false, JOBQ_HEAP);
+        eventloop* pertask = eventloop_init(jgp, true, false, JOBQ_PERTASK);
+        for (JOB_INT t = 1000; t < 10000; t += 1000) {
+                assert_int_equal(eventloop_run(heap, t, 1, false),
+                                 eventloop_run(pertask, t, 1, false));
+                assert_int_equal(eventloop_get_now(heap),
+                                 eventloop_get_now(pertask));
+        }
+        assert_true(eventloop_get_maxready(heap) > 1);
+        assert_int_equal(eventloop_get_maxready(heap),
+                         eventloop_get_maxready(pertask));
+        FILE* dh = tmpfile();
+        FILE* dp = tmpfile();
+        eventloop_dump(heap, dh);
+        eventloop_dump(pertask, dp);
+        assert_streams_equal(dh, dp);
+        fclose(dh);
+        fclose(dp);
+
+        eventloop_free(heap);
+        eventloop_free(pertask);
+        jobgen_free(jgh);
+        jobgen_free(jgp);
+        ts_free(tsy);
+}
+
 static void test_eventloop_breakable(void** state) {
         struct eventloopstate* s = *state;
 
@@ -415,6 +1450,30 @@ static void test_job_allocate_ok() {
         job_free(j);
 }
 
+static void test_job_recycled() {
+        job* j = job_init(1, 3, 4, 5, 6);
+        job_free(j);
+        job* k = job_init(2, 3, 4, 5, 6);
+        assert_ptr_equal(j, k);
+        assert_int_equal(2, job_get_taskid(k));
+        job_free(k);
+}
+
+static void test_job_many_allocate_ok() {
+        /* Span several chunks of the job pool */
+        int n = 3 * JOB_POOL_CHUNKSIZE / (5 * sizeof(JOB_INT));
+        job** js = calloc(n, sizeof(job*));
+        assert_non_null(js);
+        for (int i = 0; i < n; i++) {
+                js[i] = job_init(i, i, i, i, i);
+        }
+        for (int i = 0; i < n; i++) {
+                assert_int_equal(i, job_get_taskid(js[i]));
+                job_free(js[i]);
+        }
+        free(js);
+}
+
 int setup_job(void** state) {
         job* j = job_init(1, 3, 6, 4, 5);
         *state = j;
@@ -438,6 +1497,9 @@ static void test_job_modifyable(void** state) {
         job* j = *state;
         job_set_computation(j, 26);
         assert_int_equal(26, job_get_computation(j));
+        assert_int_equal(-1, job_get_taskpos(j));
+        job_set_taskpos(j, 2);
+        assert_int_equal(2, job_get_taskpos(j));
 }
 
 struct jobgenstate {
@@ -461,7 +1523,8 @@ int setup_jobgen(void** state) {
                 return 1;
         }
 
-        s->jg = jobgen_init(s->tsy, 12312, true);
+        s->jg = jobgen_init(s->tsy, 12312, true, JOBGEN_ARRAY,
+                            JOBGEN_RNG_SHARED);
 
         *state = s;
         return 0;
@@ -483,7 +1546,8 @@ int setup_jobgen_deterministic(void** state) {
                 return 1;
         }
 
-        s->jg = jobgen_init(s->tsy, 978382, true);
+        s->jg = jobgen_init(s->tsy, 978382, true, JOBGEN_ARRAY,
+                            JOBGEN_RNG_SHARED);
 
         *state = s;
         return 0;
@@ -527,7 +1591,8 @@ static void test_jobgen_set_simtime(void** state) {
         struct jobgenstate* s = *state;
 
         jobgen_free(s->jg);
-        s->jg = jobgen_init(s->tsy, 129371, false);
+        s->jg = jobgen_init(s->tsy, 129371, false, JOBGEN_ARRAY,
+                            JOBGEN_RNG_SHARED);
         JOB_INT simtime = 9001;
         jobgen_set_simtime(s->jg, &simtime, 1);
         jobgen_refill_all(s->jg);
@@ -596,7 +1661,8 @@ static void test_jobgen_refill_all_equals_init(void** state) {
         ts_read_json(tsy, stream);
         fclose(stream);
 
-        jobgen* s = jobgen_init(tsy, 12312, false);
+        jobgen* s = jobgen_init(tsy, 12312, false, JOBGEN_ARRAY,
+                                JOBGEN_RNG_SHARED);
         jobgen_refill_all(s);
         // TODO: Test that both states are equal, maybe can get away with
         // comparing memory range?
@@ -612,6 +1678,217 @@ static void test_jobgen_refill_all_equals_init(void** state) {
         jobgen_free(s);
 }
 
+static void assert_jobgen_equal(jobgen* a, jobgen* b, int n) {
+        for (int i = 0; i < n; i++) {
+                job* ja = jobgen_rise(a);
+                job* jb = jobgen_rise(b);
+                assert_int_equal(job_get_taskid(ja), job_get_taskid(jb));
+                assert_int_equal(job_get_starttime(ja), job_get_starttime(jb));
+                assert_int_equal(job_get_computation(ja),
+                                 job_get_computation(jb));
+                job_free(ja);
+                job_free(jb);
+        }
+        void** da = (void*)0;
+        void** db = (void*)0;
+        int len = jobgen_dump(a, &da);
+        assert_int_equal(len, jobgen_dump(b, &db));
+        for (int i = 0; i < len; i++) {
+                assert_int_equal(job_get_taskid(da[i]), job_get_taskid(db[i]));
+                assert_int_equal(job_get_starttime(da[i]),
+                                 job_get_starttime(db[i]));
+        }
+        free(da);
+        free(db);
+}
+
+static void test_jobgen_queues_equal(void** state) {
+        struct jobgenstate* s = *state;
+        jobgen* heap = jobgen_init(s->tsy, 12312, true, JOBGEN_HEAP,
+                                   JOBGEN_RNG_SHARED);
+        assert_jobgen_equal(s->jg, heap, 1000);
+        jobgen_free(heap);
+
+        heap = jobgen_init(s->tsy, 12312, true, JOBGEN_HEAP, JOBGEN_RNG_SHARED);
+        jobgen* cal = jobgen_init(s->tsy, 12312, true, JOBGEN_CALENDAR,
+                                  JOBGEN_RNG_SHARED);
+        assert_jobgen_equal(heap, cal, 1000);
+        jobgen_free(heap);
+
+        jobgen_replace_jobq(s->jg, jobq_init());
+        assert_null(jobgen_rise(s->jg));
+        jobgen_replace_jobq(cal, jobq_init());
+        assert_null(jobgen_rise(cal));
+        jobgen_free(cal);
+}
+
+static void test_jobgen_array_many_tasks() {
+        // More tasks than JOBGEN_SCAN_MAX, with equal arrivals
+        int const n = 2 * JOBGEN_SCAN_MAX + 100;
+        FILE* stream = tmpfile();
+        assert_non_null(stream);
+        fprintf(stream, "[\n");
+        for (int k = 0; k < n; k++) {
+                fprintf(stream, "[%d, %d, %d, 1,2, 0,0, 0,0, 1.0, 0.0, %s]%s\n",
+                        1000 - 3 * k, 10 + k % 7, 10 + k % 7,
+                        k % 2 ? "0.5" : "1000.0",
+                        k + 1 < n ? "," : "");
+        }
+        fprintf(stream, "]\n");
+        rewind(stream);
+        ts* tsy = ts_init();
+        ts_read_json(tsy, stream);
+        fclose(stream);
+        assert_int_equal(n, ts_length(tsy));
+
+        jobgen* array = jobgen_init(tsy, 7, true, JOBGEN_ARRAY,
+                                    JOBGEN_RNG_SHARED);
+        jobgen* heap = jobgen_init(tsy, 7, true, JOBGEN_HEAP,
+                                   JOBGEN_RNG_SHARED);
+        assert_jobgen_equal(array, heap, 100000);
+        jobgen_free(array);
+        jobgen_free(heap);
+        ts_free(tsy);
+}
+
+static void test_stats_fill_kernels() {
+        rnd_pcg_t a;
+        rnd_pcg_t b;
+        rnd_pcg_t* pa = &a;
+        rnd_pcg_t* pb = &b;
+        rnd_pcg_seed(pa, 5);
+        rnd_pcg_seed(pb, 5);
+        float u[100];
+        uniformf_fill(&pa, u, 100);
+        for (int i = 0; i < 100; i++) {
+                assert_true(u[i] == uniformf(&pb, 0.0f, 1.0f));
+        }
+
+        float e[100];
+        exponential_fill(u, 3.5f, e, 100);
+        for (int i = 0; i < 100; i++) {
+                float expect = -logf(1.0f - u[i]) * 3.5f;
+                assert_true(fabsf(e[i] - expect) <= 1e-6f * (1.0f + expect));
+        }
+
+        float bounds[] = {1.0f, 2.0f, 10.0f, 20.0f, 100.0f, 200.0f};
+        float c[99];
+        uniform3_fill(u, u + 1, 0.5f, 0.3f, bounds, c, 99);
+        for (int i = 0; i < 99; i++) {
+                int segment = u[i] > 0.8f ? 2 : u[i] > 0.5f ? 1 : 0;
+                assert_true(c[i] >= bounds[2 * segment]);
+                assert_true(c[i] <= bounds[2 * segment + 1]);
+        }
+}
+
+static void test_stats_counter_based() {
+        // Known answers of Philox4x32-10 from Random123
+        uint32_t ctr[4] = {0, 0, 0, 0};
+        uint32_t key[2] = {0, 0};
+        stats_philox(ctr, key);
+        assert_int_equal(0x6627e8d5, ctr[0]);
+        assert_int_equal(0xe169c58d, ctr[1]);
+        assert_int_equal(0xbc57ac4c, ctr[2]);
+        assert_int_equal(0x9b00dbd8, ctr[3]);
+        uint32_t pi[4] = {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344};
+        uint32_t pikey[2] = {0xa4093822, 0x299f31d0};
+        stats_philox(pi, pikey);
+        assert_int_equal(0xd16cfe09, pi[0]);
+        assert_int_equal(0x94fdcceb, pi[1]);
+        assert_int_equal(0x5001e420, pi[2]);
+        assert_int_equal(0x24126ea1, pi[3]);
+
+        rnd_pcg_t a;
+        rnd_pcg_t b;
+        stats_seed_stream(&a, 9, 3);
+        stats_seed_stream(&b, 9, 3);
+        for (int i = 0; i < 1000; i++) {
+                rnd_pcg_next(&a);
+        }
+        stats_pcg_advance(&b, 1000);
+        assert_int_equal(rnd_pcg_next(&a), rnd_pcg_next(&b));
+}
+
+static void test_jobgen_seek(void** state) {
+        struct jobgenstate* s = *state;
+        int const n = 2 * JOBGEN_BATCH + 8;
+        int const m = JOBGEN_BATCH + 5;
+        int pos = ts_get_pos_by_id(s->tsy, 3);
+        jobgen_rng rngs[] = {JOBGEN_RNG_BATCH, JOBGEN_RNG_COUNTER};
+        for (int r = 0; r < 2; r++) {
+                JOB_INT start[2 * JOBGEN_BATCH + 8];
+                JOB_INT comp[2 * JOBGEN_BATCH + 8];
+                jobgen* jg = jobgen_init(s->tsy, 77, true, JOBGEN_ARRAY,
+                                         rngs[r]);
+                for (int i = 0; i < n;) {
+                        job* j = jobgen_rise(jg);
+                        if (job_get_taskid(j) == 3) {
+                                start[i] = job_get_starttime(j);
+                                comp[i++] = job_get_computation(j);
+                        }
+                        job_free(j);
+                }
+                assert_true(jobgen_get_jobcount(jg, pos) >= (uint64_t)n);
+                jobgen_free(jg);
+
+                // Start generating at job m of task 3
+                JOB_INT simtimes[3] = {0, 0, 0};
+                uint64_t counts[3] = {0, 0, 0};
+                simtimes[pos] = start[m];
+                counts[pos] = m;
+                jg = jobgen_init(s->tsy, 77, false, JOBGEN_ARRAY, rngs[r]);
+                jobgen_set_simtime(jg, simtimes, 3);
+                jobgen_set_jobcount(jg, counts, 3);
+                jobgen_refill_all(jg);
+                for (int i = m; i < n;) {
+                        job* j = jobgen_rise(jg);
+                        if (job_get_taskid(j) == 3) {
+                                assert_int_equal(start[i],
+                                                 job_get_starttime(j));
+                                assert_int_equal(comp[i++],
+                                                 job_get_computation(j));
+                        }
+                        job_free(j);
+                }
+                jobgen_free(jg);
+        }
+}
+
+static void test_jobgen_batch_per_task(void** state) {
+        struct jobgenstate* s = *state;
+        // Jobs of task 3 of the task system on its own
+        FILE* stream = tmpfile();
+        assert_non_null(stream);
+        fprintf(stream, "[[3, 12, 12, 1,1, 2,9, 0,0, 0.5, 0.5, 92.7]]\n");
+        rewind(stream);
+        ts* single = ts_init();
+        ts_read_json(single, stream);
+        fclose(stream);
+
+        jobgen* all = jobgen_init(s->tsy, 12312, true, JOBGEN_ARRAY,
+                                  JOBGEN_RNG_BATCH);
+        jobgen* one = jobgen_init(single, 12312, true, JOBGEN_HEAP,
+                                  JOBGEN_RNG_BATCH);
+        for (int i = 0; i < 3 * JOBGEN_BATCH;) {
+                job* j = jobgen_rise(all);
+                if (job_get_taskid(j) == 3) {
+                        job* k = jobgen_rise(one);
+                        assert_int_equal(job_get_starttime(j),
+                                         job_get_starttime(k));
+                        assert_int_equal(job_get_computation(j),
+                                         job_get_computation(k));
+                        assert_int_equal(job_get_deadline(j),
+                                         job_get_deadline(k));
+                        job_free(k);
+                        i++;
+                }
+                job_free(j);
+        }
+        jobgen_free(all);
+        jobgen_free(one);
+        ts_free(single);
+}
+
 static void test_jobgen_dump_valid(void** state) {
         struct jobgenstate* s = *state;
         void** dump = (void*)0;
@@ -716,6 +1993,199 @@ static void test_jobq_dump_not_null(void** state) {
         free(dump);
 }
 
+#ifndef JOBQ_PQUEUE
+static void test_jobq_equal_priority_fifo() {
+        jobq* jq = jobq_init();
+        for (int i = 0; i < 100; i++) {
+                jobq_insert_by(jq, job_init(i, i % 3, 0, 0, 0),
+                               job_get_starttime);
+        }
+        JOB_INT last_starttime = 0;
+        JOB_INT last_taskid = -1;
+        job* j;
+        while ((j = jobq_pop(jq))) {
+                if (job_get_starttime(j) == last_starttime) {
+                        assert_true(job_get_taskid(j) > last_taskid);
+                } else {
+                        assert_true(job_get_starttime(j) > last_starttime);
+                }
+                last_starttime = job_get_starttime(j);
+                last_taskid = job_get_taskid(j);
+                job_free(j);
+        }
+        jobq_free(jq);
+}
+#endif
+
+static void test_jobq_growing_ordered() {
+        jobq* jq = jobq_init();
+        int n = 10000;
+        for (int i = 0; i < n; i++) {
+                JOB_INT deadline = (i * 7919) % n;
+                jobq_insert_by(jq, job_init(0, 0, 0, deadline, 0),
+                               job_get_deadline);
+        }
+        void** dump = (void*)0;
+        int len = jobq_dump(jq, &dump);
+        assert_int_equal(n, len);
+        for (int i = 0; i < n; i++) {
+                job* j = jobq_pop(jq);
+                assert_int_equal(i, job_get_deadline(j));
+                assert_ptr_equal(j, *(dump + i));
+                job_free(j);
+        }
+        assert_null(jobq_peek(jq));
+        free(dump);
+        jobq_free(jq);
+}
+
+static void test_jobq_load_equals_insert() {
+        jobq* inserted = jobq_init();
+        jobq* loaded = jobq_init();
+        jobq_insert_by(loaded, job_init(-1, 50, 0, 0, 0), job_get_starttime);
+        jobq_insert_by(inserted, job_init(-1, 50, 0, 0, 0), job_get_starttime);
+        int n = 1000;
+        job** jobs = calloc(n, sizeof(job*));
+        assert_non_null(jobs);
+        for (int i = 0; i < n; i++) {
+                JOB_INT starttime = (i * 7919) % 101;  // many equal
+                jobs[i] = job_init(i, starttime, 0, 0, 0);
+                jobq_insert_by(inserted, job_init(i, starttime, 0, 0, 0),
+                               job_get_starttime);
+        }
+        jobq_load_by(loaded, jobs, n, job_get_starttime);
+        free(jobs);
+        assert_int_equal(n + 1, jobq_length(loaded));
+        assert_int_equal(n + 1, jobq_peak(inserted));
+        for (int i = 0; i <= n; i++) {
+                job* a = jobq_pop(inserted);
+                job* b = jobq_pop(loaded);
+                assert_int_equal(job_get_taskid(a), job_get_taskid(b));
+                job_free(a);
+                job_free(b);
+        }
+        assert_null(jobq_pop(loaded));
+        assert_int_equal(0, jobq_length(loaded));
+        assert_int_equal(n + 1, jobq_peak(loaded));
+        jobq_free(inserted);
+        jobq_free(loaded);
+}
+
+static void test_jobq_pertask_equals_heap() {
+        ts* tsy = ts_init();
+        FILE* stream = fopen("test/ts.json", "r");
+        assert_non_null(stream);
+        ts_read_json(tsy, stream);
+        fclose(stream);
+
+        jobq* heap = jobq_init_as(JOBQ_HEAP, NULL);
+        jobq* pertask = jobq_init_as(JOBQ_PERTASK, tsy);
+        assert_null(jobq_peek(pertask));
+        assert_null(jobq_pop(pertask));
+        TASK_INT ids[] = {5, 3, -1};
+        for (int i = 0; i < 300; i++) {
+                /* Mostly ascending deadlines per task with some stragglers */
+                JOB_INT deadline = (i % 7 == 6) ? i / 2 : i;
+                TASK_INT id = ids[(i * 5) % 3];
+                jobq_insert_by(heap, job_init(id, i, 0, deadline, 0),
+                               job_get_deadline);
+                jobq_insert_by(pertask, job_init(id, i, 0, deadline, 0),
+                               job_get_deadline);
+        }
+        void** dump = (void*)0;
+        int len = jobq_dump(pertask, &dump);
+        assert_int_equal(300, len);
+        for (int i = 0; i < len; i++) {
+                job* h = jobq_pop(heap);
+                assert_ptr_equal(jobq_peek(pertask), *(dump + i));
+                job* p = jobq_pop(pertask);
+                assert_int_equal(job_get_deadline(h), job_get_deadline(p));
+                assert_int_equal(job_get_starttime(h), job_get_starttime(p));
+                job_free(h);
+                job_free(p);
+        }
+        assert_null(jobq_pop(pertask));
+        free(dump);
+
+        jobq_insert_by(pertask, job_init(3, 0, 0, 0, 0), job_get_deadline);
+        jobq_free(pertask);
+        jobq_free(heap);
+        ts_free(tsy);
+}
+
+static void test_jobq_calendar_equals_heap() {
+        jobq* heap = jobq_init_as(JOBQ_HEAP, NULL);
+        jobq* calendar = jobq_init_as(JOBQ_CALENDAR, NULL);
+        assert_null(jobq_peek(calendar));
+        assert_null(jobq_pop(calendar));
+        JOB_INT now = -50;
+        for (int i = 0; i < 5000; i++) {
+                /* Hold model with occasional early inserts and bursts */
+                JOB_INT t = now + (i * 7919) % 97;
+                if (i % 13 == 0) {
+                        t = now - 100;
+                }
+                int n = (i % 500 < 250) ? 2 : 1;
+                for (int k = 0; k < n; k++) {
+                        jobq_insert_by(heap, job_init(i, t, 0, 0, 0),
+                                       job_get_starttime);
+                        jobq_insert_by(calendar, job_init(i, t, 0, 0, 0),
+                                       job_get_starttime);
+                }
+                job* h = jobq_pop(heap);
+                assert_int_equal(job_get_taskid(h),
+                                 job_get_taskid(jobq_peek(calendar)));
+                job* c = jobq_pop(calendar);
+                assert_int_equal(job_get_starttime(h), job_get_starttime(c));
+                now = job_get_starttime(h);
+                job_free(h);
+                job_free(c);
+        }
+        void** dump = (void*)0;
+        int len = jobq_dump(calendar, &dump);
+        job* h;
+        for (int i = 0; i < len; i++) {
+                h = jobq_pop(heap);
+                job* c = jobq_pop(calendar);
+                assert_ptr_equal(c, *(dump + i));
+                assert_int_equal(job_get_taskid(h), job_get_taskid(c));
+                job_free(h);
+                job_free(c);
+        }
+        assert_null(jobq_pop(heap));
+        assert_null(jobq_pop(calendar));
+        free(dump);
+
+        jobq_insert_by(calendar, job_init(3, 0, 0, 0, 0), job_get_deadline);
+        jobq_free(calendar);
+        jobq_free(heap);
+}
+
+static void test_tourn_winner() {
+        tourn* tt = tourn_init(5);
+        assert_int_equal(-1, tourn_winner(tt));
+        tourn_update(tt, 3, 10, 0);
+        assert_int_equal(3, tourn_winner(tt));
+        tourn_update(tt, 1, 10, 1);
+        assert_int_equal(3, tourn_winner(tt));
+        tourn_update(tt, 4, 9, 2);
+        assert_int_equal(4, tourn_winner(tt));
+        tourn_clear(tt, 4);
+        assert_int_equal(3, tourn_winner(tt));
+        tourn_update(tt, 3, 11, 3);
+        assert_int_equal(1, tourn_winner(tt));
+        tourn_clear(tt, 1);
+        tourn_clear(tt, 3);
+        assert_int_equal(-1, tourn_winner(tt));
+        tourn_free(tt);
+
+        tt = tourn_init(1);
+        assert_int_equal(-1, tourn_winner(tt));
+        tourn_update(tt, 0, -4, 0);
+        assert_int_equal(0, tourn_winner(tt));
+        tourn_free(tt);
+}
+
 static void test_task_allocate_ok() {
         task* t = task_init(5);
         assert_non_null(t);
@@ -802,6 +2272,58 @@ static void test_ts_read_json_valid(void** state) {
         assert_int_equal(1, task_get_comp(t, 1));
         assert_int_equal(2, task_get_comp(t, 2));
         assert_int_equal(9, task_get_comp(t, 3));
+
+        assert_int_equal(0, ts_get_pos_by_id(tsy, 5));
+        assert_int_equal(1, ts_get_pos_by_id(tsy, 3));
+        assert_int_equal(2, ts_get_pos_by_id(tsy, -1));
+
+        ts_params const* p = ts_get_params(tsy);
+        assert_int_equal(3, p->n);
+        assert_int_equal(0, (uintptr_t)p->periods % 64);
+        assert_int_equal(0, (uintptr_t)p->comp[5] % 64);
+        for (int k = 0; k < p->n; k++) {
+                t = ts_get_by_pos(tsy, k);
+                assert_int_equal(task_get_id(t), p->ids[k]);
+                assert_int_equal(task_get_period(t), p->periods[k]);
+                assert_int_equal(task_get_reldead(t), p->reldeads[k]);
+                for (int i = 0; i < TASK_NUM_COMP; i++) {
+                        assert_int_equal(task_get_comp(t, i), p->comp[i][k]);
+                }
+                for (int i = 0; i < TASK_NUM_PROB; i++) {
+                        assert_true(task_get_prob(t, i) == p->prob[i][k]);
+                }
+                assert_true(task_get_beta(t) == p->beta[k]);
+        }
+}
+
+static void test_ts_sparse_ids() {
+        // Ids too sparse for a direct table are looked up by hashing
+        TASK_INT ids[] = {-4000000000, -1, 0, 7, 1 << 20, 3000000000};
+        int n = sizeof(ids) / sizeof(ids[0]);
+        FILE* stream = tmpfile();
+        assert_non_null(stream);
+        fprintf(stream, "[\n");
+        for (int k = 0; k < n; k++) {
+                fprintf(stream, "[%" PRId64 ", %d, 10, ", (int64_t)ids[k],
+                        10 + k);
+                fprintf(stream, "1,1, 0,0, 0,0, 1.0,0.0, 1.0]%s\n",
+                        k + 1 < n ? "," : "");
+        }
+        fprintf(stream, "]\n");
+        rewind(stream);
+        ts* tsy = ts_init();
+        ts_read_json(tsy, stream);
+        fclose(stream);
+
+        assert_int_equal(n, ts_length(tsy));
+        for (int k = 0; k < n; k++) {
+                assert_int_equal(k, ts_get_pos_by_id(tsy, ids[k]));
+                assert_int_equal(10 + k,
+                                 task_get_period(ts_get_by_id(tsy, ids[k])));
+                assert_ptr_equal(ts_get_by_pos(tsy, k),
+                                 ts_get_by_id(tsy, ids[k]));
+        }
+        ts_free(tsy);
 }
 
 int main(void) {
@@ -812,7 +2334,10 @@ int main(void) {
             cmocka_unit_test(test_ts_allocate_ok),
             cmocka_unit_test_setup_teardown(test_ts_read_json_valid, setup_ts,
                                             teardown_ts),
+            cmocka_unit_test(test_ts_sparse_ids),
             cmocka_unit_test(test_job_allocate_ok),
+            cmocka_unit_test(test_job_recycled),
+            cmocka_unit_test(test_job_many_allocate_ok),
             cmocka_unit_test_setup_teardown(test_job_readable, setup_job,
                                             teardown_job),
             cmocka_unit_test_setup_teardown(test_job_modifyable, setup_job,
@@ -837,8 +2362,17 @@ int main(void) {
                                             teardown_jobgen),
             cmocka_unit_test_setup_teardown(test_jobgen_refill_all_equals_init,
                                             setup_jobgen, teardown_jobgen),
+            cmocka_unit_test_setup_teardown(test_jobgen_queues_equal,
+                                            setup_jobgen, teardown_jobgen),
             cmocka_unit_test_setup_teardown(test_jobgen_dump_valid,
                                             setup_jobgen, teardown_jobgen),
+            cmocka_unit_test_setup_teardown(test_jobgen_batch_per_task,
+                                            setup_jobgen, teardown_jobgen),
+            cmocka_unit_test(test_stats_fill_kernels),
+            cmocka_unit_test(test_stats_counter_based),
+            cmocka_unit_test_setup_teardown(test_jobgen_seek, setup_jobgen,
+                                            teardown_jobgen),
+            cmocka_unit_test(test_jobgen_array_many_tasks),
             cmocka_unit_test(test_jobq_allocate_ok),
             cmocka_unit_test_setup_teardown(test_jobq_insertable_readable,
                                             setup_jobqstate,
@@ -851,12 +2385,16 @@ int main(void) {
                                             teardown_jobqstate),
             cmocka_unit_test_setup_teardown(
                 test_jobq_dump_not_null, setup_jobqstate, teardown_jobqstate),
-            cmocka_unit_test_setup_teardown(
-                test_dump_merge_valid, setup_dumpstate, teardown_dumpstate),
-            cmocka_unit_test_setup_teardown(
-                test_dump_uniq_valid, setup_dumpstate, teardown_dumpstate),
-            cmocka_unit_test_setup_teardown(
-                test_dump_json_tostream, setup_dumpstate, teardown_dumpstate),
+#ifndef JOBQ_PQUEUE
+            cmocka_unit_test(test_jobq_equal_priority_fifo),
+#endif
+            cmocka_unit_test(test_jobq_growing_ordered),
+            cmocka_unit_test(test_jobq_load_equals_insert),
+            cmocka_unit_test(test_jobq_pertask_equals_heap),
+            cmocka_unit_test(test_jobq_calendar_equals_heap),
+            cmocka_unit_test(test_tourn_winner),
+            cmocka_unit_test(test_dump_reader),
+            cmocka_unit_test(test_out),
             cmocka_unit_test_setup_teardown(test_eventloop_persistent,
                                             setup_eventloop_valid_edf,
                                             teardown_eventloop),
@@ -894,6 +2432,20 @@ int main(void) {
             cmocka_unit_test_setup_teardown(test_eventloop_read_json_continues,
                                             setup_eventloop_deterministic_edf,
                                             teardown_eventloop),
+            cmocka_unit_test_setup_teardown(test_eventloop_read_json_legacy,
+                                            setup_eventloop_deterministic_edf,
+                                            teardown_eventloop),
+            cmocka_unit_test(test_eventloop_resume_exact),
+            cmocka_unit_test(test_trace_replay),
+            cmocka_unit_test(test_trace_csv),
+            cmocka_unit_test(test_replicate_run),
+            cmocka_unit_test(test_sweep_run),
+            cmocka_unit_test(test_sweep_quiet),
+            cmocka_unit_test(test_thready_simulate),
+            cmocka_unit_test(test_serve_stream),
+            cmocka_unit_test(test_bench),
+            cmocka_unit_test(test_gen),
+            cmocka_unit_test(test_eventloop_pertask_equals_heap),
             cmocka_unit_test_setup_teardown(test_eventloop_breakable,
                                             setup_eventloop_valid_edf,
                                             teardown_eventloop),
@@ -0,0 +1,96 @@
+"""Checks the thready extension against the thready executable.
+
+Run by `make pythontest` with the extension and ./thready built.
+"""
+import array
+import json
+import subprocess
+
+import thready
+
+TS = "test/p41-ts-nointerarrival-0.5hi.json"
+
+with open(TS) as f:
+    text = f.read()
+rows = json.loads(text)
+
+# Columns from sequences and from buffers give the same task system
+columns = thready.TaskSystem(
+    [r[0] for r in rows],
+    [r[1] for r in rows],
+    [r[2] for r in rows],
+    [r[3:9] for r in rows],
+    [r[9:11] for r in rows],
+    [r[11] for r in rows],
+)
+buffers = thready.TaskSystem(
+    array.array("q", [r[0] for r in rows]),
+    array.array("i", [r[1] for r in rows]),
+    array.array("l", [r[2] for r in rows]),
+    array.array("q", [c for r in rows for c in r[3:9]]),
+    array.array("f", [p for r in rows for p in r[9:11]]),
+    array.array("d", [r[11] for r in rows]),
+)
+parsed = thready.TaskSystem.from_json(text)
+assert len(columns) == len(buffers) == len(parsed) == len(rows)
+
+seeds = array.array("I", range(1, 9))
+expected = subprocess.run(
+    ["./thready", "-j", TS, "-t", "100000", "-b", "-a", "-z", "1:8"],
+    check=True,
+    capture_output=True,
+    text=True,
+).stdout
+expected = [
+    line.split(",")
+    for line in expected.splitlines()
+    if line[0].isdigit()
+]
+names = ["ok", "deadlinemiss", "pass", "overrun"]
+for tsy, threads in ((columns, 1), (buffers, 3), (parsed, 0)):
+    out = thready.simulate(tsy, seeds, 100000, overrun="first",
+                           threads=threads)
+    got = [
+        [str(s), names[r], str(n), str(e), str(j)]
+        for s, r, n, e, j in zip(seeds, out["result"], out["now"],
+                                 out["events"], out["jobsdone"])
+    ]
+    assert got == expected, (got, expected)
+
+# Vectors of breaktimes, speeds and overrun handling, one per seed
+out = thready.simulate(parsed, [5, 5, 5], [1000, 2000, 3000], speed=[1, 2, 3],
+                       overrun=[0, 1, 2], rng="counter", readyq="calendar")
+for i in range(3):
+    one = thready.simulate(parsed, [5], 1000 * (i + 1), speed=i + 1,
+                           overrun=i, rng="counter", readyq="calendar")
+    for key in out:
+        assert out[key][i] == one[key][0]
+
+# Invalid input raises instead of exiting
+for bad in (
+    lambda: thready.TaskSystem.from_json("[[1,2"),
+    lambda: thready.TaskSystem([1], [0], [1], [[1, 1, 0, 0, 0, 0]],
+                               [[1.0, 0.0]], [1.0]),
+    lambda: thready.simulate(parsed, [1], 100, speed=0),
+    lambda: thready.simulate(parsed, [1, 2], [100]),
+    lambda: thready.simulate(parsed, [1], 100, rng="nope"),
+):
+    try:
+        bad()
+    except ValueError:
+        pass
+    else:
+        raise AssertionError("no error raised")
+
+# A task system is not replaced while simulations may read it
+for tsy in (columns, parsed):
+    try:
+        tsy.__init__([1], [10], [10], [[1, 1, 0, 0, 0, 0]], [[1.0, 0.0]],
+                     [0.0])
+    except RuntimeError:
+        pass
+    else:
+        raise AssertionError("no error raised")
+assert len(columns) == len(parsed) == len(rows)
+
+print("python extension ok")